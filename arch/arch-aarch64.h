@@ -13,6 +13,12 @@
 #define __NR_ioprio_get		31
 #endif
 
+#ifndef __NR_sys_io_uring_setup
+#define __NR_sys_io_uring_setup		425
+#define __NR_sys_io_uring_enter		426
+#define __NR_sys_io_uring_register	427
+#endif
+
 #define nop		do { __asm__ __volatile__ ("yield"); } while (0)
 #define read_barrier()	do { __sync_synchronize(); } while (0)
 #define write_barrier()	do { __sync_synchronize(); } while (0)
@@ -23,6 +23,12 @@
 #define __NR_sys_vmsplice	285
 #endif
 
+#ifndef __NR_sys_io_uring_setup
+#define __NR_sys_io_uring_setup		425
+#define __NR_sys_io_uring_enter		426
+#define __NR_sys_io_uring_register	427
+#endif
+
 #define nop	do { } while (0)
 
 #ifdef __powerpc64__
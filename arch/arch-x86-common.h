@@ -12,6 +12,116 @@ static inline void cpuid(unsigned int op,
 	do_cpuid(eax, ebx, ecx, edx);
 }
 
+/*
+ * Read an extended control register, XCR0 says which register state the
+ * OS saves on context switch
+ */
+static inline unsigned long long xgetbv(unsigned int index)
+{
+	unsigned int eax, edx;
+
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"
+		: "=a" (eax), "=d" (edx)
+		: "c" (index));
+
+	return ((unsigned long long) edx << 32) | eax;
+}
+
+#define XCR0_SSE	(1ULL << 1)
+#define XCR0_AVX	(1ULL << 2)
+#define XCR0_AVX512	((1ULL << 5) | (1ULL << 6) | (1ULL << 7))
+
+/*
+ * AVX2 and AVX-512 need both the CPU to have them and the OS to save the
+ * wider registers
+ */
+static inline int arch_x86_os_saves(unsigned long long mask)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1U << 27)))
+		return 0;
+
+	return (xgetbv(0) & mask) == mask;
+}
+
+static inline void arch_x86_leaf7(unsigned int *ebx, unsigned int *ecx)
+{
+	unsigned int eax, edx;
+
+	cpuid(0, &eax, ebx, ecx, &edx);
+	if (eax < 7) {
+		*ebx = *ecx = 0;
+		return;
+	}
+
+	cpuid(7, &eax, ebx, ecx, &edx);
+}
+
+static inline unsigned int arch_x86_leaf7_ebx(void)
+{
+	unsigned int ebx, ecx;
+
+	arch_x86_leaf7(&ebx, &ecx);
+	return ebx;
+}
+
+static inline unsigned int arch_x86_leaf7_ecx(void)
+{
+	unsigned int ebx, ecx;
+
+	arch_x86_leaf7(&ebx, &ecx);
+	return ecx;
+}
+
+static inline int arch_x86_have_avx2(void)
+{
+	if (!arch_x86_os_saves(XCR0_SSE | XCR0_AVX))
+		return 0;
+
+	return (arch_x86_leaf7_ebx() & (1U << 5)) != 0;
+}
+
+static inline int arch_x86_have_avx512f(void)
+{
+	if (!arch_x86_os_saves(XCR0_SSE | XCR0_AVX | XCR0_AVX512))
+		return 0;
+
+	return (arch_x86_leaf7_ebx() & (1U << 16)) != 0;
+}
+
+static inline int arch_x86_have_pclmul(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	return (ecx & (1U << 1)) && (ecx & (1U << 20));
+}
+
+static inline int arch_x86_have_vpclmul(void)
+{
+	if (!arch_x86_have_avx512f())
+		return 0;
+
+	return (arch_x86_leaf7_ecx() & (1U << 10)) != 0;
+}
+
+/*
+ * SHA extensions, plus the SSSE3 and SSE4.1 shuffles and blends used
+ * around them
+ */
+static inline int arch_x86_have_sha(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	cpuid(1, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1U << 9)) || !(ecx & (1U << 19)))
+		return 0;
+
+	return (arch_x86_leaf7_ebx() & (1U << 29)) != 0;
+}
+
 #define ARCH_HAVE_INIT
 
 extern int tsc_reliable;
@@ -67,6 +67,14 @@ extern unsigned long arch_flags;
 #include "../lib/ffz.h"
 #endif
 
+/*
+ * Ordered accessors for data handed between threads without a lock. A
+ * release store makes everything written before it visible to whoever
+ * sees the stored value through an acquire load.
+ */
+#define atomic_load_acquire(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define atomic_store_release(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
 #ifndef ARCH_HAVE_INIT
 static inline int arch_init(char *envp[])
 {
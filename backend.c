@@ -449,6 +449,9 @@ static void do_verify(struct thread_data *td, uint64_t verify_bytes)
 
 	td_set_runstate(td, TD_VERIFYING);
 
+	td->verify_sweep_file = 0;
+	td->verify_sweep_block = 0;
+
 	io_u = NULL;
 	while (!td->terminate) {
 		enum fio_ddir ddir;
@@ -665,6 +668,132 @@ static int io_bytes_exceeded(struct thread_data *td)
 	return bytes >= limit || exceeds_number_ios(td);
 }
 
+/*
+ * Get an io_u ready to be queued: hook up verification and log writes
+ * that will be verified.
+ */
+static void io_u_setup_queue(struct thread_data *td, struct io_u *io_u)
+{
+	/*
+	 * Add verification end_io handler if:
+	 *	- Asked to verify (!td_rw(td))
+	 *	- Or the io_u is from our verify list (mixed write/ver)
+	 */
+	if (td->o.verify != VERIFY_NONE && io_u->ddir == DDIR_READ &&
+	    ((io_u->flags & IO_U_F_VER_LIST) || !td_rw(td))) {
+
+		if (!td->o.verify_pattern_bytes) {
+			io_u->rand_seed = __rand(&td->__verify_state);
+			if (sizeof(int) != sizeof(long *))
+				io_u->rand_seed *= __rand(&td->__verify_state);
+		}
+
+		if (td->o.verify_async)
+			io_u->end_io = verify_io_u_async;
+		else
+			io_u->end_io = verify_io_u;
+		td_set_runstate(td, TD_VERIFYING);
+	} else if (in_ramp_time(td))
+		td_set_runstate(td, TD_RAMP);
+	else
+		td_set_runstate(td, TD_RUNNING);
+
+	/*
+	 * Always log IO before it's issued, so we know the specific
+	 * order of it. The logged unit will track when the IO has
+	 * completed. Zone appends are logged as they complete, once
+	 * their placement is known.
+	 */
+	if (td_write(td) && io_u->ddir == DDIR_WRITE &&
+	    !(io_u->flags & IO_U_F_ZONE_APPEND) &&
+	    td->o.do_verify &&
+	    td->o.verify != VERIFY_NONE &&
+	    !td->o.experimental_verify)
+		log_io_piece(td, io_u);
+}
+
+/*
+ * Handle the result of queueing an io_u. Completed io_us are accounted
+ * and put, short ones and busy ones are requeued.
+ */
+static void io_queue_event(struct thread_data *td, struct io_u *io_u,
+			   int *ret, uint64_t *bytes_issued,
+			   struct timeval *comp_time, uint64_t *bytes_done)
+{
+	int ret2;
+
+	switch (*ret) {
+	case FIO_Q_COMPLETED:
+		if (io_u->error) {
+			*ret = -io_u->error;
+			unlog_io_piece(td, io_u);
+			clear_io_u(td, io_u);
+		} else if (io_u->resid) {
+			int bytes = io_u->xfer_buflen - io_u->resid;
+			struct fio_file *f = io_u->file;
+
+			*bytes_issued += bytes;
+
+			trim_io_piece(td, io_u);
+
+			/*
+			 * zero read, fail
+			 */
+			if (!bytes) {
+				unlog_io_piece(td, io_u);
+				td_verror(td, EIO, "full resid");
+				put_io_u(td, io_u);
+				break;
+			}
+
+			io_u->xfer_buflen = io_u->resid;
+			io_u->xfer_buf += bytes;
+			io_u->offset += bytes;
+
+			if (ddir_rw(io_u->ddir))
+				td->ts.short_io_u[io_u->ddir]++;
+
+			if (io_u->offset == f->real_file_size)
+				goto sync_done;
+
+			requeue_io_u(td, &io_u);
+		} else {
+sync_done:
+			if (__should_check_rate(td, DDIR_READ) ||
+			    __should_check_rate(td, DDIR_WRITE) ||
+			    __should_check_rate(td, DDIR_TRIM))
+				fio_gettime(comp_time, NULL);
+
+			*ret = io_u_sync_complete(td, io_u, bytes_done);
+			if (*ret < 0)
+				break;
+			*bytes_issued += io_u->xfer_buflen;
+		}
+		break;
+	case FIO_Q_QUEUED:
+		/*
+		 * if the engine doesn't have a commit hook,
+		 * the io_u is really queued. if it does have such
+		 * a hook, it has to call io_u_queued() itself.
+		 */
+		if (td->io_ops->commit == NULL)
+			io_u_queued(td, io_u);
+		*bytes_issued += io_u->xfer_buflen;
+		break;
+	case FIO_Q_BUSY:
+		unlog_io_piece(td, io_u);
+		requeue_io_u(td, &io_u);
+		ret2 = td_io_commit(td);
+		if (ret2 < 0)
+			*ret = ret2;
+		break;
+	default:
+		assert(*ret < 0);
+		put_io_u(td, io_u);
+		break;
+	}
+}
+
 /*
  * Main IO worker function. It retrieves io_u's to process and queues
  * and reaps them, checking for rate and errors along the way.
@@ -674,9 +803,12 @@ static int io_bytes_exceeded(struct thread_data *td)
 static uint64_t do_io(struct thread_data *td)
 {
 	uint64_t bytes_done[DDIR_RWDIR_CNT] = { 0, 0, 0 };
-	unsigned int i;
+	struct io_u **batch_io_us = NULL;
+	int *batch_rets = NULL;
+	unsigned int i, nr;
 	int ret = 0;
 	uint64_t total_bytes, bytes_issued = 0;
+	uint64_t think_blocks = ddir_rw_sum(td->io_blocks);
 
 	if (in_ramp_time(td))
 		td_set_runstate(td, TD_RAMP);
@@ -685,6 +817,16 @@ static uint64_t do_io(struct thread_data *td)
 
 	lat_target_init(td);
 
+	if (td->o.reap_thread && reap_init(td)) {
+		td_verror(td, ENOMEM, "reap_init");
+		return 0;
+	}
+
+	if (td->io_ops->queue_batch && td->o.iodepth_batch > 1) {
+		batch_io_us = malloc(td->o.iodepth_batch * sizeof(struct io_u *));
+		batch_rets = malloc(td->o.iodepth_batch * sizeof(int));
+	}
+
 	/*
 	 * If verify_backlog is enabled, we'll run the verify in this
 	 * handler as well. For that case, we may need up to twice the
@@ -700,8 +842,8 @@ static uint64_t do_io(struct thread_data *td)
 		td->o.time_based) {
 		struct timeval comp_time;
 		int min_evts = 0;
-		struct io_u *io_u;
-		int ret2, full;
+		struct io_u *io_u, *tail = NULL;
+		int full;
 		enum fio_ddir ddir;
 
 		check_update_rusage(td);
@@ -740,116 +882,86 @@ static uint64_t do_io(struct thread_data *td)
 		}
 
 		ddir = io_u->ddir;
+		io_u_setup_queue(td, io_u);
 
 		/*
-		 * Add verification end_io handler if:
-		 *	- Asked to verify (!td_rw(td))
-		 *	- Or the io_u is from our verify list (mixed write/ver)
-		 */
-		if (td->o.verify != VERIFY_NONE && io_u->ddir == DDIR_READ &&
-		    ((io_u->flags & IO_U_F_VER_LIST) || !td_rw(td))) {
-
-			if (!td->o.verify_pattern_bytes) {
-				io_u->rand_seed = __rand(&td->__verify_state);
-				if (sizeof(int) != sizeof(long *))
-					io_u->rand_seed *= __rand(&td->__verify_state);
-			}
-
-			if (td->o.verify_async)
-				io_u->end_io = verify_io_u_async;
-			else
-				io_u->end_io = verify_io_u;
-			td_set_runstate(td, TD_VERIFYING);
-		} else if (in_ramp_time(td))
-			td_set_runstate(td, TD_RAMP);
-		else
-			td_set_runstate(td, TD_RUNNING);
-
-		/*
-		 * Always log IO before it's issued, so we know the specific
-		 * order of it. The logged unit will track when the IO has
-		 * completed.
+		 * Engines that can queue a batch get as many io_us as the
+		 * batch size allows. Anything that isn't a read or write
+		 * ends the batch, and is queued on its own after it.
 		 */
-		if (td_write(td) && io_u->ddir == DDIR_WRITE &&
-		    td->o.do_verify &&
-		    td->o.verify != VERIFY_NONE &&
-		    !td->o.experimental_verify)
-			log_io_piece(td, io_u);
-
-		ret = td_io_queue(td, io_u);
-		switch (ret) {
-		case FIO_Q_COMPLETED:
-			if (io_u->error) {
-				ret = -io_u->error;
-				unlog_io_piece(td, io_u);
-				clear_io_u(td, io_u);
-			} else if (io_u->resid) {
-				int bytes = io_u->xfer_buflen - io_u->resid;
-				struct fio_file *f = io_u->file;
-
-				bytes_issued += bytes;
-
-				trim_io_piece(td, io_u);
+		nr = 1;
+		if (batch_io_us && ddir_rw(io_u->ddir)) {
+			uint64_t batch_bytes = io_u->xfer_buflen;
+			struct io_u *next;
+
+			batch_io_us[0] = io_u;
+			while (nr < td->o.iodepth_batch &&
+			       bytes_issued + batch_bytes < total_bytes) {
+				next = get_io_u(td);
+				if (IS_ERR_OR_NULL(next))
+					break;
 
-				/*
-				 * zero read, fail
-				 */
-				if (!bytes) {
-					unlog_io_piece(td, io_u);
-					td_verror(td, EIO, "full resid");
-					put_io_u(td, io_u);
+				io_u_setup_queue(td, next);
+				if (!ddir_rw(next->ddir)) {
+					tail = next;
 					break;
 				}
+				batch_io_us[nr++] = next;
+				batch_bytes += next->xfer_buflen;
+			}
+		}
 
-				io_u->xfer_buflen = io_u->resid;
-				io_u->xfer_buf += bytes;
-				io_u->offset += bytes;
+		if (nr == 1) {
+			ret = td_io_queue(td, io_u);
+			io_queue_event(td, io_u, &ret, &bytes_issued, &comp_time,
+					bytes_done);
 
-				if (ddir_rw(io_u->ddir))
-					td->ts.short_io_u[io_u->ddir]++;
+			if (break_on_this_error(td, ddir, &ret)) {
+				if (tail)
+					put_io_u(td, tail);
+				break;
+			}
+		} else {
+			int brk = 0;
 
-				if (io_u->offset == f->real_file_size)
-					goto sync_done;
+			td_io_queue_batch(td, batch_io_us, batch_rets, nr);
 
-				requeue_io_u(td, &io_u);
-			} else {
-sync_done:
-				if (__should_check_rate(td, DDIR_READ) ||
-				    __should_check_rate(td, DDIR_WRITE) ||
-				    __should_check_rate(td, DDIR_TRIM))
-					fio_gettime(&comp_time, NULL);
-
-				ret = io_u_sync_complete(td, io_u, bytes_done);
-				if (ret < 0)
-					break;
-				bytes_issued += io_u->xfer_buflen;
-			}
-			break;
-		case FIO_Q_QUEUED:
 			/*
-			 * if the engine doesn't have a commit hook,
-			 * the io_u is really queued. if it does have such
-			 * a hook, it has to call io_u_queued() itself.
+			 * Everything in the batch was issued, so all of it
+			 * has to be handled even if we stop on an error
 			 */
-			if (td->io_ops->commit == NULL)
-				io_u_queued(td, io_u);
-			bytes_issued += io_u->xfer_buflen;
-			break;
-		case FIO_Q_BUSY:
-			unlog_io_piece(td, io_u);
-			requeue_io_u(td, &io_u);
-			ret2 = td_io_commit(td);
-			if (ret2 < 0)
-				ret = ret2;
-			break;
-		default:
-			assert(ret < 0);
-			put_io_u(td, io_u);
-			break;
+			ret = FIO_Q_COMPLETED;
+			for (i = 0; i < nr; i++) {
+				int r = batch_rets[i];
+
+				ddir = batch_io_us[i]->ddir;
+				io_queue_event(td, batch_io_us[i], &r,
+						&bytes_issued, &comp_time,
+						bytes_done);
+				if (break_on_this_error(td, ddir, &r))
+					brk = 1;
+				if (r < 0 || (ret >= 0 && r == FIO_Q_BUSY))
+					ret = r;
+			}
+			if (brk) {
+				if (tail)
+					put_io_u(td, tail);
+				break;
+			}
 		}
 
-		if (break_on_this_error(td, ddir, &ret))
-			break;
+		if (tail) {
+			int r;
+
+			ddir = tail->ddir;
+			r = td_io_queue(td, tail);
+			io_queue_event(td, tail, &r, &bytes_issued, &comp_time,
+					bytes_done);
+			if (break_on_this_error(td, ddir, &r))
+				break;
+			if (r < 0 || (ret >= 0 && r == FIO_Q_BUSY))
+				ret = r;
+		}
 
 		/*
 		 * See if we need to complete some commands. Note that we
@@ -899,11 +1011,17 @@ reap:
 		if (td->o.thinktime) {
 			unsigned long long b;
 
+			/*
+			 * A batch completes several blocks at once, so think
+			 * whenever a multiple of thinktime_blocks was passed
+			 */
 			b = ddir_rw_sum(td->io_blocks);
-			if (!(b % td->o.thinktime_blocks)) {
+			if (b / td->o.thinktime_blocks !=
+			    think_blocks / td->o.thinktime_blocks) {
 				int left;
 
 				io_u_quiesce(td);
+				think_blocks = ddir_rw_sum(td->io_blocks);
 
 				if (td->o.thinktime_spin)
 					usec_spin(td->o.thinktime_spin);
@@ -915,8 +1033,12 @@ reap:
 		}
 	}
 
+	reap_exit(td, bytes_done);
 	check_update_rusage(td);
 
+	free(batch_io_us);
+	free(batch_rets);
+
 	if (td->trim_entries)
 		log_err("fio: %lu trim entries leaked?\n", td->trim_entries);
 
@@ -961,7 +1083,7 @@ static void cleanup_io_u(struct thread_data *td)
 {
 	struct io_u *io_u;
 
-	while ((io_u = io_u_qpop(&td->io_u_freelist)) != NULL) {
+	while ((io_u = io_u_mpsc_pop(&td->io_u_freelist)) != NULL) {
 
 		if (td->io_ops->io_u_free)
 			td->io_ops->io_u_free(td, io_u);
@@ -970,9 +1092,11 @@ static void cleanup_io_u(struct thread_data *td)
 	}
 
 	free_io_mem(td);
+	free_buf_pool(td);
+	free_fill_state(td);
 
 	io_u_rexit(&td->io_u_requeues);
-	io_u_qexit(&td->io_u_freelist);
+	io_u_mpsc_exit(&td->io_u_freelist);
 	io_u_qexit(&td->io_u_all);
 }
 
@@ -995,7 +1119,7 @@ static int init_io_u(struct thread_data *td)
 
 	err = 0;
 	err += io_u_rinit(&td->io_u_requeues, td->o.iodepth);
-	err += io_u_qinit(&td->io_u_freelist, td->o.iodepth);
+	err += io_u_mpsc_init(&td->io_u_freelist, td->o.iodepth);
 	err += io_u_qinit(&td->io_u_all, td->o.iodepth);
 
 	if (err) {
@@ -1028,6 +1152,9 @@ static int init_io_u(struct thread_data *td)
 	if (data_xfer && allocate_io_mem(td))
 		return 1;
 
+	if (data_xfer && init_fill_state(td))
+		return 1;
+
 	if (td->o.odirect || td->o.mem_align || td->o.oatomic ||
 	    (td->io_ops->flags & FIO_RAWIO))
 		p = PAGE_ALIGN(td->orig_buffer) + td->o.mem_align;
@@ -1050,7 +1177,6 @@ static int init_io_u(struct thread_data *td)
 
 		io_u = ptr;
 		memset(io_u, 0, sizeof(*io_u));
-		INIT_FLIST_HEAD(&io_u->verify_list);
 		dprint(FD_MEM, "io_u alloc %p, index %u\n", io_u, i);
 
 		if (data_xfer) {
@@ -1070,7 +1196,7 @@ static int init_io_u(struct thread_data *td)
 
 		io_u->index = i;
 		io_u->flags = IO_U_F_FREE;
-		io_u_qpush(&td->io_u_freelist, io_u);
+		io_u_mpsc_push(&td->io_u_freelist, io_u);
 
 		/*
 		 * io_u never leaves this stack, used for iteration of all
@@ -1090,7 +1216,7 @@ static int init_io_u(struct thread_data *td)
 		p += max_bs;
 	}
 
-	return 0;
+	return init_buf_pool(td);
 }
 
 static int switch_ioscheduler(struct thread_data *td)
@@ -1240,6 +1366,7 @@ static uint64_t do_dry_run(struct thread_data *td)
 		}
 
 		if (td_write(td) && io_u->ddir == DDIR_WRITE &&
+		    !(io_u->flags & IO_U_F_ZONE_APPEND) &&
 		    td->o.do_verify &&
 		    td->o.verify != VERIFY_NONE &&
 		    !td->o.experimental_verify)
@@ -1280,14 +1407,12 @@ static void *thread_main(void *data)
 
 	INIT_FLIST_HEAD(&td->io_log_list);
 	INIT_FLIST_HEAD(&td->io_hist_list);
-	INIT_FLIST_HEAD(&td->verify_list);
 	INIT_FLIST_HEAD(&td->trim_list);
 	INIT_FLIST_HEAD(&td->next_rand_list);
 	pthread_mutex_init(&td->io_u_lock, NULL);
 	td->io_hist_tree = RB_ROOT;
 
 	pthread_condattr_init(&attr);
-	pthread_cond_init(&td->verify_cond, &attr);
 	pthread_cond_init(&td->free_cond, &attr);
 
 	td_set_runstate(td, TD_INITIALIZED);
@@ -1447,7 +1572,8 @@ static void *thread_main(void *data)
 	if (td->flags & TD_F_COMPRESS_LOG)
 		tp_init(&td->tp_data);
 
-	fio_verify_init(td);
+	if (fio_verify_init(td))
+		goto err;
 
 	fio_gettime(&td->epoch, NULL);
 	fio_getrusage(&td->ru_start);
@@ -1475,6 +1601,12 @@ static void *thread_main(void *data)
 
 		prune_io_piece_log(td);
 
+		/*
+		 * Writes are tagged with the loop they're done in, for
+		 * verify_history=loop and map
+		 */
+		td->verify_gen++;
+
 		if (td->o.verify_only && (td_write(td) || td_rw(td)))
 			verify_bytes = do_dry_run(td);
 		else
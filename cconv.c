@@ -79,6 +79,7 @@ void convert_thread_options_to_cpu(struct thread_options *o,
 	o->iodepth_low = le32_to_cpu(top->iodepth_low);
 	o->iodepth_batch = le32_to_cpu(top->iodepth_batch);
 	o->iodepth_batch_complete = le32_to_cpu(top->iodepth_batch_complete);
+	o->reap_thread = le32_to_cpu(top->reap_thread);
 	o->size = le64_to_cpu(top->size);
 	o->io_limit = le64_to_cpu(top->io_limit);
 	o->size_percent = le32_to_cpu(top->size_percent);
@@ -131,6 +132,7 @@ void convert_thread_options_to_cpu(struct thread_options *o,
 	o->verifysort = le32_to_cpu(top->verifysort);
 	o->verifysort_nr = le32_to_cpu(top->verifysort_nr);
 	o->experimental_verify = le32_to_cpu(top->experimental_verify);
+	o->verify_history = le32_to_cpu(top->verify_history);
 	o->verify_interval = le32_to_cpu(top->verify_interval);
 	o->verify_offset = le32_to_cpu(top->verify_offset);
 
@@ -163,6 +165,7 @@ void convert_thread_options_to_cpu(struct thread_options *o,
 	o->zipf_theta.u.f = fio_uint64_to_double(le64_to_cpu(top->zipf_theta.u.i));
 	o->pareto_h.u.f = fio_uint64_to_double(le64_to_cpu(top->pareto_h.u.i));
 	o->random_generator = le32_to_cpu(top->random_generator);
+	o->offset_prefetch = le32_to_cpu(top->offset_prefetch);
 	o->hugepage_size = le32_to_cpu(top->hugepage_size);
 	o->rw_min_bs = le32_to_cpu(top->rw_min_bs);
 	o->thinktime = le32_to_cpu(top->thinktime);
@@ -180,6 +183,9 @@ void convert_thread_options_to_cpu(struct thread_options *o,
 	o->zone_range = le64_to_cpu(top->zone_range);
 	o->zone_size = le64_to_cpu(top->zone_size);
 	o->zone_skip = le64_to_cpu(top->zone_skip);
+	o->zone_mode = le32_to_cpu(top->zone_mode);
+	o->max_open_zones = le32_to_cpu(top->max_open_zones);
+	o->zone_append = le32_to_cpu(top->zone_append);
 	o->lockmem = le64_to_cpu(top->lockmem);
 	o->offset_increment = le64_to_cpu(top->offset_increment);
 	o->number_ios = le64_to_cpu(top->number_ios);
@@ -239,8 +245,18 @@ void convert_thread_options_to_cpu(struct thread_options *o,
 	o->latency_target = le64_to_cpu(top->latency_target);
 	o->latency_window = le64_to_cpu(top->latency_window);
 	o->latency_percentile.u.f = fio_uint64_to_double(le64_to_cpu(top->latency_percentile.u.i));
+	o->nvm_channels = le32_to_cpu(top->nvm_channels);
+	o->nvm_luns = le32_to_cpu(top->nvm_luns);
+	o->nvm_planes = le32_to_cpu(top->nvm_planes);
+	o->nvm_pages_per_block = le32_to_cpu(top->nvm_pages_per_block);
+	o->nvm_sectors_per_page = le32_to_cpu(top->nvm_sectors_per_page);
+	o->nvm_sector_size = le32_to_cpu(top->nvm_sector_size);
+	o->nvm_stripe_units = le32_to_cpu(top->nvm_stripe_units);
 	o->compress_percentage = le32_to_cpu(top->compress_percentage);
 	o->compress_chunk = le32_to_cpu(top->compress_chunk);
+	o->compress_calibrate = le32_to_cpu(top->compress_calibrate);
+	o->dedupe_percentage = le32_to_cpu(top->dedupe_percentage);
+	o->buffer_pool = le32_to_cpu(top->buffer_pool);
 
 	o->trim_backlog = le64_to_cpu(top->trim_backlog);
 
@@ -286,6 +302,7 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->iodepth_low = cpu_to_le32(o->iodepth_low);
 	top->iodepth_batch = cpu_to_le32(o->iodepth_batch);
 	top->iodepth_batch_complete = cpu_to_le32(o->iodepth_batch_complete);
+	top->reap_thread = cpu_to_le32(o->reap_thread);
 	top->size_percent = cpu_to_le32(o->size_percent);
 	top->fill_device = cpu_to_le32(o->fill_device);
 	top->file_append = cpu_to_le32(o->file_append);
@@ -308,6 +325,7 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->verifysort = cpu_to_le32(o->verifysort);
 	top->verifysort_nr = cpu_to_le32(o->verifysort_nr);
 	top->experimental_verify = cpu_to_le32(o->experimental_verify);
+	top->verify_history = cpu_to_le32(o->verify_history);
 	top->verify_interval = cpu_to_le32(o->verify_interval);
 	top->verify_offset = cpu_to_le32(o->verify_offset);
 	top->verify_pattern_bytes = cpu_to_le32(o->verify_pattern_bytes);
@@ -336,6 +354,7 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->zipf_theta.u.i = __cpu_to_le64(fio_double_to_uint64(o->zipf_theta.u.f));
 	top->pareto_h.u.i = __cpu_to_le64(fio_double_to_uint64(o->pareto_h.u.f));
 	top->random_generator = cpu_to_le32(o->random_generator);
+	top->offset_prefetch = cpu_to_le32(o->offset_prefetch);
 	top->hugepage_size = cpu_to_le32(o->hugepage_size);
 	top->rw_min_bs = cpu_to_le32(o->rw_min_bs);
 	top->thinktime = cpu_to_le32(o->thinktime);
@@ -399,8 +418,18 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->latency_target = __cpu_to_le64(o->latency_target);
 	top->latency_window = __cpu_to_le64(o->latency_window);
 	top->latency_percentile.u.i = __cpu_to_le64(fio_double_to_uint64(o->latency_percentile.u.f));
+	top->nvm_channels = cpu_to_le32(o->nvm_channels);
+	top->nvm_luns = cpu_to_le32(o->nvm_luns);
+	top->nvm_planes = cpu_to_le32(o->nvm_planes);
+	top->nvm_pages_per_block = cpu_to_le32(o->nvm_pages_per_block);
+	top->nvm_sectors_per_page = cpu_to_le32(o->nvm_sectors_per_page);
+	top->nvm_sector_size = cpu_to_le32(o->nvm_sector_size);
+	top->nvm_stripe_units = cpu_to_le32(o->nvm_stripe_units);
 	top->compress_percentage = cpu_to_le32(o->compress_percentage);
 	top->compress_chunk = cpu_to_le32(o->compress_chunk);
+	top->compress_calibrate = cpu_to_le32(o->compress_calibrate);
+	top->dedupe_percentage = cpu_to_le32(o->dedupe_percentage);
+	top->buffer_pool = cpu_to_le32(o->buffer_pool);
 
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
 		top->bs[i] = cpu_to_le32(o->bs[i]);
@@ -444,6 +473,9 @@ void convert_thread_options_to_net(struct thread_options_pack *top,
 	top->zone_range = __cpu_to_le64(o->zone_range);
 	top->zone_size = __cpu_to_le64(o->zone_size);
 	top->zone_skip = __cpu_to_le64(o->zone_skip);
+	top->zone_mode = cpu_to_le32(o->zone_mode);
+	top->max_open_zones = cpu_to_le32(o->max_open_zones);
+	top->zone_append = cpu_to_le32(o->zone_append);
 	top->lockmem = __cpu_to_le64(o->lockmem);
 	top->ddir_seq_add = __cpu_to_le64(o->ddir_seq_add);
 	top->file_size_low = __cpu_to_le64(o->file_size_low);
@@ -801,6 +801,39 @@ static void convert_ts(struct thread_stat *dst, struct thread_stat *src)
 	dst->latency_target	= le64_to_cpu(src->latency_target);
 	dst->latency_window	= le64_to_cpu(src->latency_window);
 	dst->latency_percentile.u.f = fio_uint64_to_double(le64_to_cpu(src->latency_percentile.u.i));
+
+	dst->nr_io_ops		= le32_to_cpu(src->nr_io_ops);
+	for (i = 0; i < FIO_IO_OP_NR; i++) {
+		convert_io_stat(&dst->io_op_clat_stat[i], &src->io_op_clat_stat[i]);
+		for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+			dst->io_op_plat[i][j] = le32_to_cpu(src->io_op_plat[i][j]);
+	}
+
+	dst->ftl_host_writes	= le64_to_cpu(src->ftl_host_writes);
+	dst->ftl_gc_writes	= le64_to_cpu(src->ftl_gc_writes);
+	dst->ftl_erases		= le64_to_cpu(src->ftl_erases);
+	dst->ftl_map_bytes	= le64_to_cpu(src->ftl_map_bytes);
+	dst->ftl_page_size	= le32_to_cpu(src->ftl_page_size);
+	convert_io_stat(&dst->ftl_gc_stat, &src->ftl_gc_stat);
+	for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+		dst->ftl_gc_plat[j] = le32_to_cpu(src->ftl_gc_plat[j]);
+
+	convert_io_stat(&dst->zone_reset_stat, &src->zone_reset_stat);
+	dst->zone_appends	= le64_to_cpu(src->zone_appends);
+	convert_io_stat(&dst->zone_append_bw_stat, &src->zone_append_bw_stat);
+
+	dst->poll_spin_reaps	= le64_to_cpu(src->poll_spin_reaps);
+	dst->poll_sleeps	= le64_to_cpu(src->poll_sleeps);
+	dst->poll_spin_usec	= le64_to_cpu(src->poll_spin_usec);
+	dst->poll_sleep_usec	= le64_to_cpu(src->poll_sleep_usec);
+
+	dst->reap_usr_time	= le64_to_cpu(src->reap_usr_time);
+	dst->reap_sys_time	= le64_to_cpu(src->reap_sys_time);
+	dst->reap_ctx		= le64_to_cpu(src->reap_ctx);
+
+	dst->verify_async_bytes	= le64_to_cpu(src->verify_async_bytes);
+	dst->verify_async_usec	= le64_to_cpu(src->verify_async_usec);
+	convert_io_stat(&dst->verify_async_wait_stat, &src->verify_async_wait_stat);
 }
 
 static void convert_gs(struct group_run_stats *dst, struct group_run_stats *src)
@@ -7,6 +7,10 @@
 #include <sys/wait.h>
 #include "crc32c.h"
 
+#if defined(CONFIG_X86_PCLMUL) || defined(CONFIG_X86_VPCLMUL)
+#include <immintrin.h>
+#endif
+
 /*
  * Based on a posting to lkml by Austin Zhang <austin.zhang@intel.com>
  *
@@ -48,19 +52,19 @@ static uint32_t crc32c_intel_le_hw_byte(uint32_t crc, unsigned char const *data,
 }
 
 /*
- * Steps through buffer one byte at at time, calculates reflected 
- * crc using table.
+ * Steps through buffer one word at a time. Each crc32 instruction has to
+ * wait for the previous one, so this is bound by its latency.
  */
-uint32_t crc32c_intel(unsigned char const *data, unsigned long length)
+static uint32_t crc32c_intel_serial(uint32_t crc, unsigned char const *data,
+				    unsigned long length)
 {
-	unsigned int iquotient = length / SCALE_F;
+	unsigned long iquotient = length / SCALE_F;
 	unsigned int iremainder = length % SCALE_F;
 #if BITS_PER_LONG == 64
 	uint64_t *ptmp = (uint64_t *) data;
 #else
 	uint32_t *ptmp = (uint32_t *) data;
 #endif
-	uint32_t crc = ~0;
 
 	while (iquotient--) {
 		__asm__ __volatile__(
@@ -78,8 +82,257 @@ uint32_t crc32c_intel(unsigned char const *data, unsigned long length)
 	return crc;
 }
 
+/*
+ * x^n mod P, bit reflected like the crc itself: bit 31 is x^0
+ */
+static uint32_t crc32c_xpow(unsigned int n)
+{
+	uint32_t p = 1U << 31;
+
+	while (n--)
+		p = (p & 1) ? (p >> 1) ^ 0x82F63B78 : p >> 1;
+
+	return p;
+}
+
+#ifdef CONFIG_X86_PCLMUL
+/*
+ * The crc32 instruction can start a new one every cycle, so three
+ * independent streams keep it busy. Each stream is stream_len bytes, and
+ * their crcs are combined by moving the first two along by the length of
+ * what follows: crc(A.B) = crc(A) * x^(8 * len(B)) + crc(B), with the
+ * multiply done by pclmul and the reduction by crc32. With both operands
+ * in the low 32 bits the product comes out multiplied by x^33, hence the
+ * constants are x^(8 * len - 33).
+ */
+#define CRC32C_STREAMS		3
+#define CRC32C_NR_STREAM_LENS	3
+
+static const unsigned int crc32c_stream_len[CRC32C_NR_STREAM_LENS] = {
+	4096, 512, 64,
+};
+static uint64_t crc32c_shift_k[CRC32C_NR_STREAM_LENS][CRC32C_STREAMS - 1];
+
+static void crc32c_3way_init(void)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < CRC32C_NR_STREAM_LENS; i++) {
+		for (j = 0; j < CRC32C_STREAMS - 1; j++) {
+			unsigned int bits = 8 * crc32c_stream_len[i] * (j + 1);
+
+			crc32c_shift_k[i][j] = crc32c_xpow(bits - 33);
+		}
+	}
+}
+
+__attribute__((target("sse4.2,pclmul")))
+static inline uint32_t crc32c_shift(uint32_t crc, uint64_t k)
+{
+	__m128i v;
+
+	v = _mm_clmulepi64_si128(_mm_cvtsi32_si128(crc), _mm_cvtsi64_si128(k),
+					0x00);
+	return _mm_crc32_u64(0, _mm_cvtsi128_si64(v));
+}
+
+__attribute__((target("sse4.2,pclmul")))
+static uint32_t crc32c_intel_3way(uint32_t crc, unsigned char const *data,
+				  unsigned long length)
+{
+	unsigned int i;
+
+	for (i = 0; i < CRC32C_NR_STREAM_LENS; i++) {
+		const unsigned int len = crc32c_stream_len[i];
+		const uint64_t k1 = crc32c_shift_k[i][0];
+		const uint64_t k2 = crc32c_shift_k[i][1];
+
+		while (length >= CRC32C_STREAMS * len) {
+			const uint64_t *a = (const uint64_t *) data;
+			const uint64_t *b = (const uint64_t *) (data + len);
+			const uint64_t *c = (const uint64_t *) (data + 2 * len);
+			uint64_t ca = crc, cb = 0, cc = 0;
+			unsigned int j;
+
+			for (j = 0; j < len / 8; j++) {
+				ca = _mm_crc32_u64(ca, a[j]);
+				cb = _mm_crc32_u64(cb, b[j]);
+				cc = _mm_crc32_u64(cc, c[j]);
+			}
+
+			crc = crc32c_shift(ca, k2) ^ crc32c_shift(cb, k1) ^ cc;
+			data += CRC32C_STREAMS * len;
+			length -= CRC32C_STREAMS * len;
+		}
+	}
+
+	return crc32c_intel_serial(crc, data, length);
+}
+
+static int crc32c_have_3way(void)
+{
+	return arch_x86_have_pclmul();
+}
+#endif
+
+#ifdef CONFIG_X86_VPCLMUL
+/*
+ * Fold 256 bytes at a time in four 512-bit registers, each 128-bit lane
+ * on its own. A lane X of high half H and low half L, F bits ahead of
+ * the data D it is folded into, becomes H * x^(F + 64) + L * x^F + D,
+ * which is the same mod P. The multiplies put the result another x^33
+ * up, as for the 3-way version, so the constants are x^(F + 31) for H
+ * and x^(F - 33) for L. What is left in the end is 64 bytes that have
+ * the crc of everything folded into them.
+ */
+#define CRC32C_FOLD_BYTES	256
+
+static uint64_t crc32c_fold_k2048[8], crc32c_fold_k512[8];
+
+static void crc32c_fold_k(uint64_t *k, unsigned int bits)
+{
+	unsigned int i;
+
+	for (i = 0; i < 8; i += 2) {
+		k[i] = crc32c_xpow(bits + 31);
+		k[i + 1] = crc32c_xpow(bits - 33);
+	}
+}
+
+static void crc32c_vpclmul_init(void)
+{
+	crc32c_fold_k(crc32c_fold_k2048, 2048);
+	crc32c_fold_k(crc32c_fold_k512, 512);
+}
+
+__attribute__((target("avx512f,vpclmulqdq")))
+static inline __m512i crc32c_fold(__m512i x, __m512i d, __m512i k)
+{
+	return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00),
+					 _mm512_clmulepi64_epi128(x, k, 0x11),
+					 d, 0x96);
+}
+
+__attribute__((target("sse4.2,avx512f,vpclmulqdq,pclmul")))
+static uint32_t crc32c_intel_vpclmul(uint32_t crc, unsigned char const *data,
+				     unsigned long length)
+{
+	__m512i x0, x1, x2, x3, k2048, k512;
+	uint64_t tail[8];
+	unsigned int i;
+
+	if (length < 2 * CRC32C_FOLD_BYTES)
+		return crc32c_intel_3way(crc, data, length);
+
+	/*
+	 * The crc so far goes into the first bytes
+	 */
+	x0 = _mm512_xor_si512(_mm512_loadu_si512(data),
+				_mm512_castsi128_si512(_mm_cvtsi32_si128(crc)));
+	x1 = _mm512_loadu_si512(data + 64);
+	x2 = _mm512_loadu_si512(data + 128);
+	x3 = _mm512_loadu_si512(data + 192);
+	data += CRC32C_FOLD_BYTES;
+	length -= CRC32C_FOLD_BYTES;
+
+	k2048 = _mm512_loadu_si512(crc32c_fold_k2048);
+	k512 = _mm512_loadu_si512(crc32c_fold_k512);
+
+	while (length >= CRC32C_FOLD_BYTES) {
+		x0 = crc32c_fold(x0, _mm512_loadu_si512(data), k2048);
+		x1 = crc32c_fold(x1, _mm512_loadu_si512(data + 64), k2048);
+		x2 = crc32c_fold(x2, _mm512_loadu_si512(data + 128), k2048);
+		x3 = crc32c_fold(x3, _mm512_loadu_si512(data + 192), k2048);
+		data += CRC32C_FOLD_BYTES;
+		length -= CRC32C_FOLD_BYTES;
+	}
+
+	x1 = crc32c_fold(x0, x1, k512);
+	x2 = crc32c_fold(x1, x2, k512);
+	x3 = crc32c_fold(x2, x3, k512);
+
+	_mm512_storeu_si512(tail, x3);
+	crc = 0;
+	for (i = 0; i < 8; i++)
+		crc = _mm_crc32_u64(crc, tail[i]);
+
+	return crc32c_intel_3way(crc, data, length);
+}
+
+static int crc32c_have_vpclmul(void)
+{
+	return arch_x86_have_vpclmul();
+}
+#endif
+
+static int crc32c_have_serial(void)
+{
+	return 1;
+}
+
+struct crc32c_impl {
+	const char *name;
+	uint32_t (*fn)(uint32_t, unsigned char const *, unsigned long);
+	int (*available)(void);
+};
+
+/*
+ * Best first
+ */
+static struct crc32c_impl crc32c_impls[] = {
+#if defined(CONFIG_X86_VPCLMUL) && defined(CONFIG_X86_PCLMUL)
+	{ "vpclmul", crc32c_intel_vpclmul, crc32c_have_vpclmul },
+#endif
+#ifdef CONFIG_X86_PCLMUL
+	{ "3way", crc32c_intel_3way, crc32c_have_3way },
+#endif
+	{ "serial", crc32c_intel_serial, crc32c_have_serial },
+	{ NULL, },
+};
+
+static struct crc32c_impl *crc32c_impl = &crc32c_impls[
+		sizeof(crc32c_impls) / sizeof(crc32c_impls[0]) - 2];
+
+uint32_t crc32c_intel(unsigned char const *data, unsigned long length)
+{
+	return crc32c_impl->fn(~0, data, length);
+}
+
+/*
+ * Name of the version in use, for the crc test
+ */
+const char *crc32c_intel_impl(void)
+{
+	return crc32c_intel_available ? crc32c_impl->name : NULL;
+}
+
+/*
+ * Use a given version instead of the best one the CPU supports. Returns 1
+ * if it isn't built in or the CPU lacks it.
+ */
+int crc32c_intel_set_impl(const char *name)
+{
+	struct crc32c_impl *impl;
+
+	if (!crc32c_intel_available)
+		return 1;
+
+	for (impl = crc32c_impls; impl->name; impl++) {
+		if (strcmp(impl->name, name))
+			continue;
+		if (!impl->available())
+			return 1;
+		crc32c_impl = impl;
+		return 0;
+	}
+
+	return 1;
+}
+
 void crc32c_intel_probe(void)
 {
+	struct crc32c_impl *impl;
+
 	if (!crc32c_probed) {
 		unsigned int eax, ebx, ecx = 0, edx;
 
@@ -87,6 +340,24 @@ void crc32c_intel_probe(void)
 
 		do_cpuid(&eax, &ebx, &ecx, &edx);
 		crc32c_intel_available = (ecx & (1 << 20)) != 0;
+
+		if (crc32c_intel_available) {
+#ifdef CONFIG_X86_PCLMUL
+			if (crc32c_have_3way())
+				crc32c_3way_init();
+#endif
+#if defined(CONFIG_X86_VPCLMUL) && defined(CONFIG_X86_PCLMUL)
+			if (crc32c_have_vpclmul())
+				crc32c_vpclmul_init();
+#endif
+			for (impl = crc32c_impls; impl->name; impl++) {
+				if (impl->available()) {
+					crc32c_impl = impl;
+					break;
+				}
+			}
+		}
+
 		crc32c_probed = 1;
 	}
 }
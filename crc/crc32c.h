@@ -26,11 +26,21 @@ extern int crc32c_intel_available;
 #ifdef ARCH_HAVE_SSE4_2
 extern uint32_t crc32c_intel(unsigned char const *, unsigned long);
 extern void crc32c_intel_probe(void);
+extern const char *crc32c_intel_impl(void);
+extern int crc32c_intel_set_impl(const char *);
 #else
 #define crc32c_intel crc32c_sw
 static inline void crc32c_intel_probe(void)
 {
 }
+static inline const char *crc32c_intel_impl(void)
+{
+	return NULL;
+}
+static inline int crc32c_intel_set_impl(const char *name)
+{
+	return 1;
+}
 #endif
 
 static inline uint32_t fio_crc32c(unsigned char const *buf, unsigned long len)
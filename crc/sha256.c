@@ -20,11 +20,20 @@
 #include <inttypes.h>
 
 #include "../lib/bswap.h"
+#include "../arch/arch.h"
 #include "sha256.h"
 
-#define SHA256_DIGEST_SIZE	32
+#if defined(CONFIG_X86_SHA) || defined(CONFIG_X86_AVX2)
+#include <immintrin.h>
+#endif
+
 #define SHA256_HMAC_BLOCK_SIZE	64
 
+/*
+ * Messages fio_sha256_multi() can take at once
+ */
+#define MB_LANES	8
+
 static inline uint32_t Ch(uint32_t x, uint32_t y, uint32_t z)
 {
 	return z ^ (x & (y ^ z));
@@ -227,6 +236,296 @@ static void sha256_transform(uint32_t *state, const uint8_t *input)
 	memset(W, 0, 64 * sizeof(uint32_t));
 }
 
+static void sha256_blocks_generic(uint32_t *state, const uint8_t *data,
+				  unsigned int nr)
+{
+	while (nr--) {
+		sha256_transform(state, data);
+		data += 64;
+	}
+}
+
+static int sha256_have_generic(void)
+{
+	return 1;
+}
+
+#if defined(CONFIG_X86_SHA) || defined(CONFIG_X86_AVX2)
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+#endif
+
+#ifdef CONFIG_X86_SHA
+/*
+ * Intel SHA extensions. The state lives in two registers as ABEF and CDGH,
+ * each sha256rnds2 does two rounds and msg1/msg2 extend the schedule four
+ * words at a time.
+ */
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_blocks_shani(uint32_t *state, const uint8_t *data,
+				unsigned int nr)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					     0x0405060700010203ULL);
+	__m128i abef, cdgh, tmp, msg, w[4];
+	int g;
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *) &state[0]), 0xb1);
+	cdgh = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *) &state[4]), 0x1b);
+	abef = _mm_alignr_epi8(tmp, cdgh, 8);
+	cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+	while (nr--) {
+		__m128i abef_save = abef, cdgh_save = cdgh;
+
+		/*
+		 * Fully unrolled, the schedule stays in registers
+		 */
+#pragma GCC unroll 16
+		for (g = 0; g < 16; g++) {
+			if (g < 4) {
+				msg = _mm_loadu_si128((__m128i *) data + g);
+				w[g] = _mm_shuffle_epi8(msg, bswap);
+			} else {
+				tmp = _mm_sha256msg1_epu32(w[g & 3],
+							   w[(g + 1) & 3]);
+				tmp = _mm_add_epi32(tmp,
+					_mm_alignr_epi8(w[(g + 3) & 3],
+							w[(g + 2) & 3], 4));
+				w[g & 3] = _mm_sha256msg2_epu32(tmp,
+							w[(g + 3) & 3]);
+			}
+
+			msg = _mm_add_epi32(w[g & 3],
+				_mm_load_si128((__m128i *) sha256_k + g));
+			cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+			msg = _mm_shuffle_epi32(msg, 0x0e);
+			abef = _mm_sha256rnds2_epu32(abef, cdgh, msg);
+		}
+
+		abef = _mm_add_epi32(abef, abef_save);
+		cdgh = _mm_add_epi32(cdgh, cdgh_save);
+		data += 64;
+	}
+
+	tmp = _mm_shuffle_epi32(abef, 0x1b);
+	cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+	_mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(tmp, cdgh, 0xf0));
+	_mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(cdgh, tmp, 8));
+}
+#endif
+
+#ifdef CONFIG_X86_AVX2
+/*
+ * Multi-buffer version, one message per 32-bit lane. Plain SHA-256 rounds
+ * have no parallelism to speak of, so this is the way to get SIMD to help:
+ * 8 messages take about as long as one does in the generic code.
+ */
+#define ROR256(x, n)	_mm256_or_si256(_mm256_srli_epi32(x, n),	\
+					_mm256_slli_epi32(x, 32 - (n)))
+
+/*
+ * 8x8 transpose of 32-bit words. Turns the 8 words at the same spot in
+ * each lane's message or state into one word per lane, and back.
+ */
+__attribute__((target("avx2")))
+static inline void transpose8(__m256i *r)
+{
+	__m256i t[8], u[8];
+	int i;
+
+	for (i = 0; i < 8; i += 2) {
+		t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	for (i = 0; i < 8; i += 4) {
+		u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+		u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+		u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	for (i = 0; i < 4; i++) {
+		r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+		r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+	}
+}
+
+/*
+ * Run nr blocks of each of the 8 messages through their states
+ */
+__attribute__((target("avx2")))
+static void sha256_x8_avx2(uint32_t state[][8], const uint8_t **data,
+			   unsigned int nr)
+{
+	const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+					      4, 5, 6, 7, 0, 1, 2, 3,
+					      12, 13, 14, 15, 8, 9, 10, 11,
+					      4, 5, 6, 7, 0, 1, 2, 3);
+	__m256i s[8], w[16];
+	unsigned int blk;
+	int i, t;
+
+	for (i = 0; i < MB_LANES; i++)
+		s[i] = _mm256_loadu_si256((__m256i *) state[i]);
+	transpose8(s);
+
+	for (blk = 0; blk < nr; blk++) {
+		__m256i a = s[0], b = s[1], c = s[2], d = s[3];
+		__m256i e = s[4], f = s[5], g = s[6], h = s[7];
+
+		for (i = 0; i < MB_LANES; i++) {
+			const __m256i *p = (const __m256i *) (data[i] + blk * 64);
+
+			w[i] = _mm256_loadu_si256(p);
+			w[i + 8] = _mm256_loadu_si256(p + 1);
+		}
+		transpose8(&w[0]);
+		transpose8(&w[8]);
+		for (i = 0; i < 16; i++)
+			w[i] = _mm256_shuffle_epi8(w[i], bswap);
+
+		for (t = 0; t < 64; t++) {
+			__m256i t1, t2, wt;
+
+			if (t < 16)
+				wt = w[t];
+			else {
+				__m256i w2 = w[(t - 2) & 15], w15 = w[(t - 15) & 15];
+				__m256i sig0, sig1;
+
+				sig0 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w15, 7),
+						ROR256(w15, 18)), _mm256_srli_epi32(w15, 3));
+				sig1 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w2, 17),
+						ROR256(w2, 19)), _mm256_srli_epi32(w2, 10));
+				wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], sig0),
+						_mm256_add_epi32(w[(t - 7) & 15], sig1));
+				w[t & 15] = wt;
+			}
+
+			t1 = _mm256_xor_si256(_mm256_xor_si256(ROR256(e, 6),
+					ROR256(e, 11)), ROR256(e, 25));
+			t1 = _mm256_add_epi32(t1, _mm256_xor_si256(g,
+					_mm256_and_si256(e, _mm256_xor_si256(f, g))));
+			t1 = _mm256_add_epi32(_mm256_add_epi32(t1, h),
+					_mm256_add_epi32(wt, _mm256_set1_epi32(sha256_k[t])));
+			t2 = _mm256_xor_si256(_mm256_xor_si256(ROR256(a, 2),
+					ROR256(a, 13)), ROR256(a, 22));
+			t2 = _mm256_add_epi32(t2, _mm256_or_si256(_mm256_and_si256(a, b),
+					_mm256_and_si256(c, _mm256_or_si256(a, b))));
+
+			h = g;
+			g = f;
+			f = e;
+			e = _mm256_add_epi32(d, t1);
+			d = c;
+			c = b;
+			b = a;
+			a = _mm256_add_epi32(t1, t2);
+		}
+
+		s[0] = _mm256_add_epi32(s[0], a);
+		s[1] = _mm256_add_epi32(s[1], b);
+		s[2] = _mm256_add_epi32(s[2], c);
+		s[3] = _mm256_add_epi32(s[3], d);
+		s[4] = _mm256_add_epi32(s[4], e);
+		s[5] = _mm256_add_epi32(s[5], f);
+		s[6] = _mm256_add_epi32(s[6], g);
+		s[7] = _mm256_add_epi32(s[7], h);
+	}
+
+	transpose8(s);
+	for (i = 0; i < MB_LANES; i++)
+		_mm256_storeu_si256((__m256i *) state[i], s[i]);
+}
+#endif
+
+struct sha256_impl {
+	const char *name;
+	void (*blocks)(uint32_t *, const uint8_t *, unsigned int);
+	void (*multi)(uint32_t [][8], const uint8_t **, unsigned int);
+	int (*available)(void);
+};
+
+/*
+ * Best first. The SHA extensions beat hashing 8 messages at once with
+ * AVX2, so the multi-buffer version only gets picked on CPUs without them.
+ */
+static struct sha256_impl sha256_impls[] = {
+#ifdef CONFIG_X86_SHA
+	{ "shani", sha256_blocks_shani, NULL, arch_x86_have_sha },
+#endif
+#ifdef CONFIG_X86_AVX2
+	{ "avx2x8", sha256_blocks_generic, sha256_x8_avx2, arch_x86_have_avx2 },
+#endif
+	{ "generic", sha256_blocks_generic, NULL, sha256_have_generic },
+	{ NULL, },
+};
+
+static struct sha256_impl *sha256_impl;
+
+static struct sha256_impl *sha256_probe(void)
+{
+	struct sha256_impl *impl;
+
+	/*
+	 * Racing threads all end up picking the same one
+	 */
+	if (!sha256_impl) {
+		for (impl = sha256_impls; impl->name; impl++) {
+			if (impl->available()) {
+				sha256_impl = impl;
+				break;
+			}
+		}
+	}
+
+	return sha256_impl;
+}
+
+/*
+ * Name of the version in use, for the crc test
+ */
+const char *fio_sha256_impl(void)
+{
+	return sha256_probe()->name;
+}
+
+/*
+ * Use a given version instead of the best one the CPU supports. Returns 1
+ * if it isn't built in or the CPU lacks it.
+ */
+int fio_sha256_set_impl(const char *name)
+{
+	struct sha256_impl *impl;
+
+	for (impl = sha256_impls; impl->name; impl++) {
+		if (strcmp(impl->name, name))
+			continue;
+		if (!impl->available())
+			return 1;
+		sha256_impl = impl;
+		return 0;
+	}
+
+	return 1;
+}
+
 void fio_sha256_init(struct fio_sha256_ctx *sctx)
 {
 	sctx->state[0] = H0;
@@ -243,6 +542,7 @@ void fio_sha256_init(struct fio_sha256_ctx *sctx)
 void fio_sha256_update(struct fio_sha256_ctx *sctx, const uint8_t *data,
 		       unsigned int len)
 {
+	struct sha256_impl *impl = sha256_probe();
 	unsigned int i, idx, part_len;
 
 	/* Compute number of bytes mod 128 */
@@ -259,10 +559,10 @@ void fio_sha256_update(struct fio_sha256_ctx *sctx, const uint8_t *data,
 	/* Transform as many times as possible. */
 	if (len >= part_len) {
 		memcpy(&sctx->buf[idx], data, part_len);
-		sha256_transform(sctx->state, sctx->buf);
+		impl->blocks(sctx->state, sctx->buf, 1);
 
-		for (i = part_len; i + 63 < len; i += 64)
-			sha256_transform(sctx->state, &data[i]);
+		i = part_len + (len - part_len) / 64 * 64;
+		impl->blocks(sctx->state, &data[part_len], (len - part_len) / 64);
 		idx = 0;
 	} else {
 		i = 0;
@@ -271,3 +571,121 @@ void fio_sha256_update(struct fio_sha256_ctx *sctx, const uint8_t *data,
 	/* Buffer remaining input */
 	memcpy(&sctx->buf[idx], &data[i], len-i);
 }
+
+/*
+ * Pad, and leave the digest in the first SHA256_DIGEST_SIZE bytes of
+ * sctx->buf. The rest of the buffer is cleared.
+ */
+void fio_sha256_final(struct fio_sha256_ctx *sctx)
+{
+	static const uint8_t padding[64] = { 0x80, };
+	uint32_t count[2] = { sctx->count[0], sctx->count[1] };
+	unsigned int idx, pad_len;
+	uint8_t bits[8];
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		bits[i] = count[1] >> (24 - 8 * i);
+		bits[i + 4] = count[0] >> (24 - 8 * i);
+	}
+
+	/* Pad out to 56 mod 64 */
+	idx = (count[0] >> 3) & 0x3f;
+	pad_len = (idx < 56) ? (56 - idx) : ((64 + 56) - idx);
+	fio_sha256_update(sctx, padding, pad_len);
+	fio_sha256_update(sctx, bits, sizeof(bits));
+
+	for (i = 0; i < 8; i++) {
+		sctx->buf[4 * i] = sctx->state[i] >> 24;
+		sctx->buf[4 * i + 1] = sctx->state[i] >> 16;
+		sctx->buf[4 * i + 2] = sctx->state[i] >> 8;
+		sctx->buf[4 * i + 3] = sctx->state[i];
+	}
+	memset(sctx->buf + SHA256_DIGEST_SIZE, 0,
+		SHA256_HMAC_BLOCK_SIZE - SHA256_DIGEST_SIZE);
+}
+
+static void sha256_one(const uint8_t *data, unsigned int len, uint8_t *digest)
+{
+	uint8_t buf[SHA256_HMAC_BLOCK_SIZE];
+	struct fio_sha256_ctx ctx = { .buf = buf };
+
+	fio_sha256_init(&ctx);
+	fio_sha256_update(&ctx, data, len);
+	fio_sha256_final(&ctx);
+	memcpy(digest, buf, SHA256_DIGEST_SIZE);
+}
+
+/*
+ * How many messages fio_sha256_multi() hashes at once. 1 means there is
+ * no gain in handing it more than one.
+ */
+unsigned int fio_sha256_lanes(void)
+{
+	return sha256_probe()->multi ? MB_LANES : 1;
+}
+
+/*
+ * Hash nr separate messages, writing SHA256_DIGEST_SIZE bytes to each of
+ * digest[]. With a multi-buffer version they go through it 8 at a time
+ * for as many full blocks as the shortest of them has, then each one is
+ * finished on its own.
+ */
+void fio_sha256_multi(const uint8_t **data, const unsigned int *len,
+		      uint8_t **digest, unsigned int nr)
+{
+	struct sha256_impl *impl = sha256_probe();
+	unsigned int i, j;
+
+	for (i = 0; i < nr; i += MB_LANES) {
+		uint32_t state[MB_LANES][8];
+		const uint8_t *p[MB_LANES];
+		unsigned int n = nr - i, blocks;
+
+		if (!impl->multi || n == 1) {
+			for (j = i; j < nr; j++)
+				sha256_one(data[j], len[j], digest[j]);
+			return;
+		}
+		if (n > MB_LANES)
+			n = MB_LANES;
+
+		/*
+		 * Spare lanes redo the first message
+		 */
+		blocks = len[i] / 64;
+		for (j = 0; j < MB_LANES; j++) {
+			unsigned int k = i + (j < n ? j : 0);
+
+			p[j] = data[k];
+			if (len[k] / 64 < blocks)
+				blocks = len[k] / 64;
+		}
+		for (j = 0; j < MB_LANES; j++) {
+			state[j][0] = H0;
+			state[j][1] = H1;
+			state[j][2] = H2;
+			state[j][3] = H3;
+			state[j][4] = H4;
+			state[j][5] = H5;
+			state[j][6] = H6;
+			state[j][7] = H7;
+		}
+
+		impl->multi(state, p, blocks);
+
+		for (j = 0; j < n; j++) {
+			uint8_t buf[SHA256_HMAC_BLOCK_SIZE];
+			struct fio_sha256_ctx ctx = { .buf = buf };
+			unsigned int done = blocks * 64;
+
+			memcpy(ctx.state, state[j], sizeof(ctx.state));
+			ctx.count[0] = done << 3;
+			ctx.count[1] = done >> 29;
+			fio_sha256_update(&ctx, data[i + j] + done,
+						len[i + j] - done);
+			fio_sha256_final(&ctx);
+			memcpy(digest[i + j], buf, SHA256_DIGEST_SIZE);
+		}
+	}
+}
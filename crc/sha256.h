@@ -1,6 +1,8 @@
 #ifndef FIO_SHA256_H
 #define FIO_SHA256_H
 
+#define SHA256_DIGEST_SIZE	32
+
 struct fio_sha256_ctx {
 	uint32_t count[2];
 	uint32_t state[8];
@@ -9,5 +11,11 @@ struct fio_sha256_ctx {
 
 void fio_sha256_init(struct fio_sha256_ctx *);
 void fio_sha256_update(struct fio_sha256_ctx *, const uint8_t *, unsigned int);
+void fio_sha256_final(struct fio_sha256_ctx *);
+void fio_sha256_multi(const uint8_t **, const unsigned int *, uint8_t **,
+		      unsigned int);
+unsigned int fio_sha256_lanes(void);
+const char *fio_sha256_impl(void);
+int fio_sha256_set_impl(const char *);
 
 #endif
@@ -17,6 +17,7 @@
 #include "../crc/sha256.h"
 #include "../crc/sha512.h"
 #include "../crc/xxhash.h"
+#include "../crc/xxh3.h"
 
 #include "test.h"
 
@@ -40,6 +41,8 @@ enum {
 	T_SHA256	= 1U << 7,
 	T_SHA512	= 1U << 8,
 	T_XXHASH	= 1U << 9,
+	T_XXH3		= 1U << 10,
+	T_XXH128	= 1U << 11,
 };
 
 static void t_md5(void *buf, size_t size)
@@ -116,6 +119,8 @@ static void t_sha256(void *buf, size_t size)
 
 	for (i = 0; i < NR_CHUNKS; i++)
 		fio_sha256_update(&ctx, buf, size);
+
+	fio_sha256_final(&ctx);
 }
 
 static void t_sha512(void *buf, size_t size)
@@ -143,6 +148,26 @@ static void t_xxhash(void *buf, size_t size)
 	XXH32_digest(state);
 }
 
+/*
+ * xxh3 is one-shot only, so hash each chunk on its own
+ */
+static void t_xxh3(void *buf, size_t size)
+{
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++)
+		fio_xxh3_64(buf, size);
+}
+
+static void t_xxh128(void *buf, size_t size)
+{
+	uint64_t hash[2];
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++)
+		fio_xxh128(buf, size, hash);
+}
+
 static struct test_type t[] = {
 	{
 		.name = "md5",
@@ -194,11 +219,278 @@ static struct test_type t[] = {
 		.mask = T_XXHASH,
 		.fn = t_xxhash,
 	},
+	{
+		.name = "xxh3",
+		.mask = T_XXH3,
+		.fn = t_xxh3,
+	},
+	{
+		.name = "xxh128",
+		.mask = T_XXH128,
+		.fn = t_xxh128,
+	},
 	{
 		.name = NULL,
 	},
 };
 
+static const char *crc32c_impls[] = { "serial", "3way", "vpclmul", NULL };
+static const char *xxh3_impls[] = { "scalar", "sse2", "avx2", NULL };
+static const char *sha256_impls[] = { "generic", "shani", "avx2x8", NULL };
+static const unsigned int block_sizes[] = { 512, 4096, 16384, 65536, CHUNK };
+
+static void print_sizes(void)
+{
+	unsigned int j;
+
+	for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+		if (block_sizes[j] < 1024)
+			printf(" %8u", block_sizes[j]);
+		else
+			printf(" %7uk", block_sizes[j] / 1024);
+	}
+	printf("\n");
+}
+
+/*
+ * Each hardware crc32c version must match the table driven one, at any
+ * length and alignment, whichever streams and folds that ends up using
+ */
+static int crc32c_check(const char *name, unsigned char *buf)
+{
+	unsigned int len, off;
+	int err = 0;
+
+	for (len = 0; len < 3 * 4096 + 1024 && !err; len += 1 + len / 16) {
+		for (off = 0; off < 8; off += 3) {
+			uint32_t want = crc32c_sw(buf + off, len);
+			uint32_t got = crc32c_intel(buf + off, len);
+
+			if (want != got) {
+				fprintf(stderr, "crc32c %s: got %08x, expected "
+					"%08x, len %u offset %u\n", name,
+					got, want, len, off);
+				err = 1;
+				break;
+			}
+		}
+	}
+
+	return err;
+}
+
+/*
+ * Speed of the crc32c versions the CPU supports, per block size
+ */
+static int crc32c_by_size(unsigned char *buf)
+{
+	const uint64_t total = CHUNK * NR_CHUNKS;
+	const char *best = crc32c_intel_impl();
+	unsigned int i, j;
+	int err = 0;
+
+	if (!best)
+		return 0;
+
+	printf("\ncrc32c GB/sec, %s by default\n%-8s", best, "");
+	print_sizes();
+
+	for (i = 0; crc32c_impls[i]; i++) {
+		if (crc32c_intel_set_impl(crc32c_impls[i]))
+			continue;
+		if (crc32c_check(crc32c_impls[i], buf)) {
+			err = 1;
+			continue;
+		}
+
+		printf("%-8s", crc32c_impls[i]);
+		for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+			unsigned int size = block_sizes[j];
+			struct timeval tv;
+			uint64_t done, usec;
+
+			fio_gettime(&tv, NULL);
+			for (done = 0; done < total; done += size)
+				crc32c_intel(buf, size);
+			usec = utime_since_now(&tv);
+
+			printf(" %8.2f", (double) total / (double) usec / 1000.0);
+		}
+		printf("\n");
+	}
+
+	crc32c_intel_set_impl(best);
+	return err;
+}
+
+/*
+ * The vector xxh3 versions must give the same hashes as the scalar one,
+ * for the short inputs that don't use them too
+ */
+static int xxh3_check(const char *name, unsigned char *buf)
+{
+	unsigned int len, off;
+	int err = 0;
+
+	for (len = 0; len < 3 * 4096 + 1024 && !err; len += 1 + len / 16) {
+		for (off = 0; off < 8; off += 3) {
+			uint64_t want[2], got[2];
+			uint64_t want64, got64;
+
+			fio_xxh3_set_impl("scalar");
+			want64 = fio_xxh3_64(buf + off, len);
+			fio_xxh128(buf + off, len, want);
+			fio_xxh3_set_impl(name);
+			got64 = fio_xxh3_64(buf + off, len);
+			fio_xxh128(buf + off, len, got);
+
+			if (want64 != got64 || memcmp(want, got, sizeof(want))) {
+				fprintf(stderr, "xxh3 %s: mismatch, len %u "
+					"offset %u\n", name, len, off);
+				err = 1;
+				break;
+			}
+		}
+	}
+
+	return err;
+}
+
+/*
+ * Speed of the xxh3 versions the CPU supports, per block size
+ */
+static int xxh3_by_size(unsigned char *buf)
+{
+	const uint64_t total = CHUNK * NR_CHUNKS;
+	const char *best = fio_xxh3_impl();
+	unsigned int i, j;
+	int err = 0;
+
+	printf("\nxxh3 GB/sec, %s by default\n%-8s", best, "");
+	print_sizes();
+
+	for (i = 0; xxh3_impls[i]; i++) {
+		if (fio_xxh3_set_impl(xxh3_impls[i]))
+			continue;
+		if (xxh3_check(xxh3_impls[i], buf)) {
+			err = 1;
+			continue;
+		}
+
+		fio_xxh3_set_impl(xxh3_impls[i]);
+		printf("%-8s", xxh3_impls[i]);
+		for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+			unsigned int size = block_sizes[j];
+			struct timeval tv;
+			uint64_t done, usec;
+
+			fio_gettime(&tv, NULL);
+			for (done = 0; done < total; done += size)
+				fio_xxh3_64(buf, size);
+			usec = utime_since_now(&tv);
+
+			printf(" %8.2f", (double) total / (double) usec / 1000.0);
+		}
+		printf("\n");
+	}
+
+	fio_xxh3_set_impl(best);
+	return err;
+}
+
+#define SHA256_MSGS	8
+
+/*
+ * Each sha256 version must give the same digests as the generic one, one
+ * message at a time or several of different lengths at once
+ */
+static int sha256_check(const char *name, unsigned char *buf)
+{
+	uint8_t want[SHA256_MSGS][SHA256_DIGEST_SIZE];
+	uint8_t got[SHA256_MSGS][SHA256_DIGEST_SIZE];
+	const uint8_t *data[SHA256_MSGS];
+	unsigned int len[SHA256_MSGS];
+	uint8_t *out[SHA256_MSGS];
+	unsigned int base, i;
+
+	for (base = 0; base < 3 * 4096; base += 1 + base / 4) {
+		for (i = 0; i < SHA256_MSGS; i++) {
+			data[i] = buf + i * 7;
+			len[i] = base + i * 61;
+			out[i] = want[i];
+		}
+		fio_sha256_set_impl("generic");
+		fio_sha256_multi(data, len, out, SHA256_MSGS);
+
+		for (i = 0; i < SHA256_MSGS; i++)
+			out[i] = got[i];
+		fio_sha256_set_impl(name);
+		fio_sha256_multi(data, len, out, SHA256_MSGS);
+
+		if (memcmp(want, got, sizeof(want))) {
+			fprintf(stderr, "sha256 %s: mismatch, len %u\n",
+					name, base);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Speed of the sha256 versions the CPU supports, per block size, hashing
+ * blocks in groups the way the async verify threads do. The messages of a
+ * group are all the same buffer, it's only timing.
+ */
+static int sha256_by_size(unsigned char *buf)
+{
+	const uint64_t total = CHUNK * NR_CHUNKS / 8;
+	const char *best = fio_sha256_impl();
+	unsigned int i, j, k;
+	int err = 0;
+
+	printf("\nsha256 GB/sec, %s by default\n%-8s", best, "");
+	print_sizes();
+
+	for (i = 0; sha256_impls[i]; i++) {
+		if (fio_sha256_set_impl(sha256_impls[i]))
+			continue;
+		if (sha256_check(sha256_impls[i], buf)) {
+			err = 1;
+			continue;
+		}
+
+		fio_sha256_set_impl(sha256_impls[i]);
+		printf("%-8s", sha256_impls[i]);
+		for (j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++) {
+			unsigned int size = block_sizes[j];
+			uint8_t digests[SHA256_MSGS][SHA256_DIGEST_SIZE];
+			const uint8_t *data[SHA256_MSGS];
+			unsigned int len[SHA256_MSGS];
+			uint8_t *out[SHA256_MSGS];
+			struct timeval tv;
+			uint64_t done, usec;
+
+			for (k = 0; k < SHA256_MSGS; k++) {
+				data[k] = buf;
+				len[k] = size;
+				out[k] = digests[k];
+			}
+
+			fio_gettime(&tv, NULL);
+			for (done = 0; done < total; done += SHA256_MSGS * size)
+				fio_sha256_multi(data, len, out, SHA256_MSGS);
+			usec = utime_since_now(&tv);
+
+			printf(" %8.2f", (double) total / (double) usec / 1000.0);
+		}
+		printf("\n");
+	}
+
+	fio_sha256_set_impl(best);
+	return err;
+}
+
 static unsigned int get_test_mask(const char *type)
 {
 	char *ostr, *str = strdup(type);
@@ -236,7 +528,7 @@ int fio_crctest(const char *type)
 	unsigned int test_mask = 0;
 	uint64_t mb = CHUNK * NR_CHUNKS;
 	struct frand_state state;
-	int i, first = 1;
+	int i, first = 1, err = 0;
 	void *buf;
 
 	crc32c_intel_probe();
@@ -284,6 +576,13 @@ int fio_crctest(const char *type)
 		first = 0;
 	}
 
+	if (test_mask & T_CRC32C)
+		err = crc32c_by_size(buf);
+	if (test_mask & (T_XXH3 | T_XXH128))
+		err |= xxh3_by_size(buf);
+	if (test_mask & T_SHA256)
+		err |= sha256_by_size(buf);
+
 	free(buf);
-	return 0;
+	return err;
 }
@@ -0,0 +1,614 @@
+/*
+ * XXH3 64-bit and XXH128 hashes, after xxHash 0.8 by Yann Collet
+ * (BSD 2-Clause License, https://github.com/Cyan4973/xxHash)
+ *
+ * Only the one-shot variants with the default secret and a seed of 0 are
+ * here, that is all verify needs. Inputs up to 240 bytes take a handful of
+ * multiplies. Longer ones run 8 lanes of 64-bit accumulators over 64 byte
+ * stripes, which is where the time goes for verify sized blocks, so that
+ * part has SSE2 and AVX2 versions. They all produce the same hash.
+ */
+#include <string.h>
+#include <inttypes.h>
+
+#include "xxh3.h"
+#include "../arch/arch.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#ifdef CONFIG_X86_AVX2
+#include <immintrin.h>
+#endif
+
+#define PRIME32_1	0x9E3779B1U
+#define PRIME32_2	0x85EBCA77U
+#define PRIME32_3	0xC2B2AE3DU
+#define PRIME64_1	0x9E3779B185EBCA87ULL
+#define PRIME64_2	0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3	0x165667B19E3779F9ULL
+#define PRIME64_4	0x85EBCA77C2B2AE63ULL
+#define PRIME64_5	0x27D4EB2F165667C5ULL
+#define PRIME_MX1	0x165667919E3779F9ULL
+#define PRIME_MX2	0x9FB21C651E98DF25ULL
+
+#define STRIPE_LEN		64
+#define SECRET_CONSUME_RATE	8
+#define SECRET_SIZE		192
+#define SECRET_SIZE_MIN		136
+#define MIDSIZE_MAX		240
+#define MIDSIZE_STARTOFFSET	3
+#define MIDSIZE_LASTOFFSET	17
+#define MERGEACCS_START		11
+#define LASTACC_START		7
+
+#define STRIPES_PER_BLOCK	((SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE)
+#define BLOCK_LEN		(STRIPE_LEN * STRIPES_PER_BLOCK)
+
+static const uint8_t xxh3_secret[SECRET_SIZE] __attribute__((aligned(64))) = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+#ifdef CONFIG_LITTLE_ENDIAN
+	return v;
+#else
+	return __builtin_bswap32(v);
+#endif
+}
+
+static inline uint64_t read64(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+#ifdef CONFIG_LITTLE_ENDIAN
+	return v;
+#else
+	return __builtin_bswap64(v);
+#endif
+}
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint32_t rotl32(uint32_t x, int r)
+{
+	return (x << r) | (x >> (32 - r));
+}
+
+static inline void mult64to128(uint64_t a, uint64_t b, uint64_t *lo,
+			       uint64_t *hi)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128) a * b;
+
+	*lo = (uint64_t) p;
+	*hi = (uint64_t) (p >> 64);
+#else
+	uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+	uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+	uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+	uint64_t hi_hi = (a >> 32) * (b >> 32);
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+
+	*hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	*lo = (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+}
+
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+	uint64_t lo, hi;
+
+	mult64to128(a, b, &lo, &hi);
+	return lo ^ hi;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h)
+{
+	h ^= h >> 37;
+	h *= PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len)
+{
+	h ^= rotl64(h, 49) ^ rotl64(h, 24);
+	h *= PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+static inline uint64_t mix16(const uint8_t *in, const uint8_t *secret,
+			     uint64_t seed)
+{
+	return mul128_fold64(read64(in) ^ (read64(secret) + seed),
+			     read64(in + 8) ^ (read64(secret + 8) - seed));
+}
+
+/*
+ * Long inputs. Each version takes nr 64 byte stripes, moving 8 bytes along
+ * the secret per stripe.
+ */
+static void accumulate_scalar(uint64_t *acc, const uint8_t *in,
+			      const uint8_t *secret, size_t nr)
+{
+	size_t n;
+	int i;
+
+	for (n = 0; n < nr; n++) {
+		const uint8_t *p = in + n * STRIPE_LEN;
+		const uint8_t *s = secret + n * SECRET_CONSUME_RATE;
+
+		for (i = 0; i < 8; i++) {
+			uint64_t data = read64(p + 8 * i);
+			uint64_t key = data ^ read64(s + 8 * i);
+
+			acc[i ^ 1] += data;
+			acc[i] += (key & 0xffffffff) * (key >> 32);
+		}
+	}
+}
+
+static void scramble_scalar(uint64_t *acc, const uint8_t *secret)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		uint64_t a = acc[i];
+
+		a ^= a >> 47;
+		a ^= read64(secret + 8 * i);
+		a *= PRIME32_1;
+		acc[i] = a;
+	}
+}
+
+static int xxh3_have_scalar(void)
+{
+	return 1;
+}
+
+/*
+ * The vector versions do the same per 64-bit lane. The 32x32 multiply of
+ * the two halves of data ^ key is a mul_epu32 against a copy with the
+ * halves swapped, and the data is added to the neighbouring lane by
+ * swapping the 64-bit halves of each 128-bit lane.
+ */
+#if defined(__SSE2__)
+static void accumulate_sse2(uint64_t *acc, const uint8_t *in,
+			    const uint8_t *secret, size_t nr)
+{
+	__m128i a[4];
+	size_t n;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		a[i] = _mm_loadu_si128((__m128i *) acc + i);
+
+	for (n = 0; n < nr; n++) {
+		const __m128i *p = (const __m128i *) (in + n * STRIPE_LEN);
+		const __m128i *s = (const __m128i *)
+					(secret + n * SECRET_CONSUME_RATE);
+
+		for (i = 0; i < 4; i++) {
+			__m128i data = _mm_loadu_si128(p + i);
+			__m128i key = _mm_xor_si128(data, _mm_loadu_si128(s + i));
+			__m128i key_hi = _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1));
+			__m128i prod = _mm_mul_epu32(key, key_hi);
+			__m128i swap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+
+			a[i] = _mm_add_epi64(a[i], _mm_add_epi64(prod, swap));
+		}
+	}
+
+	for (i = 0; i < 4; i++)
+		_mm_storeu_si128((__m128i *) acc + i, a[i]);
+}
+
+static void scramble_sse2(uint64_t *acc, const uint8_t *secret)
+{
+	const __m128i prime = _mm_set1_epi32(PRIME32_1);
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		__m128i a = _mm_loadu_si128((__m128i *) acc + i);
+		__m128i key = _mm_loadu_si128((const __m128i *) secret + i);
+		__m128i hi, lo;
+
+		a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+		a = _mm_xor_si128(a, key);
+		hi = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+		lo = _mm_mul_epu32(a, prime);
+		hi = _mm_mul_epu32(hi, prime);
+		a = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+		_mm_storeu_si128((__m128i *) acc + i, a);
+	}
+}
+
+static int xxh3_have_sse2(void)
+{
+	return 1;
+}
+#endif
+
+#ifdef CONFIG_X86_AVX2
+__attribute__((target("avx2")))
+static void accumulate_avx2(uint64_t *acc, const uint8_t *in,
+			    const uint8_t *secret, size_t nr)
+{
+	__m256i a0 = _mm256_loadu_si256((__m256i *) acc);
+	__m256i a1 = _mm256_loadu_si256((__m256i *) acc + 1);
+	size_t n;
+
+	for (n = 0; n < nr; n++) {
+		const __m256i *p = (const __m256i *) (in + n * STRIPE_LEN);
+		const __m256i *s = (const __m256i *)
+					(secret + n * SECRET_CONSUME_RATE);
+		__m256i d0 = _mm256_loadu_si256(p);
+		__m256i d1 = _mm256_loadu_si256(p + 1);
+		__m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256(s));
+		__m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256(s + 1));
+
+		k0 = _mm256_mul_epu32(k0, _mm256_shuffle_epi32(k0, _MM_SHUFFLE(0, 3, 0, 1)));
+		k1 = _mm256_mul_epu32(k1, _mm256_shuffle_epi32(k1, _MM_SHUFFLE(0, 3, 0, 1)));
+		d0 = _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2));
+		d1 = _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2));
+		a0 = _mm256_add_epi64(a0, _mm256_add_epi64(k0, d0));
+		a1 = _mm256_add_epi64(a1, _mm256_add_epi64(k1, d1));
+	}
+
+	_mm256_storeu_si256((__m256i *) acc, a0);
+	_mm256_storeu_si256((__m256i *) acc + 1, a1);
+}
+
+__attribute__((target("avx2")))
+static void scramble_avx2(uint64_t *acc, const uint8_t *secret)
+{
+	const __m256i prime = _mm256_set1_epi32(PRIME32_1);
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		__m256i a = _mm256_loadu_si256((__m256i *) acc + i);
+		__m256i key = _mm256_loadu_si256((const __m256i *) secret + i);
+		__m256i hi, lo;
+
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, key);
+		hi = _mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+		lo = _mm256_mul_epu32(a, prime);
+		hi = _mm256_mul_epu32(hi, prime);
+		a = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+		_mm256_storeu_si256((__m256i *) acc + i, a);
+	}
+}
+#endif
+
+struct xxh3_impl {
+	const char *name;
+	void (*accumulate)(uint64_t *, const uint8_t *, const uint8_t *, size_t);
+	void (*scramble)(uint64_t *, const uint8_t *);
+	int (*available)(void);
+};
+
+/*
+ * Best first
+ */
+static struct xxh3_impl xxh3_impls[] = {
+#ifdef CONFIG_X86_AVX2
+	{ "avx2", accumulate_avx2, scramble_avx2, arch_x86_have_avx2 },
+#endif
+#if defined(__SSE2__)
+	{ "sse2", accumulate_sse2, scramble_sse2, xxh3_have_sse2 },
+#endif
+	{ "scalar", accumulate_scalar, scramble_scalar, xxh3_have_scalar },
+	{ NULL, },
+};
+
+static struct xxh3_impl *xxh3_impl;
+
+static struct xxh3_impl *xxh3_probe(void)
+{
+	struct xxh3_impl *impl;
+
+	/*
+	 * Racing threads all end up picking the same one
+	 */
+	if (!xxh3_impl) {
+		for (impl = xxh3_impls; impl->name; impl++) {
+			if (impl->available()) {
+				xxh3_impl = impl;
+				break;
+			}
+		}
+	}
+
+	return xxh3_impl;
+}
+
+/*
+ * Name of the version in use, for the crc test
+ */
+const char *fio_xxh3_impl(void)
+{
+	return xxh3_probe()->name;
+}
+
+/*
+ * Use a given version instead of the best one the CPU supports. Returns 1
+ * if it isn't built in or the CPU lacks it.
+ */
+int fio_xxh3_set_impl(const char *name)
+{
+	struct xxh3_impl *impl;
+
+	for (impl = xxh3_impls; impl->name; impl++) {
+		if (strcmp(impl->name, name))
+			continue;
+		if (!impl->available())
+			return 1;
+		xxh3_impl = impl;
+		return 0;
+	}
+
+	return 1;
+}
+
+static void hash_long(uint64_t *acc, const uint8_t *in, size_t len)
+{
+	struct xxh3_impl *impl = xxh3_probe();
+	size_t nr_blocks = (len - 1) / BLOCK_LEN;
+	size_t n, stripes;
+
+	acc[0] = PRIME32_3;
+	acc[1] = PRIME64_1;
+	acc[2] = PRIME64_2;
+	acc[3] = PRIME64_3;
+	acc[4] = PRIME64_4;
+	acc[5] = PRIME32_2;
+	acc[6] = PRIME64_5;
+	acc[7] = PRIME32_1;
+
+	for (n = 0; n < nr_blocks; n++) {
+		impl->accumulate(acc, in + n * BLOCK_LEN, xxh3_secret,
+					STRIPES_PER_BLOCK);
+		impl->scramble(acc, xxh3_secret + SECRET_SIZE - STRIPE_LEN);
+	}
+
+	/*
+	 * Partial last block, then the last 64 bytes with a secret offset
+	 * that the stripes never use
+	 */
+	stripes = ((len - 1) - BLOCK_LEN * nr_blocks) / STRIPE_LEN;
+	impl->accumulate(acc, in + nr_blocks * BLOCK_LEN, xxh3_secret, stripes);
+	impl->accumulate(acc, in + len - STRIPE_LEN,
+		xxh3_secret + SECRET_SIZE - STRIPE_LEN - LASTACC_START, 1);
+}
+
+static uint64_t merge_accs(const uint64_t *acc, const uint8_t *secret,
+			   uint64_t start)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		start += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i),
+				acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+
+	return xxh3_avalanche(start);
+}
+
+static uint64_t xxh3_64_short(const uint8_t *in, size_t len)
+{
+	const uint8_t *s = xxh3_secret;
+
+	if (len > 8) {
+		uint64_t lo = read64(in) ^ (read64(s + 24) ^ read64(s + 32));
+		uint64_t hi = read64(in + len - 8) ^ (read64(s + 40) ^ read64(s + 48));
+		uint64_t acc = len + __builtin_bswap64(lo) + hi +
+				mul128_fold64(lo, hi);
+
+		return xxh3_avalanche(acc);
+	} else if (len >= 4) {
+		uint64_t v = read32(in + len - 4) + ((uint64_t) read32(in) << 32);
+
+		return xxh3_rrmxmx(v ^ (read64(s + 8) ^ read64(s + 16)), len);
+	} else if (len) {
+		uint32_t c = ((uint32_t) in[0] << 16) |
+				((uint32_t) in[len >> 1] << 24) |
+				in[len - 1] | ((uint32_t) len << 8);
+
+		return xxh64_avalanche(c ^ (uint64_t) (read32(s) ^ read32(s + 4)));
+	}
+
+	return xxh64_avalanche(read64(s + 56) ^ read64(s + 64));
+}
+
+uint64_t fio_xxh3_64(const void *data, size_t len)
+{
+	const uint8_t *in = data;
+	const uint8_t *s = xxh3_secret;
+	uint64_t acc[8] __attribute__((aligned(32)));
+	uint64_t h, end;
+	unsigned int i;
+
+	if (len <= 16)
+		return xxh3_64_short(in, len);
+
+	if (len <= 128) {
+		h = len * PRIME64_1;
+		if (len > 32) {
+			if (len > 64) {
+				if (len > 96) {
+					h += mix16(in + 48, s + 96, 0);
+					h += mix16(in + len - 64, s + 112, 0);
+				}
+				h += mix16(in + 32, s + 64, 0);
+				h += mix16(in + len - 48, s + 80, 0);
+			}
+			h += mix16(in + 16, s + 32, 0);
+			h += mix16(in + len - 32, s + 48, 0);
+		}
+		h += mix16(in, s, 0);
+		h += mix16(in + len - 16, s + 16, 0);
+		return xxh3_avalanche(h);
+	}
+
+	if (len <= MIDSIZE_MAX) {
+		h = len * PRIME64_1;
+		for (i = 0; i < 8; i++)
+			h += mix16(in + 16 * i, s + 16 * i, 0);
+		h = xxh3_avalanche(h);
+
+		end = mix16(in + len - 16,
+				s + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET, 0);
+		for (i = 8; i < len / 16; i++)
+			end += mix16(in + 16 * i,
+				s + 16 * (i - 8) + MIDSIZE_STARTOFFSET, 0);
+		return xxh3_avalanche(h + end);
+	}
+
+	hash_long(acc, in, len);
+	return merge_accs(acc, s + MERGEACCS_START, len * PRIME64_1);
+}
+
+/*
+ * XXH128 mixes 32 bytes at a time into a pair of accumulators
+ */
+static inline void mix32(uint64_t *lo, uint64_t *hi, const uint8_t *in1,
+			 const uint8_t *in2, const uint8_t *secret,
+			 uint64_t seed)
+{
+	*lo += mix16(in1, secret, seed);
+	*lo ^= read64(in2) + read64(in2 + 8);
+	*hi += mix16(in2, secret + 16, seed);
+	*hi ^= read64(in1) + read64(in1 + 8);
+}
+
+static void xxh128_short(const uint8_t *in, size_t len, uint64_t *out)
+{
+	const uint8_t *s = xxh3_secret;
+	uint64_t lo, hi;
+
+	if (len > 8) {
+		uint64_t in_lo = read64(in);
+		uint64_t in_hi = read64(in + len - 8);
+		uint64_t m_lo, m_hi;
+
+		mult64to128(in_lo ^ in_hi ^ (read64(s + 32) ^ read64(s + 40)),
+				PRIME64_1, &m_lo, &m_hi);
+		m_lo += (uint64_t) (len - 1) << 54;
+		in_hi ^= read64(s + 48) ^ read64(s + 56);
+		m_hi += in_hi + (in_hi & 0xffffffff) * (PRIME32_2 - 1);
+		m_lo ^= __builtin_bswap64(m_hi);
+
+		mult64to128(m_lo, PRIME64_2, &lo, &hi);
+		hi += m_hi * PRIME64_2;
+		out[0] = xxh3_avalanche(lo);
+		out[1] = xxh3_avalanche(hi);
+	} else if (len >= 4) {
+		uint64_t v = read32(in) + ((uint64_t) read32(in + len - 4) << 32);
+
+		v ^= read64(s + 16) ^ read64(s + 24);
+		mult64to128(v, PRIME64_1 + (len << 2), &lo, &hi);
+		hi += lo << 1;
+		lo ^= hi >> 3;
+		lo ^= lo >> 35;
+		lo *= PRIME_MX2;
+		lo ^= lo >> 28;
+		out[0] = lo;
+		out[1] = xxh3_avalanche(hi);
+	} else if (len) {
+		uint32_t cl = ((uint32_t) in[0] << 16) |
+				((uint32_t) in[len >> 1] << 24) |
+				in[len - 1] | ((uint32_t) len << 8);
+		uint32_t ch = rotl32(__builtin_bswap32(cl), 13);
+
+		out[0] = xxh64_avalanche(cl ^ (uint64_t) (read32(s) ^ read32(s + 4)));
+		out[1] = xxh64_avalanche(ch ^ (uint64_t) (read32(s + 8) ^ read32(s + 12)));
+	} else {
+		out[0] = xxh64_avalanche(read64(s + 64) ^ read64(s + 72));
+		out[1] = xxh64_avalanche(read64(s + 80) ^ read64(s + 88));
+	}
+}
+
+void fio_xxh128(const void *data, size_t len, uint64_t *out)
+{
+	const uint8_t *in = data;
+	const uint8_t *s = xxh3_secret;
+	uint64_t acc[8] __attribute__((aligned(32)));
+	uint64_t lo, hi;
+	unsigned int i;
+
+	if (len <= 16) {
+		xxh128_short(in, len, out);
+		return;
+	}
+
+	if (len > MIDSIZE_MAX) {
+		hash_long(acc, in, len);
+		out[0] = merge_accs(acc, s + MERGEACCS_START, len * PRIME64_1);
+		out[1] = merge_accs(acc, s + SECRET_SIZE - 64 - MERGEACCS_START,
+					~(len * PRIME64_2));
+		return;
+	}
+
+	lo = len * PRIME64_1;
+	hi = 0;
+
+	if (len <= 128) {
+		if (len > 32) {
+			if (len > 64) {
+				if (len > 96)
+					mix32(&lo, &hi, in + 48, in + len - 64,
+						s + 96, 0);
+				mix32(&lo, &hi, in + 32, in + len - 48, s + 64, 0);
+			}
+			mix32(&lo, &hi, in + 16, in + len - 32, s + 32, 0);
+		}
+		mix32(&lo, &hi, in, in + len - 16, s, 0);
+	} else {
+		for (i = 32; i < 160; i += 32)
+			mix32(&lo, &hi, in + i - 32, in + i - 16, s + i - 32, 0);
+		lo = xxh3_avalanche(lo);
+		hi = xxh3_avalanche(hi);
+		for (i = 160; i <= len; i += 32)
+			mix32(&lo, &hi, in + i - 32, in + i - 16,
+				s + MIDSIZE_STARTOFFSET + i - 160, 0);
+		mix32(&lo, &hi, in + len - 16, in + len - 32,
+			s + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16, 0);
+	}
+
+	out[0] = xxh3_avalanche(lo + hi);
+	out[1] = -xxh3_avalanche(lo * PRIME64_1 + hi * PRIME64_4 +
+					len * PRIME64_2);
+}
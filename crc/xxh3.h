@@ -0,0 +1,17 @@
+#ifndef FIO_XXH3_H
+#define FIO_XXH3_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/*
+ * XXH3 64-bit and XXH128, one-shot with the default secret and seed 0.
+ * Results match the reference xxHash 0.8 implementation bit for bit.
+ */
+extern uint64_t fio_xxh3_64(const void *, size_t);
+extern void fio_xxh128(const void *, size_t, uint64_t *);
+
+extern const char *fio_xxh3_impl(void);
+extern int fio_xxh3_set_impl(const char *);
+
+#endif
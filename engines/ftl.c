@@ -0,0 +1,838 @@
+/*
+ * ftl engine
+ *
+ * IO engine that runs a host side, page mapped flash translation layer in
+ * the IO path, for evaluating FTL policies without a device that exposes
+ * them. The job file is the logical device, and is also used as the
+ * backing store for the physical flash pages behind it.
+ *
+ * The physical space is the logical size plus ftl_op percent of
+ * over-provisioning, carved into erase blocks of ftl_pages_per_block
+ * pages. Writes are appended to an open block and the logical to physical
+ * mapping is updated, invalidating the previous copy of each page. When
+ * the number of free blocks drops to the GC threshold, victim blocks are
+ * picked either greedily (fewest valid pages) or by cost-benefit (free
+ * space gained weighed by the age of the block), their valid pages are
+ * relocated and the blocks erased.
+ *
+ * With ftl_hot_cold, pages are classified by a small per page update
+ * counter that is halved every time the logical space has been written
+ * once. Recently rewritten pages go to a hot open block, the rest to a
+ * cold one, and relocated pages to a third so that GC does not mix them
+ * with fresh host data.
+ *
+ * Write amplification, erase counts, the duration of every GC run and the
+ * memory used by the mapping tables are reported with the job stats.
+ * With ftl_backing=0 only the mapping is simulated and no data is read or
+ * written, which is much faster when only the WA numbers are of interest.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+#include <string.h>
+
+#include "../fio.h"
+
+#define FTL_PAGE_NONE	(-1U)
+#define FTL_BLOCK_NONE	(-1U)
+
+enum {
+	FTL_GC_GREEDY		= 0,
+	FTL_GC_COST_BENEFIT,
+};
+
+enum {
+	FTL_STREAM_HOT		= 0,
+	FTL_STREAM_COLD,
+	FTL_STREAM_GC,
+	FTL_STREAM_NR,
+};
+
+/*
+ * A page is written to the hot stream once its update counter reaches
+ * this, with ftl_hot_cold
+ */
+#define FTL_HOT_UPDATES	2
+
+enum {
+	FTL_BLOCK_FREE		= 0,
+	FTL_BLOCK_OPEN,
+	FTL_BLOCK_FULL,
+};
+
+struct ftl_block {
+	uint32_t valid;
+	uint32_t wp;
+	uint32_t erases;
+	uint32_t state;
+	uint64_t seq;
+};
+
+/*
+ * FTL state for one file, kept across opens and closes of the file
+ */
+struct ftl_dev {
+	uint32_t nr_lpages;
+	uint32_t nr_ppages;
+	uint32_t nr_blocks;
+	uint32_t gc_free;
+
+	uint32_t *l2p;
+	uint32_t *p2l;
+	uint8_t *heat;
+	struct ftl_block *blocks;
+
+	uint32_t *free_blocks;
+	uint32_t nr_free;
+
+	uint32_t open[FTL_STREAM_NR];
+
+	/*
+	 * Host page writes, used as the clock for block age and
+	 * update counter decay
+	 */
+	uint64_t seq;
+	uint64_t next_decay;
+};
+
+struct ftl_data {
+	struct ftl_dev **devs;
+	unsigned int nr_devs;
+	unsigned int page_size;
+	unsigned int ppb;
+	void *gc_buf;
+};
+
+struct ftl_options {
+	struct thread_data *td;
+	unsigned int op;
+	unsigned long long page_size;
+	unsigned int ppb;
+	unsigned int gc;
+	unsigned int gc_free;
+	unsigned int hot_cold;
+	unsigned int backing;
+};
+
+static struct fio_option options[] = {
+	{
+		.name	= "ftl_op",
+		.lname	= "FTL over-provisioning",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct ftl_options, op),
+		.help	= "Physical space beyond the logical size, in percent",
+		.def	= "7",
+		.minval	= 1,
+		.maxval	= 1000,
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "ftl_page_size",
+		.lname	= "FTL page size",
+		.type	= FIO_OPT_STR_VAL,
+		.off1	= offsetof(struct ftl_options, page_size),
+		.help	= "FTL mapping unit (0 = open-channel page size)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "ftl_pages_per_block",
+		.lname	= "FTL pages per block",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct ftl_options, ppb),
+		.help	= "Pages per erase block (0 = nvm_pages_per_block)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "ftl_gc",
+		.lname	= "FTL GC policy",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct ftl_options, gc),
+		.help	= "How garbage collection picks victim blocks",
+		.def	= "greedy",
+		.posval = {
+			  { .ival = "greedy",
+			    .oval = FTL_GC_GREEDY,
+			    .help = "Block with the fewest valid pages",
+			  },
+			  { .ival = "cost-benefit",
+			    .oval = FTL_GC_COST_BENEFIT,
+			    .help = "Best free space gained times age per copy cost",
+			  },
+		},
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "ftl_gc_free_blocks",
+		.lname	= "FTL GC threshold",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct ftl_options, gc_free),
+		.help	= "Run GC when this many free blocks remain (0 = auto)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "ftl_hot_cold",
+		.lname	= "FTL hot/cold separation",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct ftl_options, hot_cold),
+		.help	= "Separate frequently updated pages from the rest",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "ftl_backing",
+		.lname	= "FTL backing store",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct ftl_options, backing),
+		.help	= "Store page data in the job file",
+		.def	= "1",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+static unsigned long long ftl_dev_map_bytes(struct ftl_dev *dev)
+{
+	return (unsigned long long) dev->nr_lpages * (sizeof(uint32_t) + 1) +
+		(unsigned long long) dev->nr_ppages * sizeof(uint32_t) +
+		(unsigned long long) dev->nr_blocks *
+			(sizeof(struct ftl_block) + sizeof(uint32_t));
+}
+
+static void ftl_dev_free(struct ftl_dev *dev)
+{
+	free(dev->l2p);
+	free(dev->p2l);
+	free(dev->heat);
+	free(dev->blocks);
+	free(dev->free_blocks);
+	free(dev);
+}
+
+static int ftl_dev_alloc(struct thread_data *td, struct fio_file *f,
+			 struct ftl_dev **devp)
+{
+	struct ftl_options *o = td->eo;
+	struct ftl_data *fd = td->io_ops->data;
+	struct ftl_dev *dev;
+	uint64_t nr_lpages, nr_blocks, lblocks;
+	unsigned int i;
+
+	nr_lpages = f->io_size / fd->page_size;
+	if (!nr_lpages) {
+		log_err("ftl: %s is smaller than a page\n", f->file_name);
+		return EINVAL;
+	}
+
+	lblocks = (nr_lpages + fd->ppb - 1) / fd->ppb;
+	nr_blocks = (lblocks * (100 + o->op) + 99) / 100;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return ENOMEM;
+
+	dev->gc_free = o->gc_free;
+	if (!dev->gc_free)
+		dev->gc_free = FTL_STREAM_NR;
+
+	/*
+	 * There must always be room for the open blocks and for GC to
+	 * relocate a victim, no matter how small the over-provisioning
+	 */
+	if (nr_blocks < lblocks + FTL_STREAM_NR + dev->gc_free)
+		nr_blocks = lblocks + FTL_STREAM_NR + dev->gc_free;
+
+	if (nr_blocks * fd->ppb >= FTL_PAGE_NONE) {
+		log_err("ftl: %s has too many pages\n", f->file_name);
+		free(dev);
+		return EINVAL;
+	}
+
+	dev->nr_lpages = nr_lpages;
+	dev->nr_blocks = nr_blocks;
+	dev->nr_ppages = nr_blocks * fd->ppb;
+	dev->next_decay = nr_lpages;
+
+	dev->l2p = malloc(dev->nr_lpages * sizeof(uint32_t));
+	dev->p2l = malloc(dev->nr_ppages * sizeof(uint32_t));
+	dev->heat = calloc(dev->nr_lpages, 1);
+	dev->blocks = calloc(dev->nr_blocks, sizeof(struct ftl_block));
+	dev->free_blocks = malloc(dev->nr_blocks * sizeof(uint32_t));
+	if (!dev->l2p || !dev->p2l || !dev->heat || !dev->blocks ||
+	    !dev->free_blocks) {
+		log_err("ftl: failed allocating mapping tables\n");
+		ftl_dev_free(dev);
+		return ENOMEM;
+	}
+
+	memset(dev->l2p, 0xff, dev->nr_lpages * sizeof(uint32_t));
+	memset(dev->p2l, 0xff, dev->nr_ppages * sizeof(uint32_t));
+
+	/*
+	 * Pop from the end, so hand out block 0 first
+	 */
+	for (i = 0; i < dev->nr_blocks; i++)
+		dev->free_blocks[i] = dev->nr_blocks - 1 - i;
+	dev->nr_free = dev->nr_blocks;
+
+	for (i = 0; i < FTL_STREAM_NR; i++)
+		dev->open[i] = FTL_BLOCK_NONE;
+
+	td->ts.ftl_map_bytes += ftl_dev_map_bytes(dev);
+	*devp = dev;
+	return 0;
+}
+
+static int ftl_backing_io(struct thread_data *td, struct fio_file *f,
+			  enum fio_ddir ddir, void *buf, uint32_t ppage,
+			  unsigned int nr_pages)
+{
+	struct ftl_data *fd = td->io_ops->data;
+	size_t len = (size_t) nr_pages * fd->page_size;
+	off_t off = f->file_offset + (uint64_t) ppage * fd->page_size;
+	ssize_t ret;
+
+	while (len) {
+		if (ddir == DDIR_READ)
+			ret = pread(f->fd, buf, len, off);
+		else
+			ret = pwrite(f->fd, buf, len, off);
+
+		if (ret < 0)
+			return errno;
+		if (!ret)
+			return EIO;
+
+		buf += ret;
+		off += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void ftl_invalidate(struct ftl_data *fd, struct ftl_dev *dev,
+			   uint32_t lpage)
+{
+	uint32_t ppage = dev->l2p[lpage];
+
+	if (ppage == FTL_PAGE_NONE)
+		return;
+
+	dev->p2l[ppage] = FTL_PAGE_NONE;
+	dev->blocks[ppage / fd->ppb].valid--;
+	dev->l2p[lpage] = FTL_PAGE_NONE;
+}
+
+/*
+ * Next physical page of the open block of 'stream', opening a new block
+ * if needed. Returns FTL_PAGE_NONE if no free block is left.
+ */
+static uint32_t ftl_alloc_page(struct ftl_data *fd, struct ftl_dev *dev,
+			       unsigned int stream)
+{
+	struct ftl_block *b;
+	uint32_t bno = dev->open[stream];
+
+	if (bno != FTL_BLOCK_NONE && dev->blocks[bno].wp == fd->ppb) {
+		dev->blocks[bno].state = FTL_BLOCK_FULL;
+		bno = FTL_BLOCK_NONE;
+	}
+
+	if (bno == FTL_BLOCK_NONE) {
+		if (!dev->nr_free)
+			return FTL_PAGE_NONE;
+
+		bno = dev->free_blocks[--dev->nr_free];
+		dev->blocks[bno].state = FTL_BLOCK_OPEN;
+		dev->open[stream] = bno;
+	}
+
+	b = &dev->blocks[bno];
+	b->seq = dev->seq;
+	return bno * fd->ppb + b->wp++;
+}
+
+static void ftl_map(struct ftl_data *fd, struct ftl_dev *dev, uint32_t lpage,
+		    uint32_t ppage)
+{
+	dev->l2p[lpage] = ppage;
+	dev->p2l[ppage] = lpage;
+	dev->blocks[ppage / fd->ppb].valid++;
+}
+
+/*
+ * Linear scan over all blocks. Only full blocks are candidates, the open
+ * ones are still being filled.
+ */
+static uint32_t ftl_pick_victim(struct ftl_options *o, struct ftl_data *fd,
+				struct ftl_dev *dev)
+{
+	uint32_t i, victim = FTL_BLOCK_NONE;
+	double score, best = -1.0;
+
+	for (i = 0; i < dev->nr_blocks; i++) {
+		struct ftl_block *b = &dev->blocks[i];
+
+		if (b->state != FTL_BLOCK_FULL || b->valid == fd->ppb)
+			continue;
+
+		if (!b->valid)
+			return i;
+
+		if (o->gc == FTL_GC_GREEDY)
+			score = fd->ppb - b->valid;
+		else {
+			double u = (double) b->valid / fd->ppb;
+			double age = dev->seq - b->seq + 1;
+
+			score = (1.0 - u) * age / (2.0 * u);
+		}
+
+		if (score > best) {
+			best = score;
+			victim = i;
+		}
+	}
+
+	return victim;
+}
+
+static void ftl_erase(struct thread_data *td, struct ftl_dev *dev,
+		      uint32_t bno)
+{
+	struct ftl_block *b = &dev->blocks[bno];
+
+	b->valid = 0;
+	b->wp = 0;
+	b->erases++;
+	b->state = FTL_BLOCK_FREE;
+	dev->free_blocks[dev->nr_free++] = bno;
+	td->ts.ftl_erases++;
+}
+
+/*
+ * Relocate the valid pages of victim blocks until more than the threshold
+ * of blocks are free again. Each call is accounted as one GC pause.
+ */
+static int ftl_gc(struct thread_data *td, struct fio_file *f,
+		  struct ftl_dev *dev)
+{
+	struct ftl_options *o = td->eo;
+	struct ftl_data *fd = td->io_ops->data;
+	unsigned int stream;
+	struct timeval start;
+	int ret = 0;
+
+	stream = o->hot_cold ? FTL_STREAM_GC : FTL_STREAM_HOT;
+
+	fio_gettime(&start, NULL);
+
+	while (dev->nr_free <= dev->gc_free) {
+		uint32_t victim, ppage, i;
+
+		victim = ftl_pick_victim(o, fd, dev);
+		if (victim == FTL_BLOCK_NONE) {
+			log_err("ftl: no block to reclaim\n");
+			ret = ENOSPC;
+			break;
+		}
+
+		for (i = 0; i < fd->ppb; i++) {
+			uint32_t old = victim * fd->ppb + i;
+			uint32_t lpage = dev->p2l[old];
+
+			if (lpage == FTL_PAGE_NONE)
+				continue;
+
+			ppage = ftl_alloc_page(fd, dev, stream);
+			if (ppage == FTL_PAGE_NONE) {
+				log_err("ftl: out of free blocks during GC\n");
+				ret = ENOSPC;
+				goto out;
+			}
+
+			if (o->backing) {
+				ret = ftl_backing_io(td, f, DDIR_READ,
+						fd->gc_buf, old, 1);
+				if (!ret)
+					ret = ftl_backing_io(td, f, DDIR_WRITE,
+							fd->gc_buf, ppage, 1);
+				if (ret)
+					goto out;
+			}
+
+			ftl_invalidate(fd, dev, lpage);
+			ftl_map(fd, dev, lpage, ppage);
+			td->ts.ftl_gc_writes++;
+		}
+
+		ftl_erase(td, dev, victim);
+	}
+
+out:
+	add_ftl_gc_sample(td, utime_since_now(&start));
+	return ret;
+}
+
+static unsigned int ftl_stream(struct ftl_options *o, struct ftl_dev *dev,
+			       uint32_t lpage)
+{
+	uint32_t i;
+
+	if (dev->heat[lpage] < 255)
+		dev->heat[lpage]++;
+
+	if (++dev->seq == dev->next_decay) {
+		for (i = 0; i < dev->nr_lpages; i++)
+			dev->heat[i] >>= 1;
+		dev->next_decay += dev->nr_lpages;
+	}
+
+	if (!o->hot_cold || dev->heat[lpage] >= FTL_HOT_UPDATES)
+		return FTL_STREAM_HOT;
+
+	return FTL_STREAM_COLD;
+}
+
+static int ftl_write(struct thread_data *td, struct fio_file *f,
+		     struct ftl_dev *dev, uint32_t lpage, unsigned int nr,
+		     void *buf)
+{
+	struct ftl_options *o = td->eo;
+	struct ftl_data *fd = td->io_ops->data;
+	uint32_t run_start = FTL_PAGE_NONE, run_len = 0;
+	void *run_buf = buf;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < nr; i++, lpage++) {
+		unsigned int stream;
+		uint32_t ppage;
+
+		if (dev->nr_free <= dev->gc_free) {
+			/*
+			 * GC may move the open blocks, write out what we
+			 * have so far first
+			 */
+			if (run_len && o->backing) {
+				ret = ftl_backing_io(td, f, DDIR_WRITE, run_buf,
+							run_start, run_len);
+				if (ret)
+					return ret;
+			}
+			run_len = 0;
+
+			ret = ftl_gc(td, f, dev);
+			if (ret)
+				return ret;
+		}
+
+		stream = ftl_stream(o, dev, lpage);
+		ppage = ftl_alloc_page(fd, dev, stream);
+		if (ppage == FTL_PAGE_NONE)
+			return ENOSPC;
+
+		ftl_invalidate(fd, dev, lpage);
+		ftl_map(fd, dev, lpage, ppage);
+		td->ts.ftl_host_writes++;
+
+		if (!o->backing)
+			continue;
+
+		if (run_len && ppage == run_start + run_len) {
+			run_len++;
+			continue;
+		}
+
+		if (run_len) {
+			ret = ftl_backing_io(td, f, DDIR_WRITE, run_buf,
+						run_start, run_len);
+			if (ret)
+				return ret;
+		}
+
+		run_start = ppage;
+		run_len = 1;
+		run_buf = buf + (size_t) i * fd->page_size;
+	}
+
+	if (run_len && o->backing)
+		return ftl_backing_io(td, f, DDIR_WRITE, run_buf, run_start,
+					run_len);
+
+	return 0;
+}
+
+static int ftl_read(struct thread_data *td, struct fio_file *f,
+		    struct ftl_dev *dev, uint32_t lpage, unsigned int nr,
+		    void *buf)
+{
+	struct ftl_options *o = td->eo;
+	struct ftl_data *fd = td->io_ops->data;
+	uint32_t run_start = FTL_PAGE_NONE, run_len = 0;
+	void *run_buf = buf;
+	unsigned int i;
+	int ret;
+
+	if (!o->backing)
+		return 0;
+
+	for (i = 0; i < nr; i++, lpage++) {
+		uint32_t ppage = dev->l2p[lpage];
+		void *p = buf + (size_t) i * fd->page_size;
+
+		if (run_len && ppage == run_start + run_len) {
+			run_len++;
+			continue;
+		}
+
+		if (run_len) {
+			ret = ftl_backing_io(td, f, DDIR_READ, run_buf,
+						run_start, run_len);
+			if (ret)
+				return ret;
+			run_len = 0;
+		}
+
+		/*
+		 * Never written, reads back as zeroes like a fresh device
+		 */
+		if (ppage == FTL_PAGE_NONE) {
+			memset(p, 0, fd->page_size);
+			continue;
+		}
+
+		run_start = ppage;
+		run_len = 1;
+		run_buf = p;
+	}
+
+	if (run_len)
+		return ftl_backing_io(td, f, DDIR_READ, run_buf, run_start,
+					run_len);
+
+	return 0;
+}
+
+static int fio_ftl_queue(struct thread_data *td, struct io_u *io_u)
+{
+	struct ftl_data *fd = td->io_ops->data;
+	struct fio_file *f = io_u->file;
+	struct ftl_dev *dev = fd->devs[f->fileno];
+	unsigned long long off;
+	uint32_t lpage, nr, i;
+	int ret = 0;
+
+	fio_ro_check(td, io_u);
+
+	if (io_u->ddir == DDIR_SYNC || io_u->ddir == DDIR_DATASYNC) {
+		struct ftl_options *o = td->eo;
+
+		if (o->backing && do_io_u_sync(td, io_u) < 0)
+			io_u->error = errno;
+		goto out;
+	}
+
+	off = io_u->offset - f->file_offset;
+	if ((off % fd->page_size) || (io_u->xfer_buflen % fd->page_size)) {
+		io_u->error = EINVAL;
+		goto out;
+	}
+
+	lpage = off / fd->page_size;
+	nr = io_u->xfer_buflen / fd->page_size;
+	if (lpage + nr > dev->nr_lpages) {
+		io_u->error = EINVAL;
+		goto out;
+	}
+
+	if (io_u->ddir == DDIR_READ)
+		ret = ftl_read(td, f, dev, lpage, nr, io_u->xfer_buf);
+	else if (io_u->ddir == DDIR_WRITE)
+		ret = ftl_write(td, f, dev, lpage, nr, io_u->xfer_buf);
+	else if (io_u->ddir == DDIR_TRIM) {
+		for (i = 0; i < nr; i++)
+			ftl_invalidate(fd, dev, lpage + i);
+	}
+
+	io_u->error = ret;
+out:
+	if (io_u->error)
+		td_verror(td, io_u->error, "xfer");
+
+	return FIO_Q_COMPLETED;
+}
+
+static int fio_ftl_open_file(struct thread_data *td, struct fio_file *f)
+{
+	struct ftl_options *o = td->eo;
+	struct ftl_data *fd = td->io_ops->data;
+	struct ftl_dev *dev;
+	uint64_t size;
+	int ret, err = EINVAL;
+
+	ret = generic_open_file(td, f);
+	if (ret)
+		return ret;
+
+	if (f->fileno >= fd->nr_devs) {
+		unsigned int nr = f->fileno + 1;
+		struct ftl_dev **devs;
+
+		devs = realloc(fd->devs, nr * sizeof(struct ftl_dev *));
+		if (!devs) {
+			err = ENOMEM;
+			goto err;
+		}
+		memset(&devs[fd->nr_devs], 0,
+			(nr - fd->nr_devs) * sizeof(struct ftl_dev *));
+		fd->devs = devs;
+		fd->nr_devs = nr;
+	}
+
+	dev = fd->devs[f->fileno];
+	if (!dev) {
+		err = ftl_dev_alloc(td, f, &dev);
+		if (err)
+			goto err;
+		fd->devs[f->fileno] = dev;
+	}
+
+	if (!o->backing)
+		return 0;
+
+	/*
+	 * The physical pages, over-provisioning included, live in the file
+	 */
+	size = f->file_offset + (uint64_t) dev->nr_ppages * fd->page_size;
+	if (f->real_file_size >= size)
+		return 0;
+
+	if (f->filetype == FIO_TYPE_FILE && !ftruncate(f->fd, size)) {
+		f->real_file_size = size;
+		return 0;
+	}
+
+	log_err("ftl: %s needs %llu bytes for the physical pages\n",
+			f->file_name, (unsigned long long) size);
+err:
+	td_verror(td, err, "ftl open");
+	ret = generic_close_file(td, f);
+	return ret ? ret : 1;
+}
+
+static void fio_ftl_cleanup(struct thread_data *td)
+{
+	struct ftl_data *fd = td->io_ops->data;
+	unsigned int i;
+
+	if (!fd)
+		return;
+
+	for (i = 0; i < fd->nr_devs; i++) {
+		if (fd->devs[i])
+			ftl_dev_free(fd->devs[i]);
+	}
+
+	free(fd->devs);
+	free(fd->gc_buf);
+	free(fd);
+	td->io_ops->data = NULL;
+}
+
+static int fio_ftl_init(struct thread_data *td)
+{
+	struct ftl_options *o = td->eo;
+	struct ftl_data *fd;
+	unsigned int page_size, ppb;
+	int i;
+
+	page_size = o->page_size ? o->page_size : td_nvm_page_size(td);
+	ppb = o->ppb ? o->ppb : td->o.nvm_pages_per_block;
+
+	if (page_size < 512 || (page_size & 511)) {
+		log_err("ftl: page size must be a multiple of 512\n");
+		return 1;
+	}
+	if (ppb < 2) {
+		log_err("ftl: need at least 2 pages per block\n");
+		return 1;
+	}
+
+	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
+		if (!td->o.min_bs[i])
+			continue;
+		if ((td->o.min_bs[i] % page_size) ||
+		    (td->o.max_bs[i] % page_size) ||
+		    (td->o.ba[i] % page_size)) {
+			log_err("ftl: bs and ba must be multiples of the %u"
+				" byte FTL page\n", page_size);
+			return 1;
+		}
+	}
+
+	fd = calloc(1, sizeof(*fd));
+	if (!fd) {
+		td_verror(td, ENOMEM, "ftl init");
+		return 1;
+	}
+	fd->page_size = page_size;
+	fd->ppb = ppb;
+	fd->nr_devs = td->o.nr_files;
+	fd->devs = calloc(fd->nr_devs, sizeof(struct ftl_dev *));
+	if (!fd->devs && fd->nr_devs) {
+		td_verror(td, ENOMEM, "ftl init");
+		free(fd);
+		return 1;
+	}
+
+	if (o->backing && posix_memalign(&fd->gc_buf, page_size, page_size)) {
+		log_err("ftl: failed allocating GC buffer\n");
+		free(fd->devs);
+		free(fd);
+		return 1;
+	}
+
+	td->io_ops->data = fd;
+	td->ts.ftl_page_size = page_size;
+	return 0;
+}
+
+static struct ioengine_ops ioengine = {
+	.name			= "ftl",
+	.version		= FIO_IOOPS_VERSION,
+	.init			= fio_ftl_init,
+	.cleanup		= fio_ftl_cleanup,
+	.queue			= fio_ftl_queue,
+	.open_file		= fio_ftl_open_file,
+	.close_file		= generic_close_file,
+	.get_file_size		= generic_get_file_size,
+	.flags			= FIO_SYNCIO,
+	.options		= options,
+	.option_struct_size	= sizeof(struct ftl_options),
+};
+
+static void fio_init fio_ftl_register(void)
+{
+	register_ioengine(&ioengine);
+}
+
+static void fio_exit fio_ftl_unregister(void)
+{
+	unregister_ioengine(&ioengine);
+}
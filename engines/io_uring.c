@@ -0,0 +1,770 @@
+/*
+ * io_uring engine
+ *
+ * IO engine using the Linux io_uring interface. Submission and completion
+ * queues are shared with the kernel, so queueing and reaping IO is done
+ * with loads and stores to the rings, and a single io_uring_enter(2) both
+ * submits a batch and waits for completions. With sqthread_poll a kernel
+ * thread picks up submissions and no system call is needed to submit.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "../fio.h"
+
+struct io_sq_ring {
+	unsigned *head;
+	unsigned *tail;
+	unsigned *ring_mask;
+	unsigned *ring_entries;
+	unsigned *flags;
+	unsigned *array;
+};
+
+struct io_cq_ring {
+	unsigned *head;
+	unsigned *tail;
+	unsigned *ring_mask;
+	unsigned *ring_entries;
+	struct io_uring_cqe *cqes;
+};
+
+struct ioring_mmap {
+	void *ptr;
+	size_t len;
+};
+
+struct ioring_data {
+	int ring_fd;
+
+	struct io_u **io_u_index;
+
+	struct io_sq_ring sq_ring;
+	struct io_uring_sqe *sqes;
+	struct iovec *iovecs;
+	unsigned sq_ring_mask;
+
+	struct io_cq_ring cq_ring;
+	unsigned cq_ring_mask;
+
+	int *fds;
+
+	int queued;
+	int cq_ring_off;
+	unsigned iodepth;
+
+	/*
+	 * Completions taken off the ring while submitting, handed out by
+	 * the next ->getevents() before the ones still in the ring
+	 */
+	struct io_uring_cqe *held;
+	unsigned held_nr;
+	unsigned held_ret;
+
+	struct ioring_mmap mmap[3];
+};
+
+struct ioring_options {
+	struct thread_data *td;
+	unsigned int hipri;
+	unsigned int fixedbufs;
+	unsigned int registerfiles;
+	unsigned int sqpoll_thread;
+	unsigned int sqpoll_set;
+	unsigned int sqpoll_cpu;
+	unsigned int sqpoll_idle;
+};
+
+static int fio_ioring_sqpoll_cb(void *data, unsigned long long *val)
+{
+	struct ioring_options *o = data;
+
+	o->sqpoll_cpu = *val;
+	o->sqpoll_set = 1;
+	return 0;
+}
+
+static struct fio_option options[] = {
+	{
+		.name	= "hipri",
+		.lname	= "High Priority",
+		.type	= FIO_OPT_STR_SET,
+		.off1	= offsetof(struct ioring_options, hipri),
+		.help	= "Use polled IO completions",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= "fixedbufs",
+		.lname	= "Fixed (pre-mapped) IO buffers",
+		.type	= FIO_OPT_STR_SET,
+		.off1	= offsetof(struct ioring_options, fixedbufs),
+		.help	= "Pre map IO buffers",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= "registerfiles",
+		.lname	= "Register file set",
+		.type	= FIO_OPT_STR_SET,
+		.off1	= offsetof(struct ioring_options, registerfiles),
+		.help	= "Pre-open/register files",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= "sqthread_poll",
+		.lname	= "Kernel SQ thread polling",
+		.type	= FIO_OPT_STR_SET,
+		.off1	= offsetof(struct ioring_options, sqpoll_thread),
+		.help	= "Offload submission/completion to kernel thread",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= "sqthread_poll_cpu",
+		.lname	= "SQ Thread Poll CPU",
+		.type	= FIO_OPT_INT,
+		.cb	= fio_ioring_sqpoll_cb,
+		.help	= "What CPU to run SQ thread polling on",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= "sqthread_poll_idle",
+		.lname	= "SQ Thread Poll idle time",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct ioring_options, sqpoll_idle),
+		.help	= "Milliseconds the SQ thread spins before sleeping",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+static int io_uring_enter(struct ioring_data *ld, unsigned int to_submit,
+			  unsigned int min_complete, unsigned int flags)
+{
+	return syscall(__NR_sys_io_uring_enter, ld->ring_fd, to_submit,
+			min_complete, flags, NULL, 0);
+}
+
+static int fio_ioring_prep(struct thread_data *td, struct io_u *io_u)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct ioring_options *o = td->eo;
+	struct fio_file *f = io_u->file;
+	struct io_uring_sqe *sqe;
+
+	sqe = &ld->sqes[io_u->index];
+	memset(sqe, 0, sizeof(*sqe));
+
+	if (o->registerfiles) {
+		sqe->fd = f->engine_data;
+		sqe->flags = IOSQE_FIXED_FILE;
+	} else
+		sqe->fd = f->fd;
+
+	if (ddir_rw(io_u->ddir)) {
+		if (o->fixedbufs) {
+			if (io_u->ddir == DDIR_READ)
+				sqe->opcode = IORING_OP_READ_FIXED;
+			else
+				sqe->opcode = IORING_OP_WRITE_FIXED;
+			sqe->addr = (unsigned long) io_u->xfer_buf;
+			sqe->len = io_u->xfer_buflen;
+			sqe->buf_index = io_u->index;
+		} else {
+			struct iovec *iov = &ld->iovecs[io_u->index];
+
+			if (io_u->ddir == DDIR_READ)
+				sqe->opcode = IORING_OP_READV;
+			else
+				sqe->opcode = IORING_OP_WRITEV;
+			iov->iov_base = io_u->xfer_buf;
+			iov->iov_len = io_u->xfer_buflen;
+			sqe->addr = (unsigned long) iov;
+			sqe->len = 1;
+		}
+		sqe->off = io_u->offset;
+	} else if (io_u->ddir == DDIR_SYNC || io_u->ddir == DDIR_DATASYNC) {
+		sqe->opcode = IORING_OP_FSYNC;
+		if (io_u->ddir == DDIR_DATASYNC)
+			sqe->fsync_flags |= IORING_FSYNC_DATASYNC;
+	}
+
+	sqe->user_data = (unsigned long) io_u;
+	return 0;
+}
+
+static struct io_u *fio_ioring_event(struct thread_data *td, int event)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct io_uring_cqe *cqe;
+	struct io_u *io_u;
+	unsigned index;
+
+	if ((unsigned) event < ld->held_ret)
+		cqe = &ld->held[event];
+	else {
+		index = (event - ld->held_ret + ld->cq_ring_off) &
+				ld->cq_ring_mask;
+		cqe = &ld->cq_ring.cqes[index];
+	}
+	io_u = (struct io_u *) (uintptr_t) cqe->user_data;
+
+	if (cqe->res != io_u->xfer_buflen) {
+		if (cqe->res > io_u->xfer_buflen)
+			io_u->error = -cqe->res;
+		else
+			io_u->resid = io_u->xfer_buflen - cqe->res;
+	} else
+		io_u->error = 0;
+
+	return io_u;
+}
+
+static int fio_ioring_cqring_reap(struct thread_data *td, unsigned int events,
+				  unsigned int max)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct io_cq_ring *ring = &ld->cq_ring;
+	unsigned head, reaped = 0;
+
+	head = *ring->head;
+	do {
+		read_barrier();
+		if (head == *ring->tail)
+			break;
+		reaped++;
+		head++;
+	} while (reaped + events < max);
+
+	*ring->head = head;
+	write_barrier();
+	return reaped;
+}
+
+/*
+ * Forget the held completions the last ->getevents() handed out
+ */
+static void fio_ioring_held_drop(struct ioring_data *ld)
+{
+	if (!ld->held_ret)
+		return;
+
+	ld->held_nr -= ld->held_ret;
+	memmove(ld->held, ld->held + ld->held_ret,
+		ld->held_nr * sizeof(*ld->held));
+	ld->held_ret = 0;
+}
+
+/*
+ * Make room in the completion ring when submission runs into a full one.
+ * The completions are copied aside, not dropped, as fio still has to
+ * see them.
+ */
+static int fio_ioring_cqring_hold(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct io_cq_ring *ring = &ld->cq_ring;
+	unsigned head, held = 0;
+
+	fio_ioring_held_drop(ld);
+
+	head = *ring->head;
+	while (ld->held_nr < ld->iodepth) {
+		read_barrier();
+		if (head == *ring->tail)
+			break;
+		ld->held[ld->held_nr++] = ring->cqes[head & ld->cq_ring_mask];
+		held++;
+		head++;
+	}
+
+	*ring->head = head;
+	write_barrier();
+	return held;
+}
+
+static int fio_ioring_getevents(struct thread_data *td, unsigned int min,
+				unsigned int max, struct timespec *t)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	unsigned actual_min = td->o.iodepth_batch_complete == 0 ? 0 : min;
+	struct ioring_options *o = td->eo;
+	struct io_cq_ring *ring = &ld->cq_ring;
+	unsigned events = 0;
+	int r;
+
+	/*
+	 * Completions held back by ->commit() go first, as events
+	 * 0..held_ret-1. Any beyond max are left for the next call.
+	 */
+	fio_ioring_held_drop(ld);
+	ld->held_ret = ld->held_nr < max ? ld->held_nr : max;
+	events = ld->held_ret;
+
+	ld->cq_ring_off = *ring->head;
+	if (events >= max)
+		return events;
+
+	do {
+		r = fio_ioring_cqring_reap(td, events, max);
+		if (r) {
+			events += r;
+			continue;
+		}
+
+		/*
+		 * Without the SQ thread, polled completions are only found
+		 * by entering the kernel, even when we don't want to wait.
+		 * The kernel counts what is left in the ring, so only wait
+		 * for the events still missing.
+		 */
+		if (!o->sqpoll_thread) {
+			r = io_uring_enter(ld, 0, actual_min > events ?
+						actual_min - events : 0,
+						IORING_ENTER_GETEVENTS);
+			if (r < 0) {
+				if (errno == EAGAIN || errno == EINTR)
+					continue;
+				r = -errno;
+				td_verror(td, errno, "io_uring_enter");
+				break;
+			}
+		}
+	} while (events < min);
+
+	return r < 0 ? r : events;
+}
+
+static int fio_ioring_queue(struct thread_data *td, struct io_u *io_u)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct io_sq_ring *ring = &ld->sq_ring;
+	unsigned tail, next_tail;
+
+	fio_ro_check(td, io_u);
+
+	if (ld->queued == (int) ld->iodepth)
+		return FIO_Q_BUSY;
+
+	/*
+	 * Trims and sync_file_range aren't queued, they are done inline
+	 * once everything in flight has completed
+	 */
+	if (io_u->ddir == DDIR_TRIM || io_u->ddir == DDIR_SYNC_FILE_RANGE) {
+		if (ld->queued)
+			return FIO_Q_BUSY;
+
+		if (io_u->ddir == DDIR_TRIM)
+			do_io_u_trim(td, io_u);
+		else
+			do_io_u_sync(td, io_u);
+		return FIO_Q_COMPLETED;
+	}
+
+	tail = *ring->tail;
+	next_tail = tail + 1;
+	read_barrier();
+	if (next_tail == *ring->head)
+		return FIO_Q_BUSY;
+
+	ring->array[tail & ld->sq_ring_mask] = io_u->index;
+	write_barrier();
+	*ring->tail = next_tail;
+	write_barrier();
+
+	ld->queued++;
+	return FIO_Q_QUEUED;
+}
+
+static void fio_ioring_queued(struct thread_data *td, int start, int nr)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct timeval now;
+
+	if (!fio_fill_issue_time(td))
+		return;
+
+	fio_gettime(&now, NULL);
+
+	while (nr--) {
+		struct io_sq_ring *ring = &ld->sq_ring;
+		int index = ring->array[start & ld->sq_ring_mask];
+		struct io_u *io_u = ld->io_u_index[index];
+
+		memcpy(&io_u->issue_time, &now, sizeof(now));
+		io_u_queued(td, io_u);
+
+		start++;
+	}
+}
+
+static int fio_ioring_commit(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct ioring_options *o = td->eo;
+	int ret;
+
+	if (!ld->queued)
+		return 0;
+
+	/*
+	 * With SQ polling the kernel thread consumes the ring by itself, it
+	 * only needs to be woken up if it went idle
+	 */
+	if (o->sqpoll_thread) {
+		struct io_sq_ring *ring = &ld->sq_ring;
+
+		read_barrier();
+		if (*ring->flags & IORING_SQ_NEED_WAKEUP)
+			io_uring_enter(ld, ld->queued, 0,
+					IORING_ENTER_SQ_WAKEUP);
+		fio_ioring_queued(td, *ring->tail - ld->queued, ld->queued);
+		io_u_mark_submit(td, ld->queued);
+		ld->queued = 0;
+		return 0;
+	}
+
+	do {
+		unsigned start = *ld->sq_ring.head;
+		long nr = ld->queued;
+
+		ret = io_uring_enter(ld, nr, 0, IORING_ENTER_GETEVENTS);
+		if (ret > 0) {
+			fio_ioring_queued(td, start, ret);
+			io_u_mark_submit(td, ret);
+
+			ld->queued -= ret;
+			ret = 0;
+		} else if (!ret) {
+			io_u_mark_submit(td, ret);
+			continue;
+		} else {
+			if (errno == EAGAIN || errno == EINTR) {
+				/*
+				 * The completion ring belongs to the reaper
+				 * thread if there is one
+				 */
+				ret = 0;
+				if (!td->o.reap_thread)
+					ret = fio_ioring_cqring_hold(td);
+				if (ret) {
+					ret = 0;
+					continue;
+				}
+				/* Shouldn't happen */
+				usleep(1);
+				continue;
+			}
+			td_verror(td, errno, "io_uring_enter submit");
+			break;
+		}
+	} while (ld->queued);
+
+	return ret;
+}
+
+static void fio_ioring_unmap(struct ioring_data *ld)
+{
+	int i;
+
+	for (i = 0; i < (int) ARRAY_SIZE(ld->mmap); i++)
+		if (ld->mmap[i].ptr)
+			munmap(ld->mmap[i].ptr, ld->mmap[i].len);
+	close(ld->ring_fd);
+}
+
+static void fio_ioring_cleanup(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	unsigned int i;
+
+	if (ld) {
+		if (ld->ring_fd != -1)
+			fio_ioring_unmap(ld);
+
+		if (ld->fds) {
+			for (i = 0; i < td->files_index; i++)
+				if (ld->fds[i] != -1)
+					close(ld->fds[i]);
+		}
+
+		free(ld->io_u_index);
+		free(ld->iovecs);
+		free(ld->held);
+		free(ld->fds);
+		free(ld);
+	}
+}
+
+static int fio_ioring_mmap(struct ioring_data *ld, struct io_uring_params *p)
+{
+	struct io_sq_ring *sring = &ld->sq_ring;
+	struct io_cq_ring *cring = &ld->cq_ring;
+	void *ptr;
+
+	ld->mmap[0].len = p->sq_off.array + p->sq_entries * sizeof(__u32);
+	ptr = mmap(0, ld->mmap[0].len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ld->ring_fd,
+			IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		return -errno;
+	ld->mmap[0].ptr = ptr;
+	sring->head = ptr + p->sq_off.head;
+	sring->tail = ptr + p->sq_off.tail;
+	sring->ring_mask = ptr + p->sq_off.ring_mask;
+	sring->ring_entries = ptr + p->sq_off.ring_entries;
+	sring->flags = ptr + p->sq_off.flags;
+	sring->array = ptr + p->sq_off.array;
+	ld->sq_ring_mask = *sring->ring_mask;
+
+	ld->mmap[1].len = p->sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(0, ld->mmap[1].len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ld->ring_fd,
+			IORING_OFF_SQES);
+	if (ptr == MAP_FAILED)
+		return -errno;
+	ld->mmap[1].ptr = ptr;
+	ld->sqes = ptr;
+
+	ld->mmap[2].len = p->cq_off.cqes +
+				p->cq_entries * sizeof(struct io_uring_cqe);
+	ptr = mmap(0, ld->mmap[2].len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ld->ring_fd,
+			IORING_OFF_CQ_RING);
+	if (ptr == MAP_FAILED)
+		return -errno;
+	ld->mmap[2].ptr = ptr;
+	cring->head = ptr + p->cq_off.head;
+	cring->tail = ptr + p->cq_off.tail;
+	cring->ring_mask = ptr + p->cq_off.ring_mask;
+	cring->ring_entries = ptr + p->cq_off.ring_entries;
+	cring->cqes = ptr + p->cq_off.cqes;
+	ld->cq_ring_mask = *cring->ring_mask;
+	return 0;
+}
+
+static int fio_ioring_queue_init(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct ioring_options *o = td->eo;
+	int depth = td->o.iodepth;
+	struct io_uring_params p;
+	int ret;
+
+	memset(&p, 0, sizeof(p));
+
+	if (o->hipri)
+		p.flags |= IORING_SETUP_IOPOLL;
+	if (o->sqpoll_thread) {
+		p.flags |= IORING_SETUP_SQPOLL;
+		p.sq_thread_idle = o->sqpoll_idle;
+		if (o->sqpoll_set) {
+			p.flags |= IORING_SETUP_SQ_AFF;
+			p.sq_thread_cpu = o->sqpoll_cpu;
+		}
+	}
+
+	ret = syscall(__NR_sys_io_uring_setup, depth, &p);
+	if (ret < 0)
+		return -errno;
+
+	ld->ring_fd = ret;
+
+	ret = fio_ioring_mmap(ld, &p);
+	if (ret)
+		return ret;
+
+	return 0;
+}
+
+/*
+ * One fixed buffer per io_u, indexed like the io_us so a submission
+ * only has to name its io_u
+ */
+static int fio_ioring_register_buffers(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct iovec *iovecs;
+	struct io_u *io_u;
+	int i, ret;
+
+	iovecs = calloc(ld->iodepth, sizeof(struct iovec));
+	if (!iovecs)
+		return -ENOMEM;
+
+	io_u_qiter(&td->io_u_all, io_u, i) {
+		iovecs[io_u->index].iov_base = io_u->buf;
+		iovecs[io_u->index].iov_len = td_max_bs(td);
+	}
+
+	ret = syscall(__NR_sys_io_uring_register, ld->ring_fd,
+			IORING_REGISTER_BUFFERS, iovecs, ld->iodepth);
+	if (ret < 0)
+		ret = -errno;
+
+	free(iovecs);
+	return ret;
+}
+
+/*
+ * Registered files are opened once here and stay open for the job,
+ * ->open_file and ->close_file only hand out the descriptor
+ */
+static int fio_ioring_register_files(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct fio_file *f;
+	unsigned int i;
+	int ret;
+
+	ld->fds = calloc(td->files_index, sizeof(int));
+	if (!ld->fds)
+		return -ENOMEM;
+
+	for (i = 0; i < td->files_index; i++)
+		ld->fds[i] = -1;
+
+	for_each_file(td, f, i) {
+		ret = generic_open_file(td, f);
+		if (ret)
+			return -EINVAL;
+		ld->fds[i] = f->fd;
+		f->engine_data = i;
+		f->fd = -1;
+	}
+
+	ret = syscall(__NR_sys_io_uring_register, ld->ring_fd,
+			IORING_REGISTER_FILES, ld->fds, td->files_index);
+	if (ret < 0)
+		return -errno;
+
+	return 0;
+}
+
+static int fio_ioring_init(struct thread_data *td)
+{
+	struct ioring_options *o = td->eo;
+	struct ioring_data *ld;
+	struct io_u *io_u;
+	int i, err;
+
+	/*
+	 * Polled IO only works for O_DIRECT
+	 */
+	if (o->hipri && !td->o.odirect) {
+		log_err("fio: io_uring hipri requires direct=1\n");
+		return 1;
+	}
+
+	ld = calloc(1, sizeof(*ld));
+	if (!ld) {
+		td_verror(td, ENOMEM, "io_uring init");
+		return 1;
+	}
+	ld->ring_fd = -1;
+	ld->iodepth = td->o.iodepth;
+	td->io_ops->data = ld;
+
+	ld->io_u_index = calloc(ld->iodepth, sizeof(struct io_u *));
+	ld->iovecs = calloc(ld->iodepth, sizeof(struct iovec));
+	ld->held = calloc(ld->iodepth, sizeof(struct io_uring_cqe));
+	if (!ld->io_u_index || !ld->iovecs || !ld->held) {
+		td_verror(td, ENOMEM, "io_uring init");
+		return 1;
+	}
+
+	io_u_qiter(&td->io_u_all, io_u, i)
+		ld->io_u_index[io_u->index] = io_u;
+
+	err = fio_ioring_queue_init(td);
+	if (err) {
+		td_verror(td, -err, "io_uring_setup");
+		return 1;
+	}
+
+	if (o->fixedbufs) {
+		err = fio_ioring_register_buffers(td);
+		if (err) {
+			td_verror(td, -err, "io_uring_register buffers");
+			return 1;
+		}
+		td->io_ops->flags |= FIO_OWNBUF;
+	}
+
+	if (o->registerfiles) {
+		err = fio_ioring_register_files(td);
+		if (err) {
+			td_verror(td, -err, "io_uring_register files");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int fio_ioring_open_file(struct thread_data *td, struct fio_file *f)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct ioring_options *o = td->eo;
+
+	if (!ld || !ld->fds || !o->registerfiles)
+		return generic_open_file(td, f);
+
+	f->fd = ld->fds[f->engine_data];
+	return 0;
+}
+
+static int fio_ioring_close_file(struct thread_data *td, struct fio_file *f)
+{
+	struct ioring_data *ld = td->io_ops->data;
+	struct ioring_options *o = td->eo;
+
+	if (!ld || !ld->fds || !o->registerfiles)
+		return generic_close_file(td, f);
+
+	f->fd = -1;
+	return 0;
+}
+
+static struct ioengine_ops ioengine = {
+	.name			= "io_uring",
+	.version		= FIO_IOOPS_VERSION,
+	.init			= fio_ioring_init,
+	.prep			= fio_ioring_prep,
+	.queue			= fio_ioring_queue,
+	.commit			= fio_ioring_commit,
+	.getevents		= fio_ioring_getevents,
+	.event			= fio_ioring_event,
+	.cleanup		= fio_ioring_cleanup,
+	.open_file		= fio_ioring_open_file,
+	.close_file		= fio_ioring_close_file,
+	.get_file_size		= generic_get_file_size,
+	.options		= options,
+	.option_struct_size	= sizeof(struct ioring_options),
+	.flags			= FIO_ASYNC_REAP,
+};
+
+static void fio_init fio_ioring_register(void)
+{
+	register_ioengine(&ioengine);
+}
+
+static void fio_exit fio_ioring_unregister(void)
+{
+	unregister_ioengine(&ioengine);
+}
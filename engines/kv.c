@@ -3,6 +3,46 @@
  *
  * IO engine that utilizes the key-value IOCTL for submitting KV specific requests.
  *
+ * The KV ioctl is synchronous, so to keep more than one command in flight
+ * the engine hands queued io_us to a pool of submission workers that each
+ * issue the ioctl on behalf of the job. Completions are collected on a
+ * shared list and reaped through ->getevents()/->event(). With iodepth=1
+ * the worker pool is skipped and the ioctl is issued inline.
+ *
+ * Keys are derived from the io_u offset, so the regular offset generators
+ * (sequential, random, zipf, pareto, lfsr, random map) pick the key. Block
+ * N of the file maps to key N, rendered as <prefix><N> in the configured
+ * encoding and padded to kv_key_len bytes.
+ *
+ * Reads are issued as GET, trims as DEL and writes as PUT or UPDATE, as
+ * set by kv_update_percentage. Completion latency is accounted per
+ * opcode in addition to the per data direction numbers.
+ *
+ * kv_key_split and kv_value_split give key and value lengths a bssplit
+ * style distribution. The length is picked from a hash of the block
+ * number, so a given key always has the same length and value size no
+ * matter which opcode touches it. With a value split each block is a
+ * slot of bs bytes holding a value of up to bs bytes, and only the value
+ * bytes are accounted as transferred.
+ *
+ * With kv_verify, every PUT and UPDATE value starts with a header holding
+ * the key hash, a per key generation number and a checksum of the rest
+ * of the value, and GETs are checked as they complete. Instead of
+ * logging every write, two generation counters per key are kept in flat
+ * tables sized by the key space, so memory does not grow with the number
+ * of values written: the last generation issued, and the last generation
+ * completed along with whether the key should exist. A GET must return a
+ * generation between the one completed when the GET was issued and the
+ * last one issued when it completes, which allows for a write racing
+ * with the GET. Writes to the same key are never in flight together, as
+ * the device may apply them in either order.
+ *
+ * The kvsim engine runs the same code, but instead of the ioctl each
+ * command is executed against an in memory hash table that follows the
+ * device semantics. Optionally every command is delayed according to a
+ * per opcode latency and bandwidth model. It needs no device, so the KV
+ * path can be benchmarked and tested anywhere.
+ *
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,8 +50,11 @@
 #include <errno.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "../fio.h"
+#include "../hash.h"
+#include "../crc/crc32c.h"
 
 enum vsl_kv_opcode
 {
@@ -19,6 +62,11 @@ enum vsl_kv_opcode
 	VSL_KV_PUT	= 0x01,
 	VSL_KV_UPDATE	= 0x02,
 	VSL_KV_DEL	= 0x03,
+	VSL_KV_NR,
+};
+
+static const char *vsl_kv_opcode_names[VSL_KV_NR] = {
+	"GET", "PUT", "UPDATE", "DEL",
 };
 
 struct __attribute__((packed)) vsl_kv_cmd
@@ -39,90 +87,1290 @@ struct __attribute__((packed)) vsl_kv_cmd
 enum vsl_error {
 	VSLKV_ERR_OPEN = 1,
 	VSLKV_ERR_IOCTL,
+	VSLKV_ERR_NOKEY,
 };
 
-struct kvio_data {
+#define KV_KEY_MAX	255
+
+enum {
+	KV_KEY_ENC_HEX	= 0,
+	KV_KEY_ENC_DEC,
+	KV_KEY_ENC_BIN,
+};
+
+/*
+ * Prepended to values with kv_verify. The checksum covers the value
+ * bytes following the header.
+ */
+#define KV_VHDR_MAGIC	0x6b76484eU
+
+struct kv_vhdr {
+	uint32_t magic;
+	uint32_t len;
+	uint32_t key_hash;
+	uint32_t gen;
+	uint32_t crc32c;
+	uint32_t pad;
+};
+
+/*
+ * Set in the completed generation if the key holds a value, and in the
+ * issued generation while a PUT, UPDATE or DEL of the key is in flight.
+ */
+#define KV_GEN_PRESENT	(1U << 31)
+#define KV_GEN_INFLIGHT	(1U << 31)
+#define KV_GEN_MASK	(KV_GEN_PRESENT - 1)
+
+enum {
+	KV_VAL_NONE	= 0,
+	KV_VAL_OK,
+	KV_VAL_FOREIGN,
+	KV_VAL_BAD,
+};
+
+/*
+ * kvsim store. Keys hash into a power of 2 sized bucket array, and
+ * buckets are protected by a fixed set of striped locks so that
+ * workers touching different keys rarely contend.
+ */
+#define KVSIM_LOCKS		1024
+#define KVSIM_MAX_BUCKETS	(1U << 24)
+
+struct kvsim_entry {
+	struct flist_head list;
+	void *val;
+	uint32_t val_len;
+	uint32_t key_len;
+	unsigned char key[0];
+};
+
+struct kvsim {
+	struct flist_head *buckets;
+	unsigned int bucket_mask;
+	pthread_mutex_t locks[KVSIM_LOCKS];
+};
+
+/*
+ * Per io_u engine state, hung off io_u->engine_data. The key buffer
+ * lives here too, sized for the longest possible key. The prefix is
+ * filled in once at allocation time.
+ */
+struct kv_iou {
+	struct flist_head list;
 	struct vsl_kv_cmd cmd;
-	void *key;
+	struct io_u *io_u;
+
+	/*
+	 * kv_verify state. gen is the generation written for a PUT,
+	 * UPDATE or DEL, and the completed generation at issue time for a
+	 * GET. val_gen and val_state describe what the GET returned.
+	 */
+	uint64_t block;
+	uint32_t gen;
+	uint32_t val_gen;
+	unsigned int val_state;
+
+	unsigned char key[0];
 };
 
-static int fio_kv_queue(struct thread_data *td, struct io_u *io_u)
+struct kvio_data {
+	/*
+	 * io_us queued by ->queue(), not yet handed to the workers
+	 */
+	struct io_u **io_us;
+	unsigned int queued;
+
+	/*
+	 * io_us reaped by ->getevents(), returned through ->event()
+	 */
+	struct io_u **events;
+
+	pthread_mutex_t lock;
+	pthread_cond_t submit_cond;
+	pthread_cond_t complete_cond;
+	struct flist_head submit_list;
+	struct flist_head complete_list;
+	unsigned int nr_complete;
+
+	pthread_t *workers;
+	unsigned int nr_workers;
+	int workers_exit;
+
+	struct frand_state op_state;
+
+	/*
+	 * Parsed kv_key_split and kv_value_split, if set
+	 */
+	struct bssplit *key_split;
+	unsigned int key_split_nr;
+	struct bssplit *value_split;
+	unsigned int value_split_nr;
+
+	/*
+	 * Per key generation tables, kv_verify only
+	 */
+	uint32_t *gen_issued;
+	uint32_t *gen_done;
+	uint64_t nr_keys;
+
+	/*
+	 * In memory device, kvsim only
+	 */
+	struct kvsim *sim;
+};
+
+struct kv_options {
+	struct thread_data *td;
+	unsigned int workers;
+	unsigned int update_percentage;
+	unsigned int key_len;
+	unsigned int key_enc;
+	unsigned int verify;
+	char *key_prefix;
+	char *key_split;
+	char *value_split;
+	unsigned int sim_lat[VSL_KV_NR];
+	unsigned long long sim_bw[2];
+};
+
+static struct fio_option options[] = {
+	{
+		.name	= "kv_workers",
+		.lname	= "KV submission workers",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, workers),
+		.help	= "Number of threads issuing KV ioctls (0 = iodepth)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_update_percentage",
+		.lname	= "KV update percentage",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, update_percentage),
+		.help	= "Percentage of writes issued as UPDATE instead of PUT",
+		.def	= "0",
+		.minval	= 0,
+		.maxval	= 100,
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_key_len",
+		.lname	= "KV key length",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, key_len),
+		.help	= "Length of each key in bytes, including the prefix",
+		.def	= "16",
+		.minval	= 1,
+		.maxval	= KV_KEY_MAX,
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_key_prefix",
+		.lname	= "KV key prefix",
+		.type	= FIO_OPT_STR_STORE,
+		.off1	= offsetof(struct kv_options, key_prefix),
+		.help	= "String prepended to every key",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_key_split",
+		.lname	= "KV key length split",
+		.type	= FIO_OPT_STR_STORE,
+		.off1	= offsetof(struct kv_options, key_split),
+		.help	= "Key length distribution, as len/perc:len/perc:...",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_value_split",
+		.lname	= "KV value size split",
+		.type	= FIO_OPT_STR_STORE,
+		.off1	= offsetof(struct kv_options, value_split),
+		.help	= "Value size distribution, as size/perc:size/perc:...",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_key_encoding",
+		.lname	= "KV key encoding",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct kv_options, key_enc),
+		.help	= "How the block number is encoded in the key",
+		.def	= "hex",
+		.posval = {
+			  { .ival = "hex",
+			    .oval = KV_KEY_ENC_HEX,
+			    .help = "Zero padded hexadecimal digits",
+			  },
+			  { .ival = "dec",
+			    .oval = KV_KEY_ENC_DEC,
+			    .help = "Zero padded decimal digits",
+			  },
+			  { .ival = "binary",
+			    .oval = KV_KEY_ENC_BIN,
+			    .help = "Big endian binary, zero padded",
+			  },
+		},
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kv_verify",
+		.lname	= "KV verify",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct kv_options, verify),
+		.help	= "Embed a verify header in values and check every GET",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kvsim_get_lat",
+		.lname	= "KV sim GET latency",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, sim_lat[VSL_KV_GET]),
+		.help	= "Emulated GET latency in usec (kvsim only)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kvsim_put_lat",
+		.lname	= "KV sim PUT latency",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, sim_lat[VSL_KV_PUT]),
+		.help	= "Emulated PUT latency in usec (kvsim only)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kvsim_update_lat",
+		.lname	= "KV sim UPDATE latency",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, sim_lat[VSL_KV_UPDATE]),
+		.help	= "Emulated UPDATE latency in usec (kvsim only)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kvsim_del_lat",
+		.lname	= "KV sim DEL latency",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct kv_options, sim_lat[VSL_KV_DEL]),
+		.help	= "Emulated DEL latency in usec (kvsim only)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= "kvsim_bw",
+		.lname	= "KV sim bandwidth",
+		.type	= FIO_OPT_STR_VAL,
+		.off1	= offsetof(struct kv_options, sim_bw[0]),
+		.off2	= offsetof(struct kv_options, sim_bw[1]),
+		.help	= "Emulated value bandwidth in bytes/sec, GET,PUT (kvsim only)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_KV,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+static unsigned int kv_prefix_len(struct kv_options *o)
+{
+	if (!o->key_prefix)
+		return 0;
+
+	return strlen(o->key_prefix);
+}
+
+/*
+ * Pick an entry of a size split from the top bits of a block hash, the
+ * percentages are cumulative just like for bssplit.
+ */
+static unsigned int fio_kv_split_pick(struct bssplit *split, unsigned int nr,
+				      uint64_t hash)
+{
+	unsigned int i, perc = 0;
+	unsigned int r = ((hash >> 32) * 100) >> 32;
+
+	for (i = 0; i < nr; i++) {
+		perc += split[i].perc;
+		if (r < perc)
+			return split[i].bs;
+	}
+
+	return split[nr - 1].bs;
+}
+
+/*
+ * Render the block number behind the prefix, most significant digit
+ * first so that keys sort in block order. Digits that do not fit in
+ * the key are dropped.
+ */
+static void fio_kv_fill_key(struct kv_options *o, struct kv_iou *kiou,
+			    unsigned int key_len, uint64_t block)
+{
+	static const char hex[] = "0123456789abcdef";
+	unsigned char *p = kiou->key + key_len;
+	unsigned int left = key_len - kv_prefix_len(o);
+
+	switch (o->key_enc) {
+	case KV_KEY_ENC_HEX:
+		while (left--) {
+			*--p = hex[block & 0xf];
+			block >>= 4;
+		}
+		break;
+	case KV_KEY_ENC_DEC:
+		while (left--) {
+			*--p = '0' + (block % 10);
+			block /= 10;
+		}
+		break;
+	case KV_KEY_ENC_BIN:
+		while (left--) {
+			*--p = block & 0xff;
+			block >>= 8;
+		}
+		break;
+	}
+}
+
+static int fio_kv_write_opcode(struct thread_data *td)
 {
-	struct fio_file *f = io_u->file;
+	struct kv_options *o = td->eo;
 	struct kvio_data *kd = td->io_ops->data;
-	struct vsl_kv_cmd cmd;
-	int ret;
+	unsigned int v;
+
+	if (!o->update_percentage)
+		return VSL_KV_PUT;
+	if (o->update_percentage == 100)
+		return VSL_KV_UPDATE;
+
+	v = 1 + (int) (100.0 * (__rand(&kd->op_state) / (FRAND_MAX + 1.0)));
+	if (v <= o->update_percentage)
+		return VSL_KV_UPDATE;
+
+	return VSL_KV_PUT;
+}
+
+static uint32_t fio_kv_key_hash(struct kv_iou *kiou)
+{
+	return jhash(kiou->key, kiou->cmd.key_len, 0);
+}
+
+/*
+ * Pick the generation of a mutating command and stamp it into the value,
+ * or remember what a GET should at least see. Returns 1 if another
+ * mutation of the key is still in flight.
+ */
+static int fio_kv_prep_verify(struct kvio_data *kd, struct kv_iou *kiou,
+			      uint64_t block)
+{
+	struct vsl_kv_cmd *cmd = &kiou->cmd;
+	uint32_t *issued = &kd->gen_issued[block];
+	struct kv_vhdr *hdr;
+
+	kiou->block = block;
+	kiou->val_state = KV_VAL_NONE;
+
+	if (cmd->opcode == VSL_KV_GET) {
+		kiou->gen = kd->gen_done[block];
+		return 0;
+	}
+
+	if (*issued & KV_GEN_INFLIGHT)
+		return 1;
+
+	*issued = ((*issued + 1) & KV_GEN_MASK) | KV_GEN_INFLIGHT;
+	kiou->gen = *issued & KV_GEN_MASK;
+	if (cmd->opcode == VSL_KV_DEL)
+		return 0;
+
+	hdr = (void *) (uintptr_t) cmd->val_addr;
+	hdr->magic = KV_VHDR_MAGIC;
+	hdr->len = cmd->val_len;
+	hdr->key_hash = fio_kv_key_hash(kiou);
+	hdr->gen = kiou->gen;
+	hdr->crc32c = fio_crc32c((unsigned char *) (hdr + 1),
+					cmd->val_len - sizeof(*hdr));
+	hdr->pad = 0;
+	return 0;
+}
+
+/*
+ * Check the value returned by a GET. Called from the issuing context, so
+ * the checksum runs in the submission workers. Whether the generation is
+ * acceptable is decided at reap time, see fio_kv_complete().
+ */
+static void fio_kv_check_value(struct kv_iou *kiou)
+{
+	struct vsl_kv_cmd *cmd = &kiou->cmd;
+	struct kv_vhdr *hdr = (void *) (uintptr_t) cmd->val_addr;
+	struct io_u *io_u = kiou->io_u;
+
+	if (hdr->magic != KV_VHDR_MAGIC) {
+		kiou->val_state = KV_VAL_FOREIGN;
+		return;
+	}
+
+	kiou->val_gen = hdr->gen;
+	if (hdr->len != io_u->xfer_buflen || cmd->val_len != hdr->len ||
+	    hdr->key_hash != fio_kv_key_hash(kiou) ||
+	    hdr->crc32c != fio_crc32c((unsigned char *) (hdr + 1),
+					hdr->len - sizeof(*hdr)))
+		kiou->val_state = KV_VAL_BAD;
+	else
+		kiou->val_state = KV_VAL_OK;
+}
+
+static void fio_kv_verify_failed(struct kv_iou *kiou, const char *msg)
+{
+	log_err("fio: kv: verify failed for key block %llu: %s (gen %u, "
+			"expected %u..)\n", (unsigned long long) kiou->block,
+			msg, kiou->val_gen, kiou->gen & KV_GEN_MASK);
+	kiou->io_u->error = EILSEQ;
+}
+
+/*
+ * Update the completed generation of a key, or check a GET against it.
+ * Runs in the job thread as the command is reaped.
+ */
+static void fio_kv_complete(struct kvio_data *kd, struct kv_iou *kiou)
+{
+	struct vsl_kv_cmd *cmd = &kiou->cmd;
+	uint32_t *done = &kd->gen_done[kiou->block];
+	uint32_t issued, state;
+
+	if (cmd->opcode != VSL_KV_GET) {
+		kd->gen_issued[kiou->block] &= ~KV_GEN_INFLIGHT;
+		if (kiou->io_u->error)
+			return;
+
+		state = kiou->gen;
+		if (cmd->opcode != VSL_KV_DEL && !cmd->errcode)
+			state |= KV_GEN_PRESENT;
+		if (kiou->gen > (*done & KV_GEN_MASK))
+			*done = state;
+		return;
+	}
+
+	if (kiou->io_u->error)
+		return;
+
+	/*
+	 * Not touched yet by this job, anything sane goes
+	 */
+	if (!kiou->gen) {
+		if (kiou->val_state == KV_VAL_BAD)
+			fio_kv_verify_failed(kiou, "corrupt value");
+		return;
+	}
+
+	issued = kd->gen_issued[kiou->block] & KV_GEN_MASK;
+
+	if (cmd->errcode == VSLKV_ERR_NOKEY) {
+		if ((kiou->gen & KV_GEN_PRESENT) &&
+		    issued == (kiou->gen & KV_GEN_MASK))
+			fio_kv_verify_failed(kiou, "key missing");
+		return;
+	}
+
+	if (kiou->val_state == KV_VAL_FOREIGN)
+		fio_kv_verify_failed(kiou, "bad magic");
+	else if (kiou->val_state == KV_VAL_BAD)
+		fio_kv_verify_failed(kiou, "corrupt value");
+	else if (kiou->val_gen < (kiou->gen & KV_GEN_MASK) ||
+		 kiou->val_gen > issued)
+		fio_kv_verify_failed(kiou, "stale or unknown generation");
+}
+
+/*
+ * Returns 1 if the command has to wait for an earlier one to the same key
+ */
+static int fio_kv_prep_cmd(struct thread_data *td, struct io_u *io_u,
+			   struct kv_iou *kiou)
+{
+	struct kv_options *o = td->eo;
+	struct kvio_data *kd = td->io_ops->data;
+	struct vsl_kv_cmd *cmd = &kiou->cmd;
+	unsigned int key_len = o->key_len;
+	uint64_t block, hash;
 
 	if (io_u->ddir == DDIR_WRITE)
-		cmd.opcode = VSL_KV_PUT;
+		cmd->opcode = fio_kv_write_opcode(td);
+	else if (io_u->ddir == DDIR_TRIM)
+		cmd->opcode = VSL_KV_DEL;
 	else
-		cmd.opcode = VSL_KV_GET;
+		cmd->opcode = VSL_KV_GET;
 
-	cmd.errcode = 0;
-	cmd.key_len = kd->cmd.key_len;
-	cmd.key_addr = kd->cmd.key_addr;
-	cmd.val_len = (uint32_t)io_u->xfer_buflen;
-	cmd.val_addr = (uint64_t)io_u->xfer_buf;
+	io_u->io_op = cmd->opcode;
 
-	ret = ioctl(f->fd, VSL_IOCTL_KV, &cmd);
-	if (ret < 0 && !cmd.errcode) {
-		return ret;
+	block = (io_u->offset - io_u->file->file_offset) / td->o.rw_min_bs;
+	hash = __hash_u64(block);
+
+	/*
+	 * Shrink the transfer to the value size of this key, so that
+	 * bandwidth and bytes done reflect the value bytes only.
+	 */
+	if (kd->value_split_nr) {
+		io_u->buflen = fio_kv_split_pick(kd->value_split,
+						 kd->value_split_nr, hash);
+		io_u->xfer_buflen = io_u->buflen;
+	}
+	if (kd->key_split_nr)
+		key_len = fio_kv_split_pick(kd->key_split, kd->key_split_nr,
+						__hash_u64(hash));
+
+	fio_kv_fill_key(o, kiou, key_len, block);
+
+	cmd->errcode = 0;
+	cmd->key_len = key_len;
+	cmd->key_addr = (uint64_t) (uintptr_t) kiou->key;
+	if (cmd->opcode == VSL_KV_DEL) {
+		cmd->val_len = 0;
+		cmd->val_addr = 0;
+	} else {
+		cmd->val_len = (uint32_t) io_u->xfer_buflen;
+		cmd->val_addr = (uint64_t) (uintptr_t) io_u->xfer_buf;
 	}
 
-	return FIO_Q_COMPLETED;
+	if (kd->gen_issued)
+		return fio_kv_prep_verify(kd, kiou, block);
+
+	return 0;
 }
 
-static int fio_kv_init(struct thread_data *td)
+static struct kvsim_entry *kvsim_find(struct flist_head *bucket,
+				       const unsigned char *key,
+				       unsigned int key_len)
+{
+	struct flist_head *n;
+	struct kvsim_entry *e;
+
+	flist_for_each(n, bucket) {
+		e = flist_entry(n, struct kvsim_entry, list);
+		if (e->key_len == key_len && !memcmp(e->key, key, key_len))
+			return e;
+	}
+
+	return NULL;
+}
+
+/*
+ * Execute a command against the in memory store, with the same return
+ * convention as the ioctl: -1 and errcode set for a device error, -1 and
+ * errno set for a host error.
+ */
+static int kvsim_cmd(struct kvsim *sim, struct vsl_kv_cmd *cmd)
+{
+	const unsigned char *key = (void *) (uintptr_t) cmd->key_addr;
+	void *val = (void *) (uintptr_t) cmd->val_addr;
+	struct flist_head *bucket;
+	struct kvsim_entry *e;
+	pthread_mutex_t *lock;
+	uint32_t hash;
+	int ret = 0, nokey = 0;
+
+	hash = jhash(key, cmd->key_len, 0);
+	bucket = &sim->buckets[hash & sim->bucket_mask];
+	lock = &sim->locks[hash & (KVSIM_LOCKS - 1)];
+
+	pthread_mutex_lock(lock);
+
+	e = kvsim_find(bucket, key, cmd->key_len);
+	switch (cmd->opcode) {
+	case VSL_KV_GET:
+		if (!e) {
+			nokey = 1;
+			break;
+		}
+		if (e->val_len < cmd->val_len)
+			cmd->val_len = e->val_len;
+		memcpy(val, e->val, cmd->val_len);
+		break;
+	case VSL_KV_PUT:
+	case VSL_KV_UPDATE:
+		if (!e) {
+			if (cmd->opcode == VSL_KV_UPDATE) {
+				nokey = 1;
+				break;
+			}
+			e = malloc(sizeof(*e) + cmd->key_len);
+			if (!e) {
+				ret = ENOMEM;
+				break;
+			}
+			e->val = NULL;
+			e->val_len = 0;
+			e->key_len = cmd->key_len;
+			memcpy(e->key, key, cmd->key_len);
+			flist_add(&e->list, bucket);
+		}
+		if (e->val_len != cmd->val_len) {
+			void *p = realloc(e->val, cmd->val_len);
+
+			if (!p && cmd->val_len) {
+				ret = ENOMEM;
+				break;
+			}
+			e->val = p;
+			e->val_len = cmd->val_len;
+		}
+		memcpy(e->val, val, cmd->val_len);
+		break;
+	case VSL_KV_DEL:
+		if (!e) {
+			nokey = 1;
+			break;
+		}
+		flist_del(&e->list);
+		free(e->val);
+		free(e);
+		break;
+	default:
+		ret = EINVAL;
+		break;
+	}
+
+	pthread_mutex_unlock(lock);
+
+	if (ret) {
+		errno = ret;
+		return -1;
+	}
+	if (nokey) {
+		cmd->errcode = VSLKV_ERR_NOKEY;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Time a kvsim command would have taken on the modeled device
+ */
+static unsigned long kvsim_cmd_usec(struct kv_options *o,
+				    struct vsl_kv_cmd *cmd)
+{
+	unsigned long long bw = 0;
+	unsigned long usec;
+
+	usec = o->sim_lat[cmd->opcode];
+	if (cmd->opcode == VSL_KV_GET)
+		bw = o->sim_bw[0];
+	else if (cmd->opcode != VSL_KV_DEL)
+		bw = o->sim_bw[1];
+
+	if (bw)
+		usec += ((unsigned long long) cmd->val_len * 1000000ULL) / bw;
+
+	return usec;
+}
+
+static void kvsim_free(struct kvsim *sim)
+{
+	struct kvsim_entry *e;
+	unsigned int i;
+
+	for (i = 0; i <= sim->bucket_mask; i++) {
+		while (!flist_empty(&sim->buckets[i])) {
+			e = flist_first_entry(&sim->buckets[i],
+						struct kvsim_entry, list);
+			flist_del(&e->list);
+			free(e->val);
+			free(e);
+		}
+	}
+
+	for (i = 0; i < KVSIM_LOCKS; i++)
+		pthread_mutex_destroy(&sim->locks[i]);
+
+	free(sim->buckets);
+	free(sim);
+}
+
+/*
+ * Size the table for one key per block of the job, so chains stay short
+ */
+static struct kvsim *kvsim_alloc(struct thread_data *td)
+{
+	unsigned long long keys = td->o.size / td->o.rw_min_bs;
+	unsigned int i, nr = KVSIM_LOCKS;
+	struct kvsim *sim;
+
+	while (nr < keys && nr < KVSIM_MAX_BUCKETS)
+		nr <<= 1;
+
+	sim = malloc(sizeof(*sim));
+	if (!sim)
+		return NULL;
+
+	sim->buckets = malloc(nr * sizeof(struct flist_head));
+	if (!sim->buckets) {
+		free(sim);
+		return NULL;
+	}
+
+	for (i = 0; i < nr; i++)
+		INIT_FLIST_HEAD(&sim->buckets[i]);
+	for (i = 0; i < KVSIM_LOCKS; i++)
+		pthread_mutex_init(&sim->locks[i], NULL);
+
+	sim->bucket_mask = nr - 1;
+	return sim;
+}
+
+/*
+ * Issue the command for one io_u and record the outcome in io_u->error.
+ * A device reported errcode (eg GET of a missing key) is not an IO error.
+ */
+static void fio_kv_issue(struct thread_data *td, struct io_u *io_u,
+			 struct vsl_kv_cmd *cmd)
+{
+	struct kvio_data *kd = td->io_ops->data;
+	unsigned long usec;
+	int ret;
+
+	if (kd->sim)
+		ret = kvsim_cmd(kd->sim, cmd);
+	else
+		ret = ioctl(io_u->file->fd, VSL_IOCTL_KV, cmd);
+
+	if (ret < 0 && !cmd->errcode)
+		io_u->error = errno;
+	else
+		io_u->error = 0;
+
+	if (kd->gen_issued && cmd->opcode == VSL_KV_GET && !ret)
+		fio_kv_check_value(io_u->engine_data);
+
+	/*
+	 * Sleep rather than spin, so that workers overlap their modeled
+	 * device time even when they outnumber the CPUs.
+	 */
+	if (kd->sim) {
+		usec = kvsim_cmd_usec(td->eo, cmd);
+		if (usec) {
+			struct timespec req;
+
+			req.tv_sec = usec / 1000000;
+			req.tv_nsec = (usec % 1000000) * 1000;
+			nanosleep(&req, NULL);
+		}
+	}
+}
+
+static void *fio_kv_worker(void *data)
+{
+	struct thread_data *td = data;
+	struct kvio_data *kd = td->io_ops->data;
+	struct kv_iou *kiou;
+
+	pthread_mutex_lock(&kd->lock);
+	while (1) {
+		while (flist_empty(&kd->submit_list) && !kd->workers_exit)
+			pthread_cond_wait(&kd->submit_cond, &kd->lock);
+
+		if (flist_empty(&kd->submit_list))
+			break;
+
+		kiou = flist_first_entry(&kd->submit_list, struct kv_iou, list);
+		flist_del(&kiou->list);
+		pthread_mutex_unlock(&kd->lock);
+
+		fio_kv_issue(td, kiou->io_u, &kiou->cmd);
+
+		pthread_mutex_lock(&kd->lock);
+		flist_add_tail(&kiou->list, &kd->complete_list);
+		kd->nr_complete++;
+		pthread_cond_signal(&kd->complete_cond);
+	}
+	pthread_mutex_unlock(&kd->lock);
+
+	return NULL;
+}
+
+static struct io_u *fio_kv_event(struct thread_data *td, int event)
+{
+	struct kvio_data *kd = td->io_ops->data;
+
+	return kd->events[event];
+}
+
+static int fio_kv_getevents(struct thread_data *td, unsigned int min,
+			    unsigned int max, struct timespec *t)
+{
+	struct kvio_data *kd = td->io_ops->data;
+	struct timespec abs;
+	struct kv_iou *kiou;
+	unsigned int events = 0;
+	int ret = 0;
+
+	if (t) {
+		struct timeval now;
+
+		gettimeofday(&now, NULL);
+		abs.tv_sec = now.tv_sec + t->tv_sec;
+		abs.tv_nsec = now.tv_usec * 1000 + t->tv_nsec;
+		if (abs.tv_nsec >= 1000000000) {
+			abs.tv_nsec -= 1000000000;
+			abs.tv_sec++;
+		}
+	}
+
+	pthread_mutex_lock(&kd->lock);
+
+	while (kd->nr_complete < min) {
+		if (t) {
+			ret = pthread_cond_timedwait(&kd->complete_cond,
+							&kd->lock, &abs);
+			if (ret == ETIMEDOUT)
+				break;
+		} else
+			pthread_cond_wait(&kd->complete_cond, &kd->lock);
+	}
+
+	while (events < max && !flist_empty(&kd->complete_list)) {
+		kiou = flist_first_entry(&kd->complete_list, struct kv_iou, list);
+		flist_del(&kiou->list);
+		kd->nr_complete--;
+		if (kd->gen_issued)
+			fio_kv_complete(kd, kiou);
+		kd->events[events++] = kiou->io_u;
+	}
+
+	pthread_mutex_unlock(&kd->lock);
+	return events;
+}
+
+static int fio_kv_commit(struct thread_data *td)
+{
+	struct kvio_data *kd = td->io_ops->data;
+	struct kv_iou *kiou;
+	unsigned int i;
+
+	if (!kd->queued)
+		return 0;
+
+	/*
+	 * Hand the whole batch over under a single lock round trip
+	 */
+	pthread_mutex_lock(&kd->lock);
+	for (i = 0; i < kd->queued; i++) {
+		kiou = kd->io_us[i]->engine_data;
+		flist_add_tail(&kiou->list, &kd->submit_list);
+	}
+	if (kd->queued == 1)
+		pthread_cond_signal(&kd->submit_cond);
+	else
+		pthread_cond_broadcast(&kd->submit_cond);
+	pthread_mutex_unlock(&kd->lock);
+
+	io_u_mark_submit(td, kd->queued);
+	kd->queued = 0;
+	return 0;
+}
+
+static int fio_kv_queue(struct thread_data *td, struct io_u *io_u)
+{
+	struct kvio_data *kd = td->io_ops->data;
+	struct kv_iou *kiou = io_u->engine_data;
+
+	fio_ro_check(td, io_u);
+
+	if (!ddir_rw(io_u->ddir)) {
+		dprint(FD_IO, "kv: ignoring ddir %d\n", io_u->ddir);
+		return FIO_Q_COMPLETED;
+	}
+
+	if (!(td->io_ops->flags & FIO_SYNCIO) && kd->queued == td->o.iodepth)
+		return FIO_Q_BUSY;
+
+	/*
+	 * With kv_verify, wait for an in flight write of the same key to
+	 * complete first.
+	 */
+	if (fio_kv_prep_cmd(td, io_u, kiou))
+		return FIO_Q_BUSY;
+
+	if (td->io_ops->flags & FIO_SYNCIO) {
+		fio_kv_issue(td, io_u, &kiou->cmd);
+		if (kd->gen_issued)
+			fio_kv_complete(kd, kiou);
+		if (io_u->error)
+			td_verror(td, io_u->error, "xfer");
+		return FIO_Q_COMPLETED;
+	}
+
+	kd->io_us[kd->queued++] = io_u;
+	return FIO_Q_QUEUED;
+}
+
+static void fio_kv_io_u_free(struct thread_data *td, struct io_u *io_u)
+{
+	struct kv_iou *kiou = io_u->engine_data;
+
+	if (kiou) {
+		free(kiou);
+		io_u->engine_data = NULL;
+	}
+}
+
+static int fio_kv_io_u_init(struct thread_data *td, struct io_u *io_u)
+{
+	struct kv_options *o = td->eo;
+	struct kv_iou *kiou;
+
+	kiou = malloc(sizeof(*kiou) + KV_KEY_MAX);
+	if (!kiou) {
+		log_err("fio: kv: failed allocating io_u data\n");
+		return 1;
+	}
+
+	memset(kiou, 0, sizeof(*kiou) + KV_KEY_MAX);
+	INIT_FLIST_HEAD(&kiou->list);
+	if (o->key_prefix)
+		memcpy(kiou->key, o->key_prefix,
+			min(kv_prefix_len(o), (unsigned int) KV_KEY_MAX));
+	kiou->io_u = io_u;
+	io_u->engine_data = kiou;
+	return 0;
+}
+
+/*
+ * DEL is a key operation, not a block discard, so don't let the generic
+ * open path reject trim workloads on non block devices.
+ */
+static int fio_kv_open_file(struct thread_data *td, struct fio_file *f)
+{
+	if (!td_trim(td))
+		return generic_open_file(td, f);
+
+	f->fd = open(f->file_name, O_RDWR);
+	if (f->fd == -1) {
+		td_verror(td, errno, "open");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int fio_kvsim_open_file(struct thread_data fio_unused *td,
+			       struct fio_file fio_unused *f)
 {
+	return 0;
+}
+
+static void fio_kv_stop_workers(struct kvio_data *kd)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&kd->lock);
+	kd->workers_exit = 1;
+	pthread_cond_broadcast(&kd->submit_cond);
+	pthread_mutex_unlock(&kd->lock);
+
+	for (i = 0; i < kd->nr_workers; i++)
+		pthread_join(kd->workers[i], NULL);
+
+	kd->nr_workers = 0;
+}
+
+static int fio_kv_start_workers(struct thread_data *td, struct kvio_data *kd)
+{
+	struct kv_options *o = td->eo;
+	unsigned int i, nr;
+	int ret;
+
+	nr = o->workers;
+	if (!nr || nr > td->o.iodepth)
+		nr = td->o.iodepth;
+
+	kd->workers = malloc(nr * sizeof(pthread_t));
+	if (!kd->workers)
+		return ENOMEM;
+
+	for (i = 0; i < nr; i++) {
+		ret = pthread_create(&kd->workers[i], NULL, fio_kv_worker, td);
+		if (ret) {
+			log_err("fio: kv: failed creating worker: %s\n",
+					strerror(ret));
+			fio_kv_stop_workers(kd);
+			return ret;
+		}
+		kd->nr_workers++;
+	}
+
+	return 0;
+}
+
+static void fio_kv_free_data(struct kvio_data *kd)
+{
+	pthread_cond_destroy(&kd->complete_cond);
+	pthread_cond_destroy(&kd->submit_cond);
+	pthread_mutex_destroy(&kd->lock);
+	if (kd->sim)
+		kvsim_free(kd->sim);
+	free(kd->gen_issued);
+	free(kd->gen_done);
+	free(kd->key_split);
+	free(kd->value_split);
+	free(kd->workers);
+	free(kd->events);
+	free(kd->io_us);
+	free(kd);
+}
+
+static int fio_kv_parse_split(struct thread_data *td, const char *name,
+			      const char *str, struct bssplit **split,
+			      unsigned int *nr, unsigned int *min,
+			      unsigned int *max)
+{
+	char *p;
+	int ret;
+
+	p = strdup(str);
+	ret = parse_size_split(&td->o, p, split, nr, min, max);
+	free(p);
+
+	if (ret || !*nr) {
+		log_err("fio: kv: bad %s '%s'\n", name, str);
+		return EINVAL;
+	}
+
+	return 0;
+}
+
+static int fio_kv_setup_splits(struct thread_data *td, struct kvio_data *kd)
+{
+	struct kv_options *o = td->eo;
+	unsigned int min, max, min_key_len = o->key_len;
+	int ret;
+
+	if (o->key_split) {
+		ret = fio_kv_parse_split(td, "kv_key_split", o->key_split,
+						&kd->key_split,
+						&kd->key_split_nr, &min, &max);
+		if (ret)
+			return ret;
+		if (!min || max > KV_KEY_MAX) {
+			log_err("fio: kv: kv_key_split lengths must be within "
+					"1..%u\n", KV_KEY_MAX);
+			return EINVAL;
+		}
+		min_key_len = min;
+	}
+
+	if (o->value_split) {
+		ret = fio_kv_parse_split(td, "kv_value_split", o->value_split,
+						&kd->value_split,
+						&kd->value_split_nr, &min,
+						&max);
+		if (ret)
+			return ret;
+		if (max > td_max_bs(td)) {
+			log_err("fio: kv: kv_value_split size %u exceeds the "
+					"largest block size %u\n", max,
+					td_max_bs(td));
+			return EINVAL;
+		}
+	}
+
+	if (kv_prefix_len(o) >= min_key_len) {
+		log_err("fio: kv: kv_key_prefix must be shorter than the "
+				"shortest key\n");
+		return EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Size the generation tables for the largest file, keys are derived
+ * from the file relative block number.
+ */
+static int fio_kv_setup_verify(struct thread_data *td, struct kvio_data *kd)
+{
+	unsigned int i, min_val = td_min_bs(td);
+	struct fio_file *f;
+
+	for (i = 0; i < kd->value_split_nr; i++)
+		if (kd->value_split[i].bs < min_val)
+			min_val = kd->value_split[i].bs;
+
+	if (min_val < sizeof(struct kv_vhdr)) {
+		log_err("fio: kv: kv_verify needs values of at least %u bytes\n",
+				(unsigned int) sizeof(struct kv_vhdr));
+		return EINVAL;
+	}
+
+	for_each_file(td, f, i) {
+		uint64_t keys = f->io_size / td->o.rw_min_bs + 1;
+
+		if (keys > kd->nr_keys)
+			kd->nr_keys = keys;
+	}
+
+	kd->gen_issued = calloc(kd->nr_keys, sizeof(uint32_t));
+	kd->gen_done = calloc(kd->nr_keys, sizeof(uint32_t));
+	if (!kd->gen_issued || !kd->gen_done)
+		return ENOMEM;
+
+	/*
+	 * The header is written into the value in place, so values must
+	 * not come straight from the shared buffer_pool
+	 */
+	td->io_ops->flags |= FIO_OWNBUF;
+
+	crc32c_intel_probe();
+	return 0;
+}
+
+static int __fio_kv_init(struct thread_data *td, int sim)
+{
+	struct kv_options *o = td->eo;
 	struct kvio_data *kd = NULL;
+	int i, ret;
 
 	kd = malloc(sizeof(struct kvio_data));
 	if (!kd)
-		goto err;
+		return ENOMEM;
 
-	kd->key = malloc(sizeof(char) * 13);
-	if (!kd->key)
-		goto err;
+	memset(kd, 0, sizeof(*kd));
+
+	ret = fio_kv_setup_splits(td, kd);
+	if (ret) {
+		free(kd->key_split);
+		free(kd->value_split);
+		free(kd);
+		return ret;
+	}
+	pthread_mutex_init(&kd->lock, NULL);
+	pthread_cond_init(&kd->submit_cond, NULL);
+	pthread_cond_init(&kd->complete_cond, NULL);
+	INIT_FLIST_HEAD(&kd->submit_list);
+	INIT_FLIST_HEAD(&kd->complete_list);
+	init_rand_seed(&kd->op_state, td->rand_seeds[FIO_RAND_ENGINE_OFF]);
+	td->io_ops->data = kd;
 
-	sprintf(kd->key, "LIGHTNVM FTW");
+	if (sim) {
+		kd->sim = kvsim_alloc(td);
+		if (!kd->sim)
+			goto err;
+	}
 
-	kd->cmd.key_len = 13;
-	kd->cmd.key_addr = (uint64_t) kd->key;
+	if (o->verify) {
+		ret = fio_kv_setup_verify(td, kd);
+		if (ret) {
+			td->io_ops->data = NULL;
+			fio_kv_free_data(kd);
+			return ret;
+		}
+	}
 
-	td->io_ops->data = kd;
+	for (i = 0; i < VSL_KV_NR; i++)
+		stat_set_io_op_name(td, i, vsl_kv_opcode_names[i]);
+
+	if (td->o.iodepth == 1) {
+		td->io_ops->flags |= FIO_SYNCIO;
+		return 0;
+	}
+
+	kd->io_us = calloc(td->o.iodepth, sizeof(struct io_u *));
+	kd->events = calloc(td->o.iodepth, sizeof(struct io_u *));
+	if (!kd->io_us || !kd->events)
+		goto err;
+
+	ret = fio_kv_start_workers(td, kd);
+	if (ret) {
+		td->io_ops->data = NULL;
+		fio_kv_free_data(kd);
+		return ret;
+	}
 
 	return 0;
 err:
-	free(kd);
-	return -ENOMEM;
+	td->io_ops->data = NULL;
+	fio_kv_free_data(kd);
+	return ENOMEM;
+}
+
+static int fio_kv_init(struct thread_data *td)
+{
+	return __fio_kv_init(td, 0);
+}
+
+static int fio_kvsim_init(struct thread_data *td)
+{
+	return __fio_kv_init(td, 1);
 }
 
 static void fio_kv_cleanup(struct thread_data *td)
 {
 	struct kvio_data *kd = td->io_ops->data;
 
-	free(kd->key);
-	free(kd);
+	if (kd) {
+		fio_kv_stop_workers(kd);
+		fio_kv_free_data(kd);
+		td->io_ops->data = NULL;
+	}
 }
 
 static struct ioengine_ops ioengine = {
-	.name		= "kv",
-	.version	= FIO_IOOPS_VERSION,
-	.init		= fio_kv_init,
-	.cleanup	= fio_kv_cleanup,
-	.queue		= fio_kv_queue,
-	.open_file	= generic_open_file,
-	.close_file	= generic_close_file,
-	.get_file_size	= generic_get_file_size,
-	.flags		= FIO_SYNCIO | FIO_RAWIO | FIO_MEMALIGN,
+	.name			= "kv",
+	.version		= FIO_IOOPS_VERSION,
+	.init			= fio_kv_init,
+	.cleanup		= fio_kv_cleanup,
+	.queue			= fio_kv_queue,
+	.commit			= fio_kv_commit,
+	.getevents		= fio_kv_getevents,
+	.event			= fio_kv_event,
+	.io_u_init		= fio_kv_io_u_init,
+	.io_u_free		= fio_kv_io_u_free,
+	.open_file		= fio_kv_open_file,
+	.close_file		= generic_close_file,
+	.get_file_size		= generic_get_file_size,
+	.flags			= FIO_RAWIO | FIO_MEMALIGN,
+	.options		= options,
+	.option_struct_size	= sizeof(struct kv_options),
+};
+
+static struct ioengine_ops ioengine_sim = {
+	.name			= "kvsim",
+	.version		= FIO_IOOPS_VERSION,
+	.init			= fio_kvsim_init,
+	.cleanup		= fio_kv_cleanup,
+	.queue			= fio_kv_queue,
+	.commit			= fio_kv_commit,
+	.getevents		= fio_kv_getevents,
+	.event			= fio_kv_event,
+	.io_u_init		= fio_kv_io_u_init,
+	.io_u_free		= fio_kv_io_u_free,
+	.open_file		= fio_kvsim_open_file,
+	.flags			= FIO_DISKLESSIO,
+	.options		= options,
+	.option_struct_size	= sizeof(struct kv_options),
 };
 
 static void fio_init fio_kv_register(void)
 {
 	register_ioengine(&ioengine);
+	register_ioengine(&ioengine_sim);
 }
 
 static void fio_exit fio_kv_unregister(void)
 {
 	unregister_ioengine(&ioengine);
+	unregister_ioengine(&ioengine_sim);
 }
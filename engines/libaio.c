@@ -19,11 +19,19 @@ struct libaio_data {
 	struct iocb **iocbs;
 	struct io_u **io_us;
 	int iocbs_nr;
+
+	/*
+	 * Running average of how long we waited for completions, in usec,
+	 * scaled by 8. Sets the hybrid_poll spin budget.
+	 */
+	unsigned long wait_avg;
 };
 
 struct libaio_options {
 	struct thread_data *td;
 	unsigned int userspace_reap;
+	unsigned int hybrid_poll;
+	unsigned int hybrid_poll_max;
 };
 
 static struct fio_option options[] = {
@@ -36,6 +44,25 @@ static struct fio_option options[] = {
 		.category = FIO_OPT_C_ENGINE,
 		.group	= FIO_OPT_G_LIBAIO,
 	},
+	{
+		.name	= "hybrid_poll",
+		.lname	= "Libaio hybrid polling",
+		.type	= FIO_OPT_STR_SET,
+		.off1	= offsetof(struct libaio_options, hybrid_poll),
+		.help	= "Spin on the completion ring before sleeping for events",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
+	{
+		.name	= "hybrid_poll_max",
+		.lname	= "Libaio hybrid polling spin limit",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct libaio_options, hybrid_poll_max),
+		.help	= "Longest time to spin for completions (usec)",
+		.def	= "100",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_LIBAIO,
+	},
 	{
 		.name	= NULL,
 	},
@@ -116,6 +143,63 @@ static int user_io_getevents(io_context_t aio_ctx, unsigned int max,
 	return i;
 }
 
+/*
+ * Spin on the completion ring for up to the budget, then fall back to
+ * sleeping in io_getevents(). The budget follows the average time we have
+ * had to wait recently: a bit more than that catches most completions,
+ * and once the average is beyond hybrid_poll_max spinning is a waste and
+ * we go straight to sleep.
+ */
+static int fio_libaio_hybrid_getevents(struct thread_data *td,
+				       unsigned int min, unsigned int max,
+				       struct timespec *t)
+{
+	struct libaio_data *ld = td->io_ops->data;
+	struct libaio_options *o = td->eo;
+	unsigned long budget, spun, waited;
+	struct timeval start;
+	int r, events = 0;
+
+	budget = (ld->wait_avg >> 3) + (ld->wait_avg >> 4);
+	if (budget > o->hybrid_poll_max)
+		budget = 0;
+
+	fio_gettime(&start, NULL);
+	do {
+		r = user_io_getevents(ld->aio_ctx, max - events,
+					ld->aio_events + events);
+		events += r;
+		if (events >= min)
+			break;
+		nop;
+	} while (utime_since_now(&start) < budget);
+
+	spun = utime_since_now(&start);
+	td->ts.poll_spin_usec += spun;
+
+	if (events >= min)
+		td->ts.poll_spin_reaps++;
+	else {
+		do {
+			r = io_getevents(ld->aio_ctx, min - events,
+					max - events, ld->aio_events + events, t);
+			if (r >= 0)
+				events += r;
+			else if (r == -EAGAIN)
+				usleep(100);
+			else if (r != -EINTR)
+				break;
+		} while (events < min);
+
+		td->ts.poll_sleep_usec += utime_since_now(&start) - spun;
+		td->ts.poll_sleeps++;
+	}
+
+	waited = utime_since_now(&start);
+	ld->wait_avg += waited - (ld->wait_avg >> 3);
+	return r < 0 ? r : events;
+}
+
 static int fio_libaio_getevents(struct thread_data *td, unsigned int min,
 				unsigned int max, struct timespec *t)
 {
@@ -124,6 +208,10 @@ static int fio_libaio_getevents(struct thread_data *td, unsigned int min,
 	unsigned actual_min = td->o.iodepth_batch_complete == 0 ? 0 : min;
 	int r, events = 0;
 
+	if (o->hybrid_poll && actual_min &&
+	    ((struct aio_ring *)(ld->aio_ctx))->magic == AIO_RING_MAGIC)
+		return fio_libaio_hybrid_getevents(td, actual_min, max, t);
+
 	do {
 		if (o->userspace_reap == 1
 		    && actual_min == 0
@@ -181,6 +269,31 @@ static int fio_libaio_queue(struct thread_data *td, struct io_u *io_u)
 	return FIO_Q_QUEUED;
 }
 
+/*
+ * Add reads and writes to the pending iocbs while there's room. Syncs and
+ * trims are left to ->queue(), since they have to wait for pending io.
+ */
+static int fio_libaio_queue_batch(struct thread_data *td, struct io_u **io_us,
+				  unsigned int nr)
+{
+	struct libaio_data *ld = td->io_ops->data;
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		struct io_u *io_u = io_us[i];
+
+		if (!ddir_rw(io_u->ddir) || ld->iocbs_nr == (int) td->o.iodepth)
+			break;
+
+		fio_ro_check(td, io_u);
+		ld->iocbs[ld->iocbs_nr] = &io_u->iocb;
+		ld->io_us[ld->iocbs_nr] = io_u;
+		ld->iocbs_nr++;
+	}
+
+	return i;
+}
+
 static void fio_libaio_queued(struct thread_data *td, struct io_u **io_us,
 			      unsigned int nr)
 {
@@ -265,9 +378,9 @@ static int fio_libaio_init(struct thread_data *td)
 	 * care about the user ring. If that fails, the kernel is too old
 	 * and we need the right depth.
 	 */
-	if (!o->userspace_reap)
+	if (!o->userspace_reap && !o->hybrid_poll)
 		err = io_queue_init(INT_MAX, &ld->aio_ctx);
-	if (o->userspace_reap || err == -EINVAL)
+	if (o->userspace_reap || o->hybrid_poll || err == -EINVAL)
 		err = io_queue_init(td->o.iodepth, &ld->aio_ctx);
 	if (err) {
 		td_verror(td, -err, "io_queue_init");
@@ -294,6 +407,7 @@ static struct ioengine_ops ioengine = {
 	.init			= fio_libaio_init,
 	.prep			= fio_libaio_prep,
 	.queue			= fio_libaio_queue,
+	.queue_batch		= fio_libaio_queue_batch,
 	.commit			= fio_libaio_commit,
 	.cancel			= fio_libaio_cancel,
 	.getevents		= fio_libaio_getevents,
@@ -304,6 +418,7 @@ static struct ioengine_ops ioengine = {
 	.get_file_size		= generic_get_file_size,
 	.options		= options,
 	.option_struct_size	= sizeof(struct libaio_options),
+	.flags			= FIO_ASYNC_REAP,
 };
 
 static void fio_init fio_libaio_register(void)
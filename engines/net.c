@@ -29,6 +29,10 @@ struct netio_data {
 	struct sockaddr_in addr;
 	struct sockaddr_in6 addr6;
 	struct sockaddr_un addr_un;
+#ifdef CONFIG_SENDMMSG
+	struct mmsghdr *msgs;
+	struct iovec *iovecs;
+#endif
 };
 
 struct netio_options {
@@ -557,6 +561,90 @@ static int fio_netio_queue(struct thread_data *td, struct io_u *io_u)
 	return ret;
 }
 
+#ifdef CONFIG_SENDMMSG
+/*
+ * Send a batch of datagrams with one sendmmsg(2). Whatever isn't sent is
+ * left to ->queue(), which deals with errors and waits for the socket.
+ */
+static int fio_netio_udp_send_batch(struct thread_data *td,
+				    struct io_u **io_us, unsigned int nr)
+{
+	struct netio_data *nd = td->io_ops->data;
+	struct netio_options *o = td->eo;
+	struct sockaddr *to;
+	socklen_t len;
+	unsigned int i;
+	int ret;
+
+	if (is_ipv6(o)) {
+		to = (struct sockaddr *) &nd->addr6;
+		len = sizeof(nd->addr6);
+	} else {
+		to = (struct sockaddr *) &nd->addr;
+		len = sizeof(nd->addr);
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct io_u *io_u = io_us[i];
+		struct msghdr *msg = &nd->msgs[i].msg_hdr;
+
+		if (io_u->ddir != DDIR_WRITE || io_u->file != io_us[0]->file)
+			break;
+
+		fio_ro_check(td, io_u);
+		nd->iovecs[i].iov_base = io_u->xfer_buf;
+		nd->iovecs[i].iov_len = io_u->xfer_buflen;
+		memset(msg, 0, sizeof(*msg));
+		msg->msg_name = to;
+		msg->msg_namelen = len;
+		msg->msg_iov = &nd->iovecs[i];
+		msg->msg_iovlen = 1;
+	}
+
+	if (!i)
+		return 0;
+
+	ret = sendmmsg(io_us[0]->file->fd, nd->msgs, i, 0);
+	if (ret <= 0)
+		return 0;
+
+	for (i = 0; i < (unsigned int) ret; i++) {
+		struct io_u *io_u = io_us[i];
+
+		if (nd->msgs[i].msg_len != io_u->xfer_buflen)
+			io_u->resid = io_u->xfer_buflen - nd->msgs[i].msg_len;
+	}
+
+	return ret;
+}
+#endif
+
+/*
+ * Issue io_us until one doesn't complete. UDP writes go out with a single
+ * sendmmsg(2) where we have it.
+ */
+static int fio_netio_queue_batch(struct thread_data *td, struct io_u **io_us,
+				 unsigned int nr)
+{
+	struct netio_options *o = td->eo;
+	unsigned int i;
+
+#ifdef CONFIG_SENDMMSG
+	if (is_udp(o) && !o->pingpong && td_write(td))
+		return fio_netio_udp_send_batch(td, io_us, nr);
+#endif
+
+	for (i = 0; i < nr; i++) {
+		/*
+		 * A busy io_u hasn't been sent, ->queue() will retry it
+		 */
+		if (fio_netio_queue(td, io_us[i]) != FIO_Q_COMPLETED)
+			break;
+	}
+
+	return i;
+}
+
 static int fio_netio_connect(struct thread_data *td, struct fio_file *f)
 {
 	struct netio_data *nd = td->io_ops->data;
@@ -1170,6 +1258,15 @@ static int fio_netio_init(struct thread_data *td)
 	else
 		ret = fio_netio_setup_connect(td);
 
+#ifdef CONFIG_SENDMMSG
+	if (!ret && is_udp(o) && td_write(td)) {
+		struct netio_data *nd = td->io_ops->data;
+
+		nd->msgs = calloc(td->o.iodepth_batch, sizeof(struct mmsghdr));
+		nd->iovecs = calloc(td->o.iodepth_batch, sizeof(struct iovec));
+	}
+#endif
+
 	return ret;
 }
 
@@ -1185,6 +1282,10 @@ static void fio_netio_cleanup(struct thread_data *td)
 		if (nd->pipes[1] != -1)
 			close(nd->pipes[1]);
 
+#ifdef CONFIG_SENDMMSG
+		free(nd->msgs);
+		free(nd->iovecs);
+#endif
 		free(nd);
 	}
 }
@@ -1240,6 +1341,7 @@ static struct ioengine_ops ioengine_splice = {
 	.version		= FIO_IOOPS_VERSION,
 	.prep			= fio_netio_prep,
 	.queue			= fio_netio_queue,
+	.queue_batch		= fio_netio_queue_batch,
 	.setup			= fio_netio_setup_splice,
 	.init			= fio_netio_init,
 	.cleanup		= fio_netio_cleanup,
@@ -1258,6 +1360,7 @@ static struct ioengine_ops ioengine_rw = {
 	.version		= FIO_IOOPS_VERSION,
 	.prep			= fio_netio_prep,
 	.queue			= fio_netio_queue,
+	.queue_batch		= fio_netio_queue_batch,
 	.setup			= fio_netio_setup,
 	.init			= fio_netio_init,
 	.cleanup		= fio_netio_cleanup,
@@ -1049,6 +1049,7 @@ static int check_set_rlimits(struct thread_data *td)
 static int fio_rdmaio_init(struct thread_data *td)
 {
 	struct rdmaio_data *rd = td->io_ops->data;
+	struct io_u *io_u;
 	unsigned int max_bs;
 	unsigned int port;
 	char host[64], buf[128];
@@ -1151,10 +1152,8 @@ static int fio_rdmaio_init(struct thread_data *td)
 	}
 
 	max_bs = max(td->o.max_bs[DDIR_READ], td->o.max_bs[DDIR_WRITE]);
-	/* register each io_u in the free list */
-	for (i = 0; i < td->io_u_freelist.nr; i++) {
-		struct io_u *io_u = td->io_u_freelist.io_us[i];
-
+	/* register each io_u */
+	io_u_qiter(&td->io_u_all, io_u, i) {
 		io_u->engine_data = malloc(sizeof(struct rdma_io_u_data));
 		memset(io_u->engine_data, 0, sizeof(struct rdma_io_u_data));
 		((struct rdma_io_u_data *)io_u->engine_data)->wr_id = i;
@@ -1222,7 +1221,8 @@ static struct ioengine_ops ioengine_rw = {
 	.cleanup	= fio_rdmaio_cleanup,
 	.open_file	= fio_rdmaio_open_file,
 	.close_file	= fio_rdmaio_close_file,
-	.flags		= FIO_DISKLESSIO | FIO_UNIDIR | FIO_PIPEIO,
+	.flags		= FIO_DISKLESSIO | FIO_UNIDIR | FIO_PIPEIO |
+			  FIO_OWNBUF,
 };
 
 static void fio_init fio_rdmaio_register(void)
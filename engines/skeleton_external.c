@@ -78,6 +78,19 @@ static int fio_skeleton_queue(struct thread_data *td, struct io_u *io_u)
 	return FIO_Q_COMPLETED;
 }
 
+/*
+ * The ->queue_batch() hook is handed up to iodepth_batch io_us at once,
+ * each already prepped. It returns how many of them it took, starting
+ * from the first. Those are completed if the engine has no ->commit()
+ * hook and queued if it does. The rest are passed to ->queue() one by
+ * one. Not required.
+ */
+static int fio_skeleton_queue_batch(struct thread_data *td,
+				    struct io_u **io_us, unsigned int nr)
+{
+	return 0;
+}
+
 /*
  * The ->prep() function is called for each io_u prior to being submitted
  * with ->queue(). This hook allows the io engine to perform any
@@ -134,6 +147,7 @@ struct ioengine_ops ioengine = {
 	.init		= fio_skeleton_init,
 	.prep		= fio_skeleton_prep,
 	.queue		= fio_skeleton_queue,
+	.queue_batch	= fio_skeleton_queue_batch,
 	.cancel		= fio_skeleton_cancel,
 	.getevents	= fio_skeleton_getevents,
 	.event		= fio_skeleton_event,
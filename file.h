@@ -55,6 +55,21 @@ enum fio_fallocate_mode {
 	FIO_FALLOCATE_KEEP_SIZE	= 3,
 };
 
+/*
+ * Random offsets and lengths generated ahead of use, see offset_prefetch.
+ * They are marked in the random map when generated.
+ */
+struct fio_prefetch_io {
+	uint64_t offset;
+	unsigned int buflen;
+};
+
+struct fio_prefetch {
+	unsigned int head;
+	unsigned int nr;
+	struct fio_prefetch_io ios[0];
+};
+
 /*
  * Each thread_data structure has a number of files associated with it,
  * this structure holds state information for a single file.
@@ -91,6 +106,11 @@ struct fio_file {
 	uint64_t last_pos;
 	uint64_t last_start;
 
+	/*
+	 * Position in the striped order of open-channel geometry offsets
+	 */
+	uint64_t nvm_pos;
+
 	uint64_t first_write;
 	uint64_t last_write;
 
@@ -114,11 +134,28 @@ struct fio_file {
 
 	struct fio_lfsr lfsr;
 
+	/*
+	 * Per data direction, with offset_prefetch
+	 */
+	struct fio_prefetch *prefetch[DDIR_RWDIR_CNT];
+
 	/*
 	 * Used for zipf random distribution
 	 */
 	struct zipf_state zipf;
 
+	/*
+	 * Zone state with zonemode=zbd
+	 */
+	struct zoned_block_device_info *zbd_info;
+
+	/*
+	 * Loop each verify block was last written in, with
+	 * verify_history=map. Zero if it hasn't been written.
+	 */
+	uint8_t *verify_gen_map;
+	uint64_t verify_gen_blocks;
+
 	int references;
 	enum fio_file_flags flags;
 
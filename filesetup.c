@@ -10,6 +10,7 @@
 
 #include "fio.h"
 #include "smalloc.h"
+#include "zbd.h"
 #include "filehash.h"
 #include "options.h"
 #include "os/os.h"
@@ -953,7 +954,10 @@ int setup_files(struct thread_data *td)
 	if (err)
 		goto err_out;
 
-	if (!o->zone_size)
+	if (o->zone_mode == ZONE_MODE_ZBD) {
+		if (zbd_init(td))
+			goto err_out;
+	} else if (!o->zone_size)
 		o->zone_size = o->size;
 
 	/*
@@ -1096,6 +1100,7 @@ void close_and_free_files(struct thread_data *td)
 {
 	struct fio_file *f;
 	unsigned int i;
+	int j;
 
 	dprint(FD_FILE, "close files\n");
 
@@ -1119,6 +1124,13 @@ void close_and_free_files(struct thread_data *td)
 		f->file_name = NULL;
 		axmap_free(f->io_axmap);
 		f->io_axmap = NULL;
+		free(f->verify_gen_map);
+		f->verify_gen_map = NULL;
+		for (j = 0; j < DDIR_RWDIR_CNT; j++) {
+			free(f->prefetch[j]);
+			f->prefetch[j] = NULL;
+		}
+		zbd_free_zone_info(f);
 		sfree(f);
 	}
 
@@ -1543,8 +1555,19 @@ void free_release_files(struct thread_data *td)
 
 void fio_file_reset(struct thread_data *td, struct fio_file *f)
 {
+	int i;
+
+	/*
+	 * What was generated ahead is in the random map we are clearing
+	 */
+	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
+		if (f->prefetch[i])
+			f->prefetch[i]->head = f->prefetch[i]->nr = 0;
+	}
+
 	f->last_pos = f->file_offset;
 	f->last_start = -1ULL;
+	f->nvm_pos = 0;
 	if (f->io_axmap)
 		axmap_reset(f->io_axmap);
 	if (td->o.random_generator == FIO_RAND_GEN_LFSR)
@@ -40,6 +40,7 @@
 #include "stat.h"
 #include "flow.h"
 #include "io_u_queue.h"
+#include "reap.h"
 
 #ifdef CONFIG_SOLARISAIO
 #include <sys/asynch.h>
@@ -74,6 +75,7 @@ enum {
 	TD_F_COMPRESS		= 128,
 	TD_F_NOIO		= 256,
 	TD_F_COMPRESS_LOG	= 512,
+	TD_F_COMPRESS_INIT	= 1024,
 };
 
 enum {
@@ -89,6 +91,8 @@ enum {
 	FIO_RAND_SEQ_RAND_WRITE_OFF,
 	FIO_RAND_SEQ_RAND_TRIM_OFF,
 	FIO_RAND_START_DELAY,
+	FIO_RAND_ENGINE_OFF,
+	FIO_RAND_DEDUPE_OFF,
 	FIO_RAND_NR_OFFS,
 };
 
@@ -145,6 +149,13 @@ struct thread_data {
 	pid_t pid;
 	char *orig_buffer;
 	size_t orig_buffer_size;
+
+	/*
+	 * Write data generated up front for buffer_pool, see io_u_pool_buf()
+	 */
+	char *buf_pool;
+	unsigned long buf_pool_windows;
+	unsigned int buf_pool_align;
 	volatile int terminate;
 	volatile int runstate;
 	unsigned int last_was_sync;
@@ -178,6 +189,15 @@ struct thread_data {
 
 	struct frand_state buf_state;
 
+	/*
+	 * Random bytes per 64k of each compress segment, and a ring of the
+	 * seeds of earlier buffers for dedupe_percentage to repeat
+	 */
+	unsigned int compress_rand;
+	struct frand_state dedupe_state;
+	unsigned long *dedupe_seeds;
+	unsigned long dedupe_nr;
+
 	unsigned int verify_batch;
 	unsigned int trim_batch;
 
@@ -205,22 +225,28 @@ struct thread_data {
 	unsigned int io_u_in_flight;
 
 	/*
-	 * List of free and busy io_u's
+	 * List of free and busy io_u's. Async verify threads put io_us
+	 * back on the freelist too, only the job thread takes them off.
 	 */
 	struct io_u_ring io_u_requeues;
-	struct io_u_queue io_u_freelist;
+	struct io_u_mpsc io_u_freelist;
 	struct io_u_queue io_u_all;
 	pthread_mutex_t io_u_lock;
 	pthread_cond_t free_cond;
+	volatile int io_u_free_waiting;
 
 	/*
-	 * async verify offload
+	 * async verify offload, a queue per verify thread. See verify.c
 	 */
-	struct flist_head verify_list;
-	pthread_t *verify_threads;
+	struct verify_worker *verify_workers;
 	unsigned int nr_verify_threads;
-	pthread_cond_t verify_cond;
-	int verify_thread_exit;
+	unsigned int verify_next;
+	volatile int verify_thread_exit;
+
+	/*
+	 * completion reaping offload, see reap.c
+	 */
+	struct reap_data *reap;
 
 	/*
 	 * Rate state
@@ -298,6 +324,15 @@ struct thread_data {
 	struct flist_head io_hist_list;
 	unsigned long io_hist_len;
 
+	/*
+	 * With verify_history=loop or map nothing is logged, writes are
+	 * tagged with the loop they were done in and the verify pass reads
+	 * the files back in order, from this file and block on.
+	 */
+	unsigned int verify_gen;
+	unsigned int verify_sweep_file;
+	uint64_t verify_sweep_block;
+
 	/*
 	 * For IO replaying
 	 */
@@ -600,6 +635,25 @@ static inline unsigned int td_min_bs(struct thread_data *td)
 	return min(td->o.min_bs[DDIR_TRIM], min_bs);
 }
 
+/*
+ * Size of one multi-plane page program on an open-channel device
+ */
+static inline unsigned int td_nvm_page_size(struct thread_data *td)
+{
+	return td->o.nvm_sector_size * td->o.nvm_sectors_per_page *
+		td->o.nvm_planes;
+}
+
+/*
+ * Amount written to one parallel unit before moving on to the next, the
+ * largest of a page program and the block size.
+ */
+static inline unsigned int td_nvm_stripe_unit(struct thread_data *td)
+{
+	return max(td_nvm_page_size(td),
+		   max(td->o.max_bs[DDIR_READ], td->o.max_bs[DDIR_WRITE]));
+}
+
 static inline int is_power_of_2(unsigned long val)
 {
 	return (val != 0 && ((val & (val - 1)) == 0));
@@ -621,10 +675,37 @@ static inline void td_io_u_unlock(struct thread_data *td)
 		pthread_mutex_unlock(&td->io_u_lock);
 }
 
+/*
+ * Pairs with the wait in __get_io_u(), either it sees the io_u we just put
+ * on the freelist or we see it waiting
+ */
 static inline void td_io_u_free_notify(struct thread_data *td)
 {
-	if (td->o.verify_async)
+	if (!td->o.verify_async)
+		return;
+
+	__sync_synchronize();
+	if (td->io_u_free_waiting) {
+		pthread_mutex_lock(&td->io_u_lock);
 		pthread_cond_signal(&td->free_cond);
+		pthread_mutex_unlock(&td->io_u_lock);
+	}
+}
+
+/*
+ * Completions are accounted on the reaper thread while it runs, inline
+ * completions on the job thread must hold this
+ */
+static inline void td_reap_lock(struct thread_data *td)
+{
+	if (td->reap)
+		pthread_mutex_lock(&td->reap->lock);
+}
+
+static inline void td_reap_unlock(struct thread_data *td)
+{
+	if (td->reap)
+		pthread_mutex_unlock(&td->reap->lock);
 }
 
 extern const char *fio_get_arch_string(int);
@@ -646,11 +727,21 @@ enum {
 	FIO_RAND_DIST_PARETO,
 };
 
+enum {
+	ZONE_MODE_NONE		= 0,
+	ZONE_MODE_ZBD,
+};
+
 enum {
 	FIO_RAND_GEN_TAUSWORTHE = 0,
 	FIO_RAND_GEN_LFSR,
 };
 
+enum {
+	FIO_COMPRESS_CAL_NONE = 0,
+	FIO_COMPRESS_CAL_ZLIB,
+};
+
 enum {
 	FIO_CPUS_SHARED		= 0,
 	FIO_CPUS_SPLIT,
@@ -457,6 +457,67 @@ static int fixed_block_size(struct thread_options *o)
 		o->min_bs[DDIR_READ] == o->min_bs[DDIR_TRIM];
 }
 
+/*
+ * verify_history=loop and map work out what a block should hold from
+ * where it is, so every write has to cover whole verify blocks at fixed
+ * positions and the headers can't carry anything else.
+ */
+static int fixup_verify_history(struct thread_data *td)
+{
+	struct thread_options *o = &td->o;
+	int ret = 0;
+
+	if (!o->verify_interval ||
+	    o->min_bs[DDIR_WRITE] % o->verify_interval ||
+	    o->ba[DDIR_WRITE] % o->verify_interval) {
+		log_err("fio: verify_history needs verify_interval to divide"
+			" the block size and alignment\n");
+		ret = 1;
+	}
+	if (o->bs_unaligned) {
+		log_err("fio: verify_history can't be used with"
+			" bs_unaligned\n");
+		ret = 1;
+	}
+	if (o->verify == VERIFY_META) {
+		log_err("fio: verify_history can't be used with"
+			" verify=meta\n");
+		ret = 1;
+	}
+	if (o->verify_backlog || o->experimental_verify) {
+		log_err("fio: verify_history can't be used with"
+			" verify_backlog or experimental_verify\n");
+		ret = 1;
+	}
+	if (o->trim_percentage) {
+		log_err("fio: verify_history can't be used with"
+			" trim_percentage\n");
+		ret = 1;
+	}
+	if (o->zone_skip || o->zone_append) {
+		log_err("fio: verify_history can't be used with"
+			" zoneskip or zone_append\n");
+		ret = 1;
+	}
+
+	/*
+	 * The verify pass reads back all of the files. A loop that may not
+	 * write every block leaves some unwritten or from an earlier loop,
+	 * only the generation map can tell.
+	 */
+	if (o->verify_history == VERIFY_HIST_LOOP && td_write(td) &&
+	    ((td_random(td) && o->norandommap) || o->time_based ||
+	     td_rw(td) || o->number_ios || o->io_limit)) {
+		log_err("fio: verify_history=loop needs every block written"
+			" each loop, use verify_history=map with norandommap,"
+			" time_based, mixed reads and writes, number_ios"
+			" or io_limit\n");
+		ret = 1;
+	}
+
+	return ret;
+}
+
 
 static unsigned long long get_rand_start_delay(struct thread_data *td)
 {
@@ -503,18 +564,44 @@ static int fixup_options(struct thread_data *td)
 		ret = warnings_fatal;
 	}
 
-	/*
-	 * only really works with 1 file
-	 */
-	if (o->zone_size && o->open_files > 1)
-		o->zone_size = 0;
+	if (o->zone_mode == ZONE_MODE_ZBD) {
+		/*
+		 * zonesize is the emulated zone size here, IO is not
+		 * restricted to a zone range
+		 */
+		if (o->zone_range || o->zone_skip) {
+			log_err("fio: zonerange and zoneskip can't be used"
+				" with zonemode=zbd\n");
+			ret = 1;
+		}
+		/*
+		 * The meta header records the offset it was written to,
+		 * which isn't known until an append is placed
+		 */
+		if (o->zone_append && o->verify == VERIFY_META) {
+			log_err("fio: verify=meta can't be used with"
+				" zone_append\n");
+			ret = 1;
+		}
+	} else {
+		if (o->zone_append) {
+			log_err("fio: zone_append requires zonemode=zbd\n");
+			ret = 1;
+		}
 
-	/*
-	 * If zone_range isn't specified, backward compatibility dictates it
-	 * should be made equal to zone_size.
-	 */
-	if (o->zone_size && !o->zone_range)
-		o->zone_range = o->zone_size;
+		/*
+		 * only really works with 1 file
+		 */
+		if (o->zone_size && o->open_files > 1)
+			o->zone_size = 0;
+
+		/*
+		 * If zone_range isn't specified, backward compatibility
+		 * dictates it should be made equal to zone_size.
+		 */
+		if (o->zone_size && !o->zone_range)
+			o->zone_range = o->zone_size;
+	}
 
 	/*
 	 * Reads can do overwrites, we always need to pre-create the file
@@ -565,6 +652,7 @@ static int fixup_options(struct thread_data *td)
 		o->start_delay = get_rand_start_delay(td);
 
 	if (o->norandommap && o->verify != VERIFY_NONE
+	    && o->verify_history == VERIFY_HIST_LOG
 	    && !fixed_block_size(o))  {
 		log_err("fio: norandommap given for variable block sizes, "
 			"verify disabled\n");
@@ -592,6 +680,22 @@ static int fixup_options(struct thread_data *td)
 	if (o->iodepth_batch > o->iodepth || !o->iodepth_batch)
 		o->iodepth_batch = o->iodepth;
 
+	/*
+	 * The reaper calls into the engine while the job thread queues, and
+	 * the latency target is tuned from both sides
+	 */
+	if (o->reap_thread) {
+		if (!(td->io_ops->flags & FIO_ASYNC_REAP)) {
+			log_err("fio: ioengine %s does not support reap_thread\n",
+					td->io_ops->name);
+			ret = 1;
+		}
+		if (o->latency_target) {
+			log_err("fio: reap_thread and latency_target are mutually exclusive\n");
+			ret = 1;
+		}
+	}
+
 	if (o->nr_files > td->files_index)
 		o->nr_files = td->files_index;
 
@@ -633,7 +737,8 @@ static int fixup_options(struct thread_data *td)
 		}
 
 		o->refill_buffers = 1;
-		if (o->max_bs[DDIR_WRITE] != o->min_bs[DDIR_WRITE] &&
+		if ((o->max_bs[DDIR_WRITE] != o->min_bs[DDIR_WRITE] ||
+		     o->verify_history != VERIFY_HIST_LOG) &&
 		    !o->verify_interval)
 			o->verify_interval = o->min_bs[DDIR_WRITE];
 
@@ -645,6 +750,10 @@ static int fixup_options(struct thread_data *td)
 			o->verify_interval = o->min_bs[DDIR_WRITE];
 		else if (td_read(td) && o->verify_interval > o->min_bs[DDIR_READ])
 			o->verify_interval = o->min_bs[DDIR_READ];
+
+		if (o->verify_history != VERIFY_HIST_LOG &&
+		    fixup_verify_history(td))
+			ret = 1;
 	}
 
 	if (o->pre_read) {
@@ -704,6 +813,28 @@ static int fixup_options(struct thread_data *td)
 	if (td->o.random_distribution != FIO_RAND_DIST_RANDOM)
 		td->o.norandommap = 1;
 
+	if (o->nvm_channels) {
+		unsigned int su = td_nvm_stripe_unit(td);
+		unsigned int blk = td_nvm_page_size(td) * o->nvm_pages_per_block;
+		int i;
+
+		for (i = DDIR_READ; i <= DDIR_WRITE; i++) {
+			if (o->min_bs[i] != o->max_bs[i] || su % o->min_bs[i]) {
+				log_err("fio: nvm geometry needs a fixed block "
+					"size that divides the stripe unit (%u)\n",
+					su);
+				ret = 1;
+				break;
+			}
+		}
+		if (su % td_nvm_page_size(td) || blk % su) {
+			log_err("fio: nvm stripe unit %u must be a multiple of "
+				"the page size %u and divide the block size %u\n",
+				su, td_nvm_page_size(td), blk);
+			ret = 1;
+		}
+	}
+
 	/*
 	 * If size is set but less than the min block size, complain
 	 */
@@ -847,6 +978,7 @@ void td_fill_rand_seeds(struct thread_data *td)
 		td_fill_rand_seeds_internal(td);
 
 	init_rand_seed(&td->buf_state, td->rand_seeds[FIO_RAND_BUF_OFF]);
+	init_rand_seed(&td->dedupe_state, td->rand_seeds[FIO_RAND_DEDUPE_OFF]);
 }
 
 /*
@@ -919,7 +1051,10 @@ static void init_flags(struct thread_data *td)
 		td->flags |= TD_F_TRIM_BACKLOG;
 	if (o->read_iolog_file)
 		td->flags |= TD_F_READ_IOLOG;
-	if (o->refill_buffers)
+	/*
+	 * Buffers filled once would repeat themselves regardless
+	 */
+	if (o->refill_buffers || o->dedupe_percentage)
 		td->flags |= TD_F_REFILL_BUFFERS;
 	if (o->scramble_buffers)
 		td->flags |= TD_F_SCRAMBLE_BUFFERS;
@@ -1143,6 +1278,12 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 		td->ts.lat_stat[i].min_val = ULONG_MAX;
 		td->ts.bw_stat[i].min_val = ULONG_MAX;
 	}
+	for (i = 0; i < FIO_IO_OP_NR; i++)
+		td->ts.io_op_clat_stat[i].min_val = ULONG_MAX;
+	td->ts.ftl_gc_stat.min_val = ULONG_MAX;
+	td->ts.zone_reset_stat.min_val = ULONG_MAX;
+	td->ts.zone_append_bw_stat.min_val = ULONG_MAX;
+	td->ts.verify_async_wait_stat.min_val = ULONG_MAX;
 	td->ddir_seq_nr = o->ddir_seq_nr;
 
 	if ((o->stonewall || o->new_group) && prev_group_jobs) {
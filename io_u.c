@@ -4,6 +4,9 @@
 #include <signal.h>
 #include <time.h>
 #include <assert.h>
+#ifdef CONFIG_ZLIB
+#include <zlib.h>
+#endif
 
 #include "fio.h"
 #include "hash.h"
@@ -12,9 +15,12 @@
 #include "lib/rand.h"
 #include "lib/axmap.h"
 #include "err.h"
+#include "zbd.h"
+#include "reap.h"
 
 struct io_completion_data {
 	int nr;				/* input */
+	struct io_u_spsc *done;		/* input, hand io_us back here */
 
 	int error;			/* output */
 	uint64_t bytes_done[DDIR_RWDIR_CNT];	/* output */
@@ -268,11 +274,69 @@ static int get_next_rand_block(struct thread_data *td, struct fio_file *f,
 	return 1;
 }
 
+/*
+ * Sequential offsets laid out over an open-channel geometry. The file is
+ * split into one region per parallel unit (LUN), and each stripe unit
+ * goes to the next of nvm_stripe_units units in turn, channel first, so
+ * that consecutive ios land on different channels. Within a unit the
+ * region is written in order, so every erase block is written strictly
+ * sequentially. When the active units are full, the next set of units
+ * is used.
+ */
+static int get_next_nvm_offset(struct thread_data *td, struct fio_file *f,
+			       enum fio_ddir ddir, uint64_t *offset)
+{
+	const unsigned int nr_units = td->o.nvm_channels * td->o.nvm_luns;
+	const uint64_t su = td_nvm_stripe_unit(td);
+	uint64_t blk_size, unit_size, per_unit, s, r, w, group;
+	unsigned int active, n, u, pu;
+
+	blk_size = (uint64_t) td_nvm_page_size(td) * td->o.nvm_pages_per_block;
+	unit_size = (f->io_size / nr_units / blk_size) * blk_size;
+	per_unit = unit_size / su;
+	if (!per_unit) {
+		log_err("fio: %s is too small for the nvm geometry, need at "
+			"least one erase block (%llu) per unit\n", f->file_name,
+			(unsigned long long) blk_size);
+		return 1;
+	}
+
+	if (f->nvm_pos >= nr_units * unit_size) {
+		if (!td->o.time_based)
+			return 1;
+		f->nvm_pos = 0;
+	}
+
+	active = td->o.nvm_stripe_units;
+	if (!active || active > nr_units)
+		active = nr_units;
+
+	s = f->nvm_pos / su;
+	group = s / (active * per_unit);
+	r = s - group * active * per_unit;
+	n = min(active, nr_units - (unsigned int) group * active);
+	w = r / n;
+	u = group * active + r % n;
+
+	pu = (u % td->o.nvm_channels) * td->o.nvm_luns +
+		u / td->o.nvm_channels;
+
+	*offset = pu * unit_size + w * su + f->nvm_pos % su;
+	f->nvm_pos += td->o.min_bs[ddir];
+
+	dprint(FD_IO, "nvm: unit %u, stripe %llu, offset %llu\n", pu,
+			(unsigned long long) w, (unsigned long long) *offset);
+	return 0;
+}
+
 static int get_next_seq_offset(struct thread_data *td, struct fio_file *f,
 			       enum fio_ddir ddir, uint64_t *offset)
 {
 	assert(ddir_rw(ddir));
 
+	if (td->o.nvm_channels)
+		return get_next_nvm_offset(td, f, ddir, offset);
+
 	if (f->last_pos >= f->io_size + get_start_offset(td, f) && td->o.time_based)
 		f->last_pos = f->last_pos - f->io_size;
 
@@ -499,6 +563,166 @@ static unsigned int get_next_buflen(struct thread_data *td, struct io_u *io_u,
 	return __get_next_buflen(td, io_u, is_random);
 }
 
+/*
+ * With offset_prefetch, random offsets and lengths are generated in
+ * batches per file and data direction instead of one io at a time. Only
+ * for pure random io, where the next offset doesn't depend on the last
+ * one issued.
+ */
+static int should_prefetch(struct thread_data *td, enum fio_ddir ddir)
+{
+	if (!td->o.offset_prefetch || !td_random(td))
+		return 0;
+	if (td->flags & TD_F_PROFILE_OPS)
+		return 0;
+	if (td->o.perc_rand[ddir] != 100 || td->o.ddir_seq_nr > 1 ||
+	    td->o.zone_skip)
+		return 0;
+
+	return !should_sort_io(td);
+}
+
+static int prefetch_fill(struct thread_data *td, struct fio_file *f,
+			 enum fio_ddir ddir)
+{
+	struct fio_prefetch *p = f->prefetch[ddir];
+	struct io_u io_u;
+	unsigned int i;
+
+	if (!p) {
+		p = malloc(sizeof(*p) +
+			td->o.offset_prefetch * sizeof(struct fio_prefetch_io));
+		if (!p)
+			return 1;
+		f->prefetch[ddir] = p;
+	}
+
+	p->head = p->nr = 0;
+
+	memset(&io_u, 0, sizeof(io_u));
+	io_u.file = f;
+	io_u.ddir = ddir;
+
+	for (i = 0; i < td->o.offset_prefetch; i++) {
+		uint64_t b;
+		int ret;
+
+		/*
+		 * Only the first one may reset the file for time_based, that
+		 * would drop the ones generated before it
+		 */
+		if (!i)
+			ret = get_next_rand_block(td, f, ddir, &b);
+		else
+			ret = get_next_rand_offset(td, f, ddir, &b);
+		if (ret)
+			break;
+
+		io_u.offset = b * td->o.ba[ddir];
+		if (io_u.offset >= f->io_size)
+			break;
+		io_u.offset += f->file_offset;
+		if (io_u.offset >= f->real_file_size)
+			break;
+
+		io_u.buflen = __get_next_buflen(td, &io_u, 1);
+		if (!io_u.buflen ||
+		    io_u.offset + io_u.buflen > f->real_file_size)
+			break;
+
+		/*
+		 * Mark it right away, so the next ones don't pick it too
+		 */
+		if (file_randommap(td, f))
+			mark_random_map(td, &io_u);
+
+		p->ios[p->nr].offset = io_u.offset;
+		p->ios[p->nr].buflen = io_u.buflen;
+		p->nr++;
+	}
+
+	dprint(FD_RANDOM, "%s: prefetched %u offsets, ddir %d\n",
+					f->file_name, p->nr, ddir);
+	return !p->nr;
+}
+
+/*
+ * ddir ran out of offsets, while the other directions may still hold some
+ * that were generated ahead and never issued. With a random map, give
+ * them back to it and generate again for ddir. Without one, take them
+ * over as they are.
+ */
+static int prefetch_reclaim(struct thread_data *td, struct fio_file *f,
+			    enum fio_ddir ddir)
+{
+	const unsigned int min_bs = td->o.rw_min_bs;
+	struct fio_prefetch *p = f->prefetch[ddir];
+	struct io_u io_u;
+	int odir;
+
+	if (!p)
+		return 1;
+
+	memset(&io_u, 0, sizeof(io_u));
+	io_u.file = f;
+	io_u.ddir = ddir;
+
+	for (odir = DDIR_READ; odir < DDIR_RWDIR_CNT; odir++) {
+		struct fio_prefetch *o = f->prefetch[odir];
+
+		if (odir == ddir || !o)
+			continue;
+
+		while (o->head < o->nr) {
+			struct fio_prefetch_io *pio = &o->ios[o->head++];
+
+			if (file_randommap(td, f)) {
+				uint64_t block;
+				unsigned int i, nr;
+
+				block = (pio->offset - f->file_offset) / min_bs;
+				nr = (pio->buflen + min_bs - 1) / min_bs;
+				for (i = 0; i < nr; i++)
+					axmap_clear(f->io_axmap, block + i);
+				continue;
+			}
+
+			io_u.offset = pio->offset;
+			io_u.buflen = __get_next_buflen(td, &io_u, 1);
+			if (!io_u.buflen ||
+			    io_u.offset + io_u.buflen > f->real_file_size)
+				continue;
+
+			p->ios[p->nr].offset = io_u.offset;
+			p->ios[p->nr].buflen = io_u.buflen;
+			p->nr++;
+		}
+	}
+
+	if (file_randommap(td, f))
+		return prefetch_fill(td, f, ddir);
+
+	return !p->nr;
+}
+
+static int get_next_prefetched(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	struct fio_prefetch *p = f->prefetch[io_u->ddir];
+
+	if (!p || p->head == p->nr) {
+		if (prefetch_fill(td, f, io_u->ddir) &&
+		    prefetch_reclaim(td, f, io_u->ddir))
+			return 1;
+		p = f->prefetch[io_u->ddir];
+	}
+
+	io_u->offset = p->ios[p->head].offset;
+	io_u->buflen = p->ios[p->head].buflen;
+	p->head++;
+	return 0;
+}
+
 static void set_rwmix_bytes(struct thread_data *td)
 {
 	unsigned int diff;
@@ -541,7 +765,16 @@ void io_u_quiesce(struct thread_data *td)
 	 * td->cur_depth, b/c td->cur_depth does not accurately represent
 	 * io's that have been actually submitted to an async engine,
 	 * and cur_depth is meaningless for sync engines.
+	 *
+	 * Commit first, anything still queued would otherwise be submitted
+	 * behind the back of the in flight accounting.
 	 */
+	if (td->io_u_queued || td->cur_depth) {
+		int fio_unused ret;
+
+		ret = td_io_commit(td);
+	}
+
 	while (td->io_u_in_flight) {
 		int fio_unused ret;
 
@@ -686,18 +919,51 @@ void put_file_log(struct thread_data *td, struct fio_file *f)
 
 void put_io_u(struct thread_data *td, struct io_u *io_u)
 {
-	td_io_u_lock(td);
+	if (io_u->flags & IO_U_F_ZBD_WRITE)
+		zbd_put_io(td, io_u);
 
-	if (io_u->file && !(io_u->flags & IO_U_F_NO_FILE_PUT))
-		put_file_log(td, io_u->file);
+	/*
+	 * Async verify threads put io_us whose file and depth were already
+	 * dropped, they only touch the freelist and don't need the lock
+	 */
+	if ((io_u->file && !(io_u->flags & IO_U_F_NO_FILE_PUT)) ||
+	    (io_u->flags & IO_U_F_IN_CUR_DEPTH)) {
+		td_io_u_lock(td);
+
+		if (io_u->file && !(io_u->flags & IO_U_F_NO_FILE_PUT))
+			put_file_log(td, io_u->file);
+		if (io_u->flags & IO_U_F_IN_CUR_DEPTH)
+			td->cur_depth--;
+
+		td_io_u_unlock(td);
+	}
 
 	io_u->file = NULL;
 	io_u->flags |= IO_U_F_FREE;
+	io_u_mpsc_push(&td->io_u_freelist, io_u);
+	td_io_u_free_notify(td);
+}
 
-	if (io_u->flags & IO_U_F_IN_CUR_DEPTH)
-		td->cur_depth--;
-	io_u_qpush(&td->io_u_freelist, io_u);
-	td_io_u_unlock(td);
+/*
+ * put_io_u() for io_us whose file and depth were already dropped, like
+ * the async verify threads have. They go back with a single push.
+ */
+void put_io_u_batch(struct thread_data *td, struct io_u **io_us,
+		    unsigned int nr)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		struct io_u *io_u = io_us[i];
+
+		if (io_u->flags & IO_U_F_ZBD_WRITE)
+			zbd_put_io(td, io_u);
+
+		io_u->file = NULL;
+		io_u->flags |= IO_U_F_FREE;
+	}
+
+	io_u_mpsc_push_batch(&td->io_u_freelist, io_us, nr);
 	td_io_u_free_notify(td);
 }
 
@@ -754,6 +1020,17 @@ static int fill_io_u(struct thread_data *td, struct io_u *io_u)
 		td->io_skip_bytes += td->o.zone_skip;
 	}
 
+	/*
+	 * Generated ahead of time, already in the random map
+	 */
+	if (should_prefetch(td, io_u->ddir)) {
+		if (get_next_prefetched(td, io_u)) {
+			dprint(FD_IO, "io_u %p, failed getting offset\n", io_u);
+			return 1;
+		}
+		goto prefetched;
+	}
+
 	/*
 	 * No log, let the seq/rand engine retrieve the next buflen and
 	 * position.
@@ -783,6 +1060,16 @@ static int fill_io_u(struct thread_data *td, struct io_u *io_u)
 	if (td_random(td) && file_randommap(td, io_u->file))
 		mark_random_map(td, io_u);
 
+prefetched:
+	/*
+	 * The random map tracks the offsets that were generated, zoned
+	 * writes may end up anywhere in the target zone
+	 */
+	if (zbd_adjust_block(td, io_u)) {
+		dprint(FD_IO, "io_u %p, no zone to do IO to\n", io_u);
+		return 1;
+	}
+
 out:
 	dprint_io_u(io_u, "fill_io_u");
 	td->zone_bytes += io_u->buflen;
@@ -1283,7 +1570,7 @@ void lat_target_check(struct thread_data *td)
  */
 int queue_full(struct thread_data *td)
 {
-	const int qempty = io_u_qempty(&td->io_u_freelist);
+	const int qempty = io_u_mpsc_empty(&td->io_u_freelist);
 
 	if (qempty)
 		return 1;
@@ -1303,7 +1590,7 @@ again:
 	if (!io_u_rempty(&td->io_u_requeues))
 		io_u = io_u_rpop(&td->io_u_requeues);
 	else if (!queue_full(td)) {
-		io_u = io_u_qpop(&td->io_u_freelist);
+		io_u = io_u_mpsc_pop(&td->io_u_freelist);
 
 		io_u->file = NULL;
 		io_u->buflen = 0;
@@ -1325,9 +1612,13 @@ again:
 	} else if (td->o.verify_async) {
 		/*
 		 * We ran out, wait for async verify threads to finish and
-		 * return one
+		 * return one. Pairs with td_io_u_free_notify().
 		 */
-		pthread_cond_wait(&td->free_cond, &td->io_u_lock);
+		td->io_u_free_waiting = 1;
+		__sync_synchronize();
+		if (io_u_mpsc_empty(&td->io_u_freelist))
+			pthread_cond_wait(&td->free_cond, &td->io_u_lock);
+		td->io_u_free_waiting = 0;
 		goto again;
 	}
 
@@ -1388,6 +1679,28 @@ static int check_get_verify(struct thread_data *td, struct io_u *io_u)
 	return 0;
 }
 
+/*
+ * Pick the data for a write from the pool, going by the offset and by how
+ * many writes were done so far. That way a block isn't written with the
+ * same data it already holds, and neighbouring blocks differ. Unless the
+ * engine insists on io_u->buf, the io is done straight from the pool.
+ */
+static void io_u_pool_buf(struct thread_data *td, struct io_u *io_u)
+{
+	uint64_t gen = td->io_issues[DDIR_WRITE];
+	unsigned long idx;
+	void *p;
+
+	idx = __hash_u64(io_u->offset ^ __hash_u64(gen)) % td->buf_pool_windows;
+	p = td->buf_pool + td->o.mem_align + idx * td->buf_pool_align;
+
+	io_u->buf_filled_len = 0;
+	if (td->io_ops->flags & FIO_OWNBUF)
+		memcpy(io_u->buf, p, io_u->buflen);
+	else
+		io_u->xfer_buf = p;
+}
+
 /*
  * Fill offset and start time into the buffer content, to prevent too
  * easy compressible data for simple de-dupe attempts. Do this for every
@@ -1435,7 +1748,7 @@ struct io_u *get_io_u(struct thread_data *td)
 {
 	struct fio_file *f;
 	struct io_u *io_u;
-	int do_scramble = 0;
+	int do_scramble = 0, use_pool = 0;
 	long ret = 0;
 
 	io_u = __get_io_u(td);
@@ -1485,7 +1798,9 @@ struct io_u *get_io_u(struct thread_data *td)
 		f->last_pos = io_u->offset + io_u->buflen;
 
 		if (io_u->ddir == DDIR_WRITE) {
-			if (td->flags & TD_F_REFILL_BUFFERS) {
+			if (td->buf_pool)
+				use_pool = 1;
+			else if (td->flags & TD_F_REFILL_BUFFERS) {
 				io_u_fill_buffer(td, io_u,
 					io_u->xfer_buflen, io_u->xfer_buflen);
 			} else if ((td->flags & TD_F_SCRAMBLE_BUFFERS) &&
@@ -1510,6 +1825,9 @@ struct io_u *get_io_u(struct thread_data *td)
 	io_u->xfer_buf = io_u->buf;
 	io_u->xfer_buflen = io_u->buflen;
 
+	if (use_pool)
+		io_u_pool_buf(td, io_u);
+
 out:
 	assert(io_u->file);
 	if (!td_io_prep(td, io_u)) {
@@ -1586,6 +1904,8 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 
 	if (!td->o.disable_clat) {
 		add_clat_sample(td, idx, lusec, bytes, io_u->offset);
+		if (td->ts.nr_io_ops)
+			add_io_op_clat_sample(td, io_u->io_op, lusec);
 		io_u_mark_latency(td, lusec);
 	}
 
@@ -1625,11 +1945,14 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 	 */
 	if (io_u->ipo) {
 		/*
-		 * Remove errored entry from the verification list
+		 * Remove errored entry from the verification list. When the
+		 * io_u is handed back, the job thread does that as it owns
+		 * the list.
 		 */
-		if (io_u->error)
-			unlog_io_piece(td, io_u);
-		else {
+		if (io_u->error) {
+			if (!icd->done)
+				unlog_io_piece(td, io_u);
+		} else {
 			io_u->ipo->flags &= ~IP_F_IN_FLIGHT;
 			write_barrier();
 		}
@@ -1726,6 +2049,7 @@ static void init_icd(struct thread_data *td, struct io_completion_data *icd,
 		fio_gettime(&icd->time, NULL);
 
 	icd->nr = nr;
+	icd->done = NULL;
 
 	icd->error = 0;
 	for (ddir = DDIR_READ; ddir < DDIR_RWDIR_CNT; ddir++)
@@ -1743,7 +2067,11 @@ static void ios_completed(struct thread_data *td,
 
 		io_completed(td, &io_u, icd);
 
-		if (io_u)
+		if (!io_u)
+			continue;
+		if (icd->done)
+			io_u_spsc_push(icd->done, io_u);
+		else
 			put_io_u(td, io_u);
 	}
 }
@@ -1756,8 +2084,10 @@ int io_u_sync_complete(struct thread_data *td, struct io_u *io_u,
 {
 	struct io_completion_data icd;
 
+	td_reap_lock(td);
 	init_icd(td, &icd, 1);
 	io_completed(td, &io_u, &icd);
+	td_reap_unlock(td);
 
 	if (io_u)
 		put_io_u(td, io_u);
@@ -1790,6 +2120,9 @@ int io_u_queued_complete(struct thread_data *td, int min_evts,
 
 	dprint(FD_IO, "io_u_queued_completed: min=%d\n", min_evts);
 
+	if (td->reap)
+		return reap_complete(td, min_evts, bytes);
+
 	if (!min_evts)
 		tvp = &ts;
 
@@ -1817,6 +2150,32 @@ int io_u_queued_complete(struct thread_data *td, int min_evts,
 	return 0;
 }
 
+/*
+ * Complete nr events that a reaper thread got from the engine. The io_us
+ * are pushed to done rather than put, only the job thread may do that.
+ */
+int io_u_reap_events(struct thread_data *td, int nr, struct io_u_spsc *done,
+		     uint64_t *bytes)
+{
+	struct io_completion_data icd;
+	int ddir;
+
+	init_icd(td, &icd, nr);
+	icd.done = done;
+	ios_completed(td, &icd);
+	io_u_mark_complete(td, nr);
+
+	for (ddir = DDIR_READ; ddir < DDIR_RWDIR_CNT; ddir++)
+		bytes[ddir] += icd.bytes_done[ddir];
+
+	if (icd.error) {
+		td_verror(td, icd.error, "io_u_reap_events");
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Call when io_u is really queued, to update the submission latency.
  */
@@ -1831,25 +2190,159 @@ void io_u_queued(struct thread_data *td, struct io_u *io_u)
 	}
 }
 
+static unsigned int compress_segment(struct thread_data *td,
+				     unsigned int min_write)
+{
+	unsigned int seg = min(min_write, td->o.compress_chunk);
+
+	return seg ? seg : min_write;
+}
+
+#define DEDUPE_SEEDS		4096UL
+#define SAMPLE_SIZE		(128 * 1024)
+
+#ifdef CONFIG_ZLIB
+/*
+ * Find how many random bytes per 64k of segment make zlib shrink a sample
+ * to the asked for size. Random data does not compress at all and zeroes
+ * almost to nothing, but the header and block overhead matter for small
+ * segments, so bisect on what deflate actually does with our buffers.
+ * On failure the plain split is kept.
+ */
+static void calibrate_zlib(struct thread_data *td, unsigned int seg)
+{
+	unsigned int lo = 0, hi = 65536, want;
+	unsigned long bound, clen;
+	void *in, *out;
+
+	bound = compressBound(SAMPLE_SIZE);
+	in = malloc(SAMPLE_SIZE);
+	out = malloc(bound);
+	if (!in || !out) {
+		log_err("fio: failed allocating compression sample\n");
+		goto out;
+	}
+
+	want = (unsigned long long) SAMPLE_SIZE *
+			(100 - td->o.compress_percentage) / 100;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		__fill_random_buf_segments(in, SAMPLE_SIZE, 0x8989,
+				((unsigned long long) seg * mid) >> 16, seg);
+		clen = bound;
+		if (compress2(out, &clen, in, SAMPLE_SIZE,
+				Z_DEFAULT_COMPRESSION) != Z_OK) {
+			log_err("fio: zlib failed compressing sample\n");
+			goto out;
+		}
+
+		if (clen < want)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	dprint(FD_MEM, "compress %u%%, segment %u: %u random bytes per 64k "
+			"(%u without calibration)\n",
+			td->o.compress_percentage, seg, lo, td->compress_rand);
+	td->compress_rand = lo;
+out:
+	free(in);
+	free(out);
+}
+#endif
+
+/*
+ * Done on the first compressible fill, as laying out files may come
+ * before the job is set up
+ */
+static void init_compress(struct thread_data *td)
+{
+	unsigned int min_write = td->o.min_bs[DDIR_WRITE];
+
+	td->compress_rand = (100 - td->o.compress_percentage) * 65536 / 100;
+#ifdef CONFIG_ZLIB
+	if (td->o.compress_calibrate == FIO_COMPRESS_CAL_ZLIB)
+		calibrate_zlib(td, compress_segment(td, min_write));
+#endif
+	td->flags |= TD_F_COMPRESS_INIT;
+}
+
+/*
+ * Set up the history dedupe_percentage picks earlier buffers from
+ */
+int init_fill_state(struct thread_data *td)
+{
+	if (td_write(td) && td->o.dedupe_percentage) {
+		td->dedupe_seeds = calloc(DEDUPE_SEEDS, sizeof(unsigned long));
+		td->dedupe_nr = 0;
+		if (!td->dedupe_seeds) {
+			log_err("fio: failed allocating dedupe history\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void free_fill_state(struct thread_data *td)
+{
+	free(td->dedupe_seeds);
+	td->dedupe_seeds = NULL;
+}
+
+/*
+ * Seed for the next buffer. With dedupe_percentage, that many buffers
+ * reuse the seed of an earlier one and so repeat its contents. Only the
+ * seeds are remembered, the data is generated again.
+ */
+static unsigned long buf_seed(struct thread_data *td)
+{
+	unsigned long seed;
+
+	if (td->dedupe_seeds) {
+		unsigned long r = __rand(&td->dedupe_state);
+		unsigned int v = 1 + (int) (100.0 * (r / (FRAND_MAX + 1.0)));
+
+		if (v <= td->o.dedupe_percentage && td->dedupe_nr) {
+			unsigned long nr = min(td->dedupe_nr, DEDUPE_SEEDS);
+
+			r = __rand(&td->dedupe_state);
+			return td->dedupe_seeds[r % nr];
+		}
+	}
+
+	seed = __rand(&td->buf_state);
+	if (sizeof(int) != sizeof(long *))
+		seed *= (unsigned long) __rand(&td->buf_state);
+
+	if (td->dedupe_seeds)
+		td->dedupe_seeds[td->dedupe_nr++ & (DEDUPE_SEEDS - 1)] = seed;
+
+	return seed;
+}
+
 void fill_io_buffer(struct thread_data *td, void *buf, unsigned int min_write,
 		    unsigned int max_bs)
 {
 	if (td->o.buffer_pattern_bytes)
 		fill_buffer_pattern(td, buf, max_bs);
 	else if (!td->o.zero_buffers) {
-		unsigned int perc = td->o.compress_percentage;
+		unsigned long seed = buf_seed(td);
 
-		if (perc) {
-			unsigned int seg = min_write;
+		if (td->o.compress_percentage) {
+			unsigned int seg = compress_segment(td, min_write);
 
-			seg = min(min_write, td->o.compress_chunk);
-			if (!seg)
-				seg = min_write;
+			if (!(td->flags & TD_F_COMPRESS_INIT))
+				init_compress(td);
 
-			fill_random_buf_percentage(&td->buf_state, buf,
-						perc, seg, max_bs);
+			__fill_random_buf_segments(buf, max_bs, seed,
+				((unsigned long long) seg * td->compress_rand) >> 16,
+				seg);
 		} else
-			fill_random_buf(&td->buf_state, buf, max_bs);
+			__fill_random_buf(buf, max_bs, seed);
 	} else
 		memset(buf, 0, max_bs);
 }
@@ -1863,3 +2356,61 @@ void io_u_fill_buffer(struct thread_data *td, struct io_u *io_u,
 	io_u->buf_filled_len = 0;
 	fill_io_buffer(td, io_u->buf, min_write, max_bs);
 }
+
+/*
+ * With buffer_pool, refill_buffers takes its write data from a pool that
+ * is generated once, instead of generating it again for every write.
+ * Windows into the pool start on a multiple of the compression segment,
+ * so each one is as compressible as a freshly filled buffer.
+ */
+int init_buf_pool(struct thread_data *td)
+{
+	unsigned int min_write = td->o.min_bs[DDIR_WRITE];
+	unsigned int max_bs = td->o.max_bs[DDIR_WRITE];
+	unsigned int align = page_size;
+	unsigned long long size, off;
+	void *p;
+
+	/*
+	 * Verify writes its own data into the buffer, and reusing windows
+	 * would throw dedupe_percentage off
+	 */
+	if (!td->o.buffer_pool || !td_write(td) || td->o.dedupe_percentage ||
+	    !(td->flags & TD_F_REFILL_BUFFERS) || (td->flags & TD_F_VER_NONE))
+		return 0;
+
+	if (td->o.compress_percentage) {
+		unsigned int seg = compress_segment(td, min_write);
+
+		while (align % seg)
+			align += page_size;
+	}
+
+	size = (td->o.buffer_pool + align - 1) / align * align;
+	if (size < max_bs + align)
+		size = (max_bs + 2 * align - 1) / align * align;
+
+	if (posix_memalign(&p, page_size, size + td->o.mem_align)) {
+		log_err("fio: failed allocating %llu bytes for buffer_pool\n",
+				size);
+		return 1;
+	}
+
+	td->buf_pool = p;
+	td->buf_pool_align = align;
+	td->buf_pool_windows = (size - max_bs) / align + 1;
+
+	p += td->o.mem_align;
+	for (off = 0; off < size; off += align)
+		fill_io_buffer(td, p + off, min_write, align);
+
+	dprint(FD_MEM, "buffer pool %p, %llu bytes, %lu windows\n", p, size,
+				td->buf_pool_windows);
+	return 0;
+}
+
+void free_buf_pool(struct thread_data *td)
+{
+	free(td->buf_pool);
+	td->buf_pool = NULL;
+}
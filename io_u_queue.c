@@ -16,19 +16,26 @@ void io_u_qexit(struct io_u_queue *q)
 	free(q->io_us);
 }
 
-int io_u_rinit(struct io_u_ring *ring, unsigned int nr)
+static unsigned int ring_size(unsigned int nr)
 {
-	ring->max = nr + 1;
-	if (ring->max & (ring->max - 1)) {
-		ring->max--;
-		ring->max |= ring->max >> 1;
-		ring->max |= ring->max >> 2;
-		ring->max |= ring->max >> 4;
-		ring->max |= ring->max >> 8;
-		ring->max |= ring->max >> 16;
-		ring->max++;
+	unsigned int max = nr + 1;
+
+	if (max & (max - 1)) {
+		max--;
+		max |= max >> 1;
+		max |= max >> 2;
+		max |= max >> 4;
+		max |= max >> 8;
+		max |= max >> 16;
+		max++;
 	}
 
+	return max;
+}
+
+int io_u_rinit(struct io_u_ring *ring, unsigned int nr)
+{
+	ring->max = ring_size(nr);
 	ring->ring = calloc(ring->max, sizeof(struct io_u *));
 	if (!ring->ring)
 		return 1;
@@ -41,3 +48,39 @@ void io_u_rexit(struct io_u_ring *ring)
 {
 	free(ring->ring);
 }
+
+int io_u_spsc_init(struct io_u_spsc *r, unsigned int nr)
+{
+	unsigned int max = ring_size(nr);
+
+	r->ring = calloc(max, sizeof(struct io_u *));
+	if (!r->ring)
+		return 1;
+
+	r->mask = max - 1;
+	r->head = r->tail = 0;
+	return 0;
+}
+
+void io_u_spsc_exit(struct io_u_spsc *r)
+{
+	free(r->ring);
+}
+
+int io_u_mpsc_init(struct io_u_mpsc *r, unsigned int nr)
+{
+	unsigned int max = ring_size(nr);
+
+	r->ring = calloc(max, sizeof(struct io_u *));
+	if (!r->ring)
+		return 1;
+
+	r->mask = max - 1;
+	r->head = r->tail = 0;
+	return 0;
+}
+
+void io_u_mpsc_exit(struct io_u_mpsc *r)
+{
+	free(r->ring);
+}
@@ -3,6 +3,8 @@
 
 #include <assert.h>
 
+#include "arch/arch.h"
+
 struct io_u;
 
 struct io_u_queue {
@@ -77,4 +79,163 @@ static inline int io_u_rempty(struct io_u_ring *ring)
 	return ring->head == ring->tail;
 }
 
+/*
+ * Rings for handing io_us from one thread to another without a lock.
+ * head is only written by producers and tail only by the consumer, each
+ * on its own cache line so the two sides don't keep stealing the line
+ * from each other. Neither ring checks for overflow, it must be sized to
+ * hold every io_u that can be on it.
+ */
+#define IO_U_RING_CACHELINE	64
+
+struct io_u_spsc {
+	struct io_u **ring;
+	unsigned int mask;
+	char __pad0[IO_U_RING_CACHELINE];
+	unsigned int head;
+	char __pad1[IO_U_RING_CACHELINE];
+	unsigned int tail;
+	char __pad2[IO_U_RING_CACHELINE];
+};
+
+int io_u_spsc_init(struct io_u_spsc *r, unsigned int nr);
+void io_u_spsc_exit(struct io_u_spsc *r);
+
+/*
+ * Single producer, single consumer. A slot is published by the release
+ * of head and handed back by the release of tail.
+ */
+static inline void io_u_spsc_push_batch(struct io_u_spsc *r,
+					struct io_u **io_us, unsigned int nr)
+{
+	const unsigned int head = r->head;
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		r->ring[(head + i) & r->mask] = io_us[i];
+
+	atomic_store_release(&r->head, head + nr);
+}
+
+static inline void io_u_spsc_push(struct io_u_spsc *r, struct io_u *io_u)
+{
+	io_u_spsc_push_batch(r, &io_u, 1);
+}
+
+static inline unsigned int io_u_spsc_pop_batch(struct io_u_spsc *r,
+					       struct io_u **io_us,
+					       unsigned int max)
+{
+	const unsigned int tail = r->tail;
+	unsigned int i, nr;
+
+	nr = atomic_load_acquire(&r->head) - tail;
+	if (nr > max)
+		nr = max;
+
+	for (i = 0; i < nr; i++)
+		io_us[i] = r->ring[(tail + i) & r->mask];
+
+	if (nr)
+		atomic_store_release(&r->tail, tail + nr);
+
+	return nr;
+}
+
+static inline struct io_u *io_u_spsc_pop(struct io_u_spsc *r)
+{
+	struct io_u *io_u;
+
+	if (io_u_spsc_pop_batch(r, &io_u, 1))
+		return io_u;
+
+	return NULL;
+}
+
+static inline int io_u_spsc_empty(struct io_u_spsc *r)
+{
+	return atomic_load_acquire(&r->head) == r->tail;
+}
+
+/*
+ * Entries queued, exact for the producer and the consumer, a snapshot for
+ * anyone else
+ */
+static inline unsigned int io_u_spsc_count(struct io_u_spsc *r)
+{
+	return atomic_load_acquire(&r->head) - atomic_load_acquire(&r->tail);
+}
+
+struct io_u_mpsc {
+	struct io_u **ring;
+	unsigned int mask;
+	char __pad0[IO_U_RING_CACHELINE];
+	unsigned int head;
+	char __pad1[IO_U_RING_CACHELINE];
+	unsigned int tail;
+	char __pad2[IO_U_RING_CACHELINE];
+};
+
+int io_u_mpsc_init(struct io_u_mpsc *r, unsigned int nr);
+void io_u_mpsc_exit(struct io_u_mpsc *r);
+
+/*
+ * Multiple producers, single consumer. Producers reserve slots by moving
+ * head and then fill them in, an empty slot is NULL. A reserved slot that
+ * isn't filled in yet looks empty to the consumer, so it stops there even
+ * if later slots are ready.
+ */
+static inline void io_u_mpsc_push_batch(struct io_u_mpsc *r,
+					struct io_u **io_us, unsigned int nr)
+{
+	const unsigned int head = __sync_fetch_and_add(&r->head, nr);
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		atomic_store_release(&r->ring[(head + i) & r->mask], io_us[i]);
+}
+
+static inline void io_u_mpsc_push(struct io_u_mpsc *r, struct io_u *io_u)
+{
+	io_u_mpsc_push_batch(r, &io_u, 1);
+}
+
+static inline unsigned int io_u_mpsc_pop_batch(struct io_u_mpsc *r,
+					       struct io_u **io_us,
+					       unsigned int max)
+{
+	unsigned int tail = r->tail;
+	unsigned int nr;
+
+	for (nr = 0; nr < max; nr++, tail++) {
+		struct io_u **slot = &r->ring[tail & r->mask];
+
+		io_us[nr] = atomic_load_acquire(slot);
+		if (!io_us[nr])
+			break;
+
+		*slot = NULL;
+	}
+
+	if (nr)
+		atomic_store_release(&r->tail, tail);
+
+	return nr;
+}
+
+static inline struct io_u *io_u_mpsc_pop(struct io_u_mpsc *r)
+{
+	struct io_u *io_u;
+
+	if (io_u_mpsc_pop_batch(r, &io_u, 1))
+		return io_u;
+
+	return NULL;
+}
+
+static inline int io_u_mpsc_empty(struct io_u_mpsc *r)
+{
+	return !atomic_load_acquire(&r->ring[r->tail & r->mask]);
+}
+
 #endif
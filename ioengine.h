@@ -15,7 +15,9 @@
 #include <guasi.h>
 #endif
 
-#define FIO_IOOPS_VERSION	20
+#define FIO_IOOPS_VERSION	21
+
+struct io_u_spsc;
 
 enum {
 	IO_U_F_FREE		= 1 << 0,
@@ -26,6 +28,9 @@ enum {
 	IO_U_F_TRIMMED		= 1 << 5,
 	IO_U_F_BARRIER		= 1 << 6,
 	IO_U_F_VER_LIST		= 1 << 7,
+	IO_U_F_ZBD_WRITE	= 1 << 8,
+	IO_U_F_ZONE_APPEND	= 1 << 9,
+	IO_U_F_ZONE_PLACED	= 1 << 10,
 };
 
 /*
@@ -35,6 +40,17 @@ struct io_u {
 	struct timeval start_time;
 	struct timeval issue_time;
 
+	/*
+	 * When it was queued for a verify_async thread
+	 */
+	struct timeval verify_time;
+
+	/*
+	 * Checksums of its verify blocks worked out ahead of verify_io_u(),
+	 * one per block, or NULL
+	 */
+	uint8_t *verify_digest;
+
 	struct fio_file *file;
 	unsigned int flags;
 	enum fio_ddir ddir;
@@ -76,6 +92,12 @@ struct io_u {
 	unsigned int resid;
 	unsigned int error;
 
+	/*
+	 * Engine command type, for per command type latency accounting.
+	 * Only looked at if the engine has named its types in td->ts.
+	 */
+	unsigned int io_op;
+
 	/*
 	 * io engine private data
 	 */
@@ -85,8 +107,6 @@ struct io_u {
 		void *engine_data;
 	};
 
-	struct flist_head verify_list;
-
 	/*
 	 * Callback for io completion
 	 */
@@ -136,6 +156,7 @@ struct ioengine_ops {
 	int (*init)(struct thread_data *);
 	int (*prep)(struct thread_data *, struct io_u *);
 	int (*queue)(struct thread_data *, struct io_u *);
+	int (*queue_batch)(struct thread_data *, struct io_u **, unsigned int);
 	int (*commit)(struct thread_data *);
 	int (*getevents)(struct thread_data *, unsigned int, unsigned int, struct timespec *);
 	struct io_u *(*event)(struct thread_data *, int);
@@ -168,6 +189,8 @@ enum fio_ioengine_flags {
 	FIO_MEMALIGN	= 1 << 9,	/* engine wants aligned memory */
 	FIO_BIT_BASED	= 1 << 10,	/* engine uses a bit base (e.g. uses Kbit as opposed to KB) */
 	FIO_FAKEIO	= 1 << 11,	/* engine pretends to do IO */
+	FIO_ASYNC_REAP	= 1 << 12,	/* ->getevents() can run beside ->queue() */
+	FIO_OWNBUF	= 1 << 13,	/* engine only does IO from io_u->buf */
 };
 
 /*
@@ -181,6 +204,7 @@ typedef void (*get_ioengine_t)(struct ioengine_ops **);
 extern int __must_check td_io_init(struct thread_data *);
 extern int __must_check td_io_prep(struct thread_data *, struct io_u *);
 extern int __must_check td_io_queue(struct thread_data *, struct io_u *);
+extern void td_io_queue_batch(struct thread_data *, struct io_u **, int *, unsigned int);
 extern int __must_check td_io_sync(struct thread_data *, struct fio_file *);
 extern int __must_check td_io_getevents(struct thread_data *, unsigned int, unsigned int, struct timespec *);
 extern int __must_check td_io_commit(struct thread_data *);
@@ -203,16 +227,22 @@ extern int fio_show_ioengine_help(const char *engine);
 extern struct io_u *__get_io_u(struct thread_data *);
 extern struct io_u *get_io_u(struct thread_data *);
 extern void put_io_u(struct thread_data *, struct io_u *);
+extern void put_io_u_batch(struct thread_data *, struct io_u **, unsigned int);
 extern void clear_io_u(struct thread_data *, struct io_u *);
 extern void requeue_io_u(struct thread_data *, struct io_u **);
 extern int __must_check io_u_sync_complete(struct thread_data *, struct io_u *, uint64_t *);
 extern int __must_check io_u_queued_complete(struct thread_data *, int, uint64_t *);
+extern int __must_check io_u_reap_events(struct thread_data *, int, struct io_u_spsc *, uint64_t *);
 extern void io_u_queued(struct thread_data *, struct io_u *);
 extern void io_u_quiesce(struct thread_data *);
 extern void io_u_log_error(struct thread_data *, struct io_u *);
 extern void io_u_mark_depth(struct thread_data *, unsigned int);
 extern void fill_io_buffer(struct thread_data *, void *, unsigned int, unsigned int);
 extern void io_u_fill_buffer(struct thread_data *td, struct io_u *, unsigned int, unsigned int);
+extern int init_fill_state(struct thread_data *);
+extern void free_fill_state(struct thread_data *);
+extern int init_buf_pool(struct thread_data *);
+extern void free_buf_pool(struct thread_data *);
 void io_u_mark_complete(struct thread_data *, unsigned int);
 void io_u_mark_submit(struct thread_data *, unsigned int);
 int queue_full(struct thread_data *);
@@ -19,6 +19,7 @@
 
 #include "fio.h"
 #include "diskutil.h"
+#include "zbd.h"
 
 static FLIST_HEAD(engine_list);
 
@@ -202,6 +203,9 @@ void close_ioengine(struct thread_data *td)
 
 int td_io_prep(struct thread_data *td, struct io_u *io_u)
 {
+	if (io_u->flags & IO_U_F_ZONE_APPEND)
+		zbd_place_io(td, io_u);
+
 	dprint_io_u(io_u, "prep");
 	fio_ro_check(td, io_u);
 
@@ -262,10 +266,8 @@ out:
 	return r;
 }
 
-int td_io_queue(struct thread_data *td, struct io_u *io_u)
+static void td_io_queue_pre(struct thread_data *td, struct io_u *io_u)
 {
-	int ret;
-
 	dprint_io_u(io_u, "queue");
 	fio_ro_check(td, io_u);
 
@@ -296,9 +298,11 @@ int td_io_queue(struct thread_data *td, struct io_u *io_u)
 
 	if (ddir_rw(acct_ddir(io_u)))
 		td->io_issues[acct_ddir(io_u)]++;
+}
 
-	ret = td->io_ops->queue(td, io_u);
-
+static int td_io_queue_post(struct thread_data *td, struct io_u *io_u,
+			    int ret)
+{
 	unlock_file(td, io_u->file);
 
 	/*
@@ -321,23 +325,43 @@ int td_io_queue(struct thread_data *td, struct io_u *io_u)
 			 "support direct IO, or iomem_align= is bad.\n");
 	}
 
-	if (!td->io_ops->commit || ddir_trim(io_u->ddir)) {
+	/*
+	 * Async engines usually complete trims inline, account those here.
+	 * A queued trim is accounted by ->commit() like any other io_u.
+	 */
+	if (!td->io_ops->commit ||
+	    (ddir_trim(io_u->ddir) && ret == FIO_Q_COMPLETED)) {
 		io_u_mark_submit(td, 1);
+		td_reap_lock(td);
 		io_u_mark_complete(td, 1);
+		td_reap_unlock(td);
 	}
 
 	if (ret == FIO_Q_COMPLETED) {
 		if (ddir_rw(io_u->ddir)) {
-			io_u_mark_depth(td, 1);
+			/*
+			 * Without ->commit() every io_u is done on its own,
+			 * the rest of a batch is only waiting to be issued
+			 */
+			if (td->io_ops->commit)
+				io_u_mark_depth(td, 1);
+			else
+				td->ts.io_u_map[0]++;
 			td->ts.total_io_u[io_u->ddir]++;
 		}
 	} else if (ret == FIO_Q_QUEUED) {
 		int r;
 
-		if (ddir_rw(io_u->ddir)) {
-			td->io_u_queued++;
+		/*
+		 * Count queued syncs too, their completions are reaped and
+		 * taken off io_u_in_flight like everything else
+		 */
+		td->io_u_queued++;
+		if (ddir_rw(io_u->ddir))
 			td->ts.total_io_u[io_u->ddir]++;
-		}
+
+		if (td->reap)
+			reap_queued(td->reap);
 
 		if (td->io_u_queued >= td->o.iodepth_batch) {
 			r = td_io_commit(td);
@@ -361,6 +385,47 @@ int td_io_queue(struct thread_data *td, struct io_u *io_u)
 	return ret;
 }
 
+int td_io_queue(struct thread_data *td, struct io_u *io_u)
+{
+	td_io_queue_pre(td, io_u);
+	return td_io_queue_post(td, io_u, td->io_ops->queue(td, io_u));
+}
+
+/*
+ * Queue nr io_us, storing what ->queue() would have returned for each in
+ * rets. The engine's ->queue_batch() takes as many of them as it can in
+ * one go: completed if the engine has no ->commit(), queued otherwise.
+ * The rest go through ->queue() one at a time, and once one of them is
+ * busy those after it are returned busy without being tried.
+ */
+void td_io_queue_batch(struct thread_data *td, struct io_u **io_us, int *rets,
+		       unsigned int nr)
+{
+	unsigned int i, done;
+	int ret, busy = 0;
+
+	for (i = 0; i < nr; i++)
+		td_io_queue_pre(td, io_us[i]);
+
+	done = td->io_ops->queue_batch(td, io_us, nr);
+	dprint(FD_IO, "->queue_batch(%u)=%u\n", nr, done);
+	assert(done <= nr);
+
+	ret = td->io_ops->commit ? FIO_Q_QUEUED : FIO_Q_COMPLETED;
+	for (i = 0; i < done; i++)
+		rets[i] = td_io_queue_post(td, io_us[i], ret);
+
+	for (; i < nr; i++) {
+		if (busy)
+			ret = FIO_Q_BUSY;
+		else
+			ret = td->io_ops->queue(td, io_us[i]);
+
+		rets[i] = td_io_queue_post(td, io_us[i], ret);
+		busy = rets[i] == FIO_Q_BUSY;
+	}
+}
+
 int td_io_init(struct thread_data *td)
 {
 	int ret = 0;
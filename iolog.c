@@ -186,6 +186,45 @@ void prune_io_piece_log(struct thread_data *td)
 	}
 }
 
+/*
+ * Drop logged writes overlapping a range whose data is gone, like a zone
+ * that was reset. None of them may be in flight.
+ */
+void unlog_io_pieces(struct thread_data *td, struct fio_file *f,
+		     unsigned long long offset, unsigned long long len)
+{
+	struct flist_head *entry, *tmp;
+	struct io_piece *ipo;
+	struct rb_node *n, *next;
+
+	for (n = rb_first(&td->io_hist_tree); n; n = next) {
+		next = rb_next(n);
+		ipo = rb_entry(n, struct io_piece, rb_node);
+		if (ipo->file != f || ipo->offset + ipo->len <= offset ||
+		    ipo->offset >= offset + len)
+			continue;
+
+		assert(!(ipo->flags & IP_F_IN_FLIGHT));
+		rb_erase(n, &td->io_hist_tree);
+		remove_trim_entry(td, ipo);
+		td->io_hist_len--;
+		free(ipo);
+	}
+
+	flist_for_each_safe(entry, tmp, &td->io_hist_list) {
+		ipo = flist_entry(entry, struct io_piece, list);
+		if (ipo->file != f || ipo->offset + ipo->len <= offset ||
+		    ipo->offset >= offset + len)
+			continue;
+
+		assert(!(ipo->flags & IP_F_IN_FLIGHT));
+		flist_del(&ipo->list);
+		remove_trim_entry(td, ipo);
+		td->io_hist_len--;
+		free(ipo);
+	}
+}
+
 /*
  * log a successful write, so we can unwind the log for verify
  */
@@ -194,6 +233,15 @@ void log_io_piece(struct thread_data *td, struct io_u *io_u)
 	struct rb_node **p, *parent;
 	struct io_piece *ipo, *__ipo;
 
+	/*
+	 * Nothing to remember per write, the verify pass works out what
+	 * each block should hold
+	 */
+	if (td->o.verify_history != VERIFY_HIST_LOG) {
+		verify_log_write(td, io_u);
+		return;
+	}
+
 	ipo = malloc(sizeof(struct io_piece));
 	init_ipo(ipo);
 	ipo->file = io_u->file;
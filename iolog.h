@@ -180,6 +180,8 @@ extern int __must_check init_iolog(struct thread_data *td);
 extern void log_io_piece(struct thread_data *, struct io_u *);
 extern void unlog_io_piece(struct thread_data *, struct io_u *);
 extern void trim_io_piece(struct thread_data *, struct io_u *);
+extern void unlog_io_pieces(struct thread_data *, struct fio_file *,
+			    unsigned long long, unsigned long long);
 extern void queue_io_piece(struct thread_data *, struct io_piece *);
 extern void prune_io_piece_log(struct thread_data *);
 extern void write_iolog_close(struct thread_data *);
@@ -208,6 +210,15 @@ extern void add_clat_sample(struct thread_data *, enum fio_ddir, unsigned long,
 				unsigned int, uint64_t);
 extern void add_slat_sample(struct thread_data *, enum fio_ddir, unsigned long,
 				unsigned int, uint64_t);
+extern void add_io_op_clat_sample(struct thread_data *, unsigned int,
+				unsigned long);
+extern void add_ftl_gc_sample(struct thread_data *, unsigned long);
+extern void add_zone_reset_sample(struct thread_data *, unsigned long);
+extern void add_zone_append_sample(struct thread_data *, unsigned long,
+				   unsigned long);
+extern void add_verify_wait_sample(struct io_stat *, unsigned long);
+extern void add_verify_async_stats(struct thread_data *, uint64_t, uint64_t,
+				   struct io_stat *);
 extern void add_bw_sample(struct thread_data *, enum fio_ddir, unsigned int,
 				struct timeval *);
 extern void add_iops_sample(struct thread_data *, enum fio_ddir, unsigned int,
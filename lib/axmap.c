@@ -225,18 +225,23 @@ static int axmap_set_fn(struct axmap_level *al, unsigned long offset,
 	mask = bit_masks[nr_bits] << bit;
 
 	/*
-	 * Mask off any potential overlap, only sets contig regions
+	 * Mask off any potential overlap, only sets contig regions. Stop at
+	 * the first busy bit, setting the free ones past it would mark
+	 * blocks the caller doesn't get to use.
 	 */
 	overlap = al->map[offset] & mask;
-	if (overlap == mask)
+	if (overlap == mask) {
+done:
+		if (!al->level)
+			data->set_bits = 0;
 		return 1;
+	}
 
-	while (overlap) {
-		unsigned long clear_mask = ~(1UL << ffz(~overlap));
-
-		mask &= clear_mask;
-		overlap &= clear_mask;
-		nr_bits--;
+	if (overlap) {
+		nr_bits = ffz(~overlap) - bit;
+		if (!nr_bits)
+			goto done;
+		mask = bit_masks[nr_bits] << bit;
 	}
 
 	assert(mask);
@@ -34,8 +34,18 @@
 */
 
 #include <string.h>
+#include <inttypes.h>
 #include "rand.h"
 #include "../hash.h"
+#include "../minmax.h"
+#include "../arch/arch.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(CONFIG_X86_AVX2) || defined(CONFIG_X86_AVX512)
+#include <immintrin.h>
+#endif
 
 static inline int __seed(unsigned int x, unsigned int m)
 {
@@ -66,15 +76,238 @@ void init_rand_seed(struct frand_state *state, unsigned int seed)
 	__init_rand(state, seed);
 }
 
+/*
+ * Buffers are filled from FILL_LANES independent xorshift64 generators,
+ * 64-bit word i of a buffer comes from lane i % FILL_LANES. The lanes
+ * don't depend on each other, so a fill is a handful of shifts and xors
+ * per vector store instead of a serial chain per word. Every version
+ * below writes exactly the same data for a given seed, what the CPU
+ * supports only changes how fast it is written.
+ */
+#define FILL_LANES	8
+#define FILL_BLOCK	(FILL_LANES * sizeof(uint64_t))
+
+static inline uint64_t xorshift64(uint64_t x)
+{
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return x;
+}
+
+static void fill_seed_lanes(uint64_t *s, unsigned long seed)
+{
+	uint64_t x = seed;
+	int i;
+
+	/*
+	 * splitmix64, so close seeds still give unrelated lanes. xorshift
+	 * must never start from 0.
+	 */
+	for (i = 0; i < FILL_LANES; i++) {
+		uint64_t z;
+
+		x += 0x9e3779b97f4a7c15ULL;
+		z = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		z ^= z >> 31;
+		s[i] = z ? z : GOLDEN_RATIO_PRIME;
+	}
+}
+
+static void fill_lanes_generic(uint64_t *s, void *buf, unsigned int blocks)
+{
+	uint64_t *ptr = buf;
+	int i;
+
+	while (blocks--) {
+		for (i = 0; i < FILL_LANES; i++) {
+			s[i] = xorshift64(s[i]);
+			ptr[i] = s[i];
+		}
+		ptr += FILL_LANES;
+	}
+}
+
+#if defined(__SSE2__)
+#define XORSHIFT_VEC(x, sll, srl, xor)				\
+	do {							\
+		x = xor(x, sll(x, 13));				\
+		x = xor(x, srl(x, 7));				\
+		x = xor(x, sll(x, 17));				\
+	} while (0)
+
+#define XORSHIFT_128(x)	\
+	XORSHIFT_VEC(x, _mm_slli_epi64, _mm_srli_epi64, _mm_xor_si128)
+
+static void fill_lanes_sse2(uint64_t *s, void *buf, unsigned int blocks)
+{
+	__m128i *ptr = buf;
+	__m128i s0 = _mm_loadu_si128((__m128i *) &s[0]);
+	__m128i s1 = _mm_loadu_si128((__m128i *) &s[2]);
+	__m128i s2 = _mm_loadu_si128((__m128i *) &s[4]);
+	__m128i s3 = _mm_loadu_si128((__m128i *) &s[6]);
+
+	while (blocks--) {
+		XORSHIFT_128(s0);
+		XORSHIFT_128(s1);
+		XORSHIFT_128(s2);
+		XORSHIFT_128(s3);
+		_mm_storeu_si128(ptr++, s0);
+		_mm_storeu_si128(ptr++, s1);
+		_mm_storeu_si128(ptr++, s2);
+		_mm_storeu_si128(ptr++, s3);
+	}
+
+	_mm_storeu_si128((__m128i *) &s[0], s0);
+	_mm_storeu_si128((__m128i *) &s[2], s1);
+	_mm_storeu_si128((__m128i *) &s[4], s2);
+	_mm_storeu_si128((__m128i *) &s[6], s3);
+}
+
+static int fill_have_sse2(void)
+{
+	return 1;
+}
+#endif
+
+#ifdef CONFIG_X86_AVX2
+#define XORSHIFT_256(x)	\
+	XORSHIFT_VEC(x, _mm256_slli_epi64, _mm256_srli_epi64, _mm256_xor_si256)
+
+__attribute__((target("avx2")))
+static void fill_lanes_avx2(uint64_t *s, void *buf, unsigned int blocks)
+{
+	__m256i *ptr = buf;
+	__m256i s0 = _mm256_loadu_si256((__m256i *) &s[0]);
+	__m256i s1 = _mm256_loadu_si256((__m256i *) &s[4]);
+
+	while (blocks--) {
+		XORSHIFT_256(s0);
+		XORSHIFT_256(s1);
+		_mm256_storeu_si256(ptr++, s0);
+		_mm256_storeu_si256(ptr++, s1);
+	}
+
+	_mm256_storeu_si256((__m256i *) &s[0], s0);
+	_mm256_storeu_si256((__m256i *) &s[4], s1);
+}
+#endif
+
+#ifdef CONFIG_X86_AVX512
+#define XORSHIFT_512(x)	\
+	XORSHIFT_VEC(x, _mm512_slli_epi64, _mm512_srli_epi64, _mm512_xor_si512)
+
+__attribute__((target("avx512f")))
+static void fill_lanes_avx512(uint64_t *s, void *buf, unsigned int blocks)
+{
+	__m512i *ptr = buf;
+	__m512i s0 = _mm512_loadu_si512(s);
+
+	while (blocks--) {
+		XORSHIFT_512(s0);
+		_mm512_storeu_si512(ptr++, s0);
+	}
+
+	_mm512_storeu_si512(s, s0);
+}
+#endif
+
+static int fill_have_generic(void)
+{
+	return 1;
+}
+
+struct fill_impl {
+	const char *name;
+	void (*fn)(uint64_t *, void *, unsigned int);
+	int (*available)(void);
+};
+
+/*
+ * Best first
+ */
+static struct fill_impl fill_impls[] = {
+#ifdef CONFIG_X86_AVX512
+	{ "avx512", fill_lanes_avx512, arch_x86_have_avx512f },
+#endif
+#ifdef CONFIG_X86_AVX2
+	{ "avx2", fill_lanes_avx2, arch_x86_have_avx2 },
+#endif
+#if defined(__SSE2__)
+	{ "sse2", fill_lanes_sse2, fill_have_sse2 },
+#endif
+	{ "generic", fill_lanes_generic, fill_have_generic },
+	{ NULL, },
+};
+
+static struct fill_impl *fill_impl;
+
+static struct fill_impl *fill_probe(void)
+{
+	struct fill_impl *impl;
+
+	/*
+	 * Racing threads all end up picking the same one
+	 */
+	if (!fill_impl) {
+		for (impl = fill_impls; impl->name; impl++) {
+			if (impl->available()) {
+				fill_impl = impl;
+				break;
+			}
+		}
+	}
+
+	return fill_impl;
+}
+
+/*
+ * Name of the fill version in use, mostly for t/randfill
+ */
+const char *fill_random_impl(void)
+{
+	return fill_probe()->name;
+}
+
+/*
+ * Use a given fill version instead of the best one the CPU supports.
+ * Returns 1 if it isn't built in or the CPU lacks it.
+ */
+int fill_random_set_impl(const char *name)
+{
+	struct fill_impl *impl;
+
+	for (impl = fill_impls; impl->name; impl++) {
+		if (strcmp(impl->name, name))
+			continue;
+		if (!impl->available())
+			return 1;
+		fill_impl = impl;
+		return 0;
+	}
+
+	return 1;
+}
+
 void __fill_random_buf(void *buf, unsigned int len, unsigned long seed)
 {
-	long *ptr = buf;
+	unsigned int blocks = len / FILL_BLOCK;
+	uint64_t s[FILL_LANES];
 
-	while ((void *) ptr - buf < len) {
-		*ptr = seed;
-		ptr++;
-		seed *= GOLDEN_RATIO_PRIME;
-		seed >>= 3;
+	fill_seed_lanes(s, seed);
+
+	if (blocks) {
+		fill_probe()->fn(s, buf, blocks);
+		buf += blocks * FILL_BLOCK;
+		len -= blocks * FILL_BLOCK;
+	}
+
+	if (len) {
+		uint64_t tail[FILL_LANES];
+
+		fill_lanes_generic(s, tail, 1);
+		memcpy(buf, tail, len);
 	}
 }
 
@@ -90,12 +323,40 @@ unsigned long fill_random_buf(struct frand_state *fs, void *buf,
 	return r;
 }
 
+/*
+ * Fill len bytes with segments of rand_len random bytes followed by
+ * zeroes. Each segment gets data of its own, a compressor looking back
+ * across segments must not find the previous one repeated.
+ */
+void __fill_random_buf_segments(void *buf, unsigned int len,
+				unsigned long seed, unsigned int rand_len,
+				unsigned int segment)
+{
+	unsigned int this_len;
+
+	if (!segment || segment > len)
+		segment = len;
+	if (rand_len > segment)
+		rand_len = segment;
+
+	while (len) {
+		this_len = min(rand_len, len);
+		__fill_random_buf(buf, this_len, seed++);
+		len -= this_len;
+		buf += this_len;
+
+		this_len = min(segment - rand_len, len);
+		memset(buf, 0, this_len);
+		len -= this_len;
+		buf += this_len;
+	}
+}
+
 unsigned long fill_random_buf_percentage(struct frand_state *fs, void *buf,
 					 unsigned int percentage,
 					 unsigned int segment, unsigned int len)
 {
 	unsigned long r = __rand(fs);
-	unsigned int this_len;
 
 	if (percentage == 100) {
 		memset(buf, 0, len);
@@ -108,26 +369,7 @@ unsigned long fill_random_buf_percentage(struct frand_state *fs, void *buf,
 	if (sizeof(int) != sizeof(long *))
 		r *= (unsigned long) __rand(fs);
 
-	while (len) {
-		/*
-		 * Fill random chunk
-		 */
-		this_len = (segment * (100 - percentage)) / 100;
-		if (this_len > len)
-			this_len = len;
-
-		__fill_random_buf(buf, this_len, r);
-
-		len -= this_len;
-		buf += this_len;
-
-		if (this_len > len)
-			this_len = len;
-
-		memset(buf, 0, this_len);
-		len -= this_len;
-		buf += this_len;
-	}
-
+	__fill_random_buf_segments(buf, len, r,
+			(segment * (100 - percentage)) / 100, segment);
 	return r;
 }
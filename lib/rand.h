@@ -21,6 +21,9 @@ static inline unsigned int __rand(struct frand_state *state)
 extern void init_rand(struct frand_state *);
 extern void init_rand_seed(struct frand_state *, unsigned int seed);
 extern void __fill_random_buf(void *buf, unsigned int len, unsigned long seed);
+extern void __fill_random_buf_segments(void *buf, unsigned int len, unsigned long seed, unsigned int rand_len, unsigned int segment);
+extern const char *fill_random_impl(void);
+extern int fill_random_set_impl(const char *);
 extern unsigned long fill_random_buf(struct frand_state *, void *buf, unsigned int len);
 extern unsigned long fill_random_buf_percentage(struct frand_state *, void *buf, unsigned int percentage, unsigned int segment, unsigned int len);
 
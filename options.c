@@ -61,15 +61,22 @@ static int bs_cmp(const void *p1, const void *p2)
 	return bsp1->perc < bsp2->perc;
 }
 
-static int bssplit_ddir(struct thread_options *o, int ddir, char *str)
+/*
+ * Parse a "size/perc:size/perc:..." split into an array sorted by
+ * percentage. Entries without a percentage share whatever is left
+ * over. Also used by engines that need a size distribution of their own.
+ */
+int parse_size_split(struct thread_options *o, char *str,
+		     struct bssplit **split, unsigned int *nr,
+		     unsigned int *min, unsigned int *max)
 {
 	struct bssplit *bssplit;
-	unsigned int i, perc, perc_missing;
+	unsigned int i, perc, perc_missing, bssplit_nr;
 	unsigned int max_bs, min_bs;
 	long long val;
 	char *fname;
 
-	o->bssplit_nr[ddir] = 4;
+	bssplit_nr = 4;
 	bssplit = malloc(4 * sizeof(struct bssplit));
 
 	i = 0;
@@ -84,9 +91,9 @@ static int bssplit_ddir(struct thread_options *o, int ddir, char *str)
 		/*
 		 * grow struct buffer, if needed
 		 */
-		if (i == o->bssplit_nr[ddir]) {
-			o->bssplit_nr[ddir] <<= 1;
-			bssplit = realloc(bssplit, o->bssplit_nr[ddir]
+		if (i == bssplit_nr) {
+			bssplit_nr <<= 1;
+			bssplit = realloc(bssplit, bssplit_nr
 						  * sizeof(struct bssplit));
 		}
 
@@ -118,16 +125,16 @@ static int bssplit_ddir(struct thread_options *o, int ddir, char *str)
 		i++;
 	}
 
-	o->bssplit_nr[ddir] = i;
+	bssplit_nr = i;
 
 	/*
 	 * Now check if the percentages add up, and how much is missing
 	 */
 	perc = perc_missing = 0;
-	for (i = 0; i < o->bssplit_nr[ddir]; i++) {
+	for (i = 0; i < bssplit_nr; i++) {
 		struct bssplit *bsp = &bssplit[i];
 
-		if (bsp->perc == (unsigned char) -1)
+		if (bsp->perc == (unsigned int) -1)
 			perc_missing++;
 		else
 			perc += bsp->perc;
@@ -143,25 +150,32 @@ static int bssplit_ddir(struct thread_options *o, int ddir, char *str)
 	 * them.
 	 */
 	if (perc_missing) {
-		for (i = 0; i < o->bssplit_nr[ddir]; i++) {
+		for (i = 0; i < bssplit_nr; i++) {
 			struct bssplit *bsp = &bssplit[i];
 
-			if (bsp->perc == (unsigned char) -1)
+			if (bsp->perc == (unsigned int) -1)
 				bsp->perc = (100 - perc) / perc_missing;
 		}
 	}
 
-	o->min_bs[ddir] = min_bs;
-	o->max_bs[ddir] = max_bs;
-
 	/*
 	 * now sort based on percentages, for ease of lookup
 	 */
-	qsort(bssplit, o->bssplit_nr[ddir], sizeof(struct bssplit), bs_cmp);
-	o->bssplit[ddir] = bssplit;
+	qsort(bssplit, bssplit_nr, sizeof(struct bssplit), bs_cmp);
+
+	*split = bssplit;
+	*nr = bssplit_nr;
+	*min = min_bs;
+	*max = max_bs;
 	return 0;
 }
 
+static int bssplit_ddir(struct thread_options *o, int ddir, char *str)
+{
+	return parse_size_split(o, str, &o->bssplit[ddir], &o->bssplit_nr[ddir],
+				&o->min_bs[ddir], &o->max_bs[ddir]);
+}
+
 static int str_bssplit_cb(void *data, const char *input)
 {
 	struct thread_data *td = data;
@@ -1205,6 +1219,10 @@ static struct opt_group fio_opt_cat_groups[] = {
 		.name	= "Zone",
 		.mask	= FIO_OPT_G_ZONE,
 	},
+	{
+		.name	= "Open-channel geometry",
+		.mask	= FIO_OPT_G_NVM,
+	},
 	{
 		.name	= "Read/write mix",
 		.mask	= FIO_OPT_G_RWMIX,
@@ -1636,6 +1654,18 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_IO_BASIC,
 	},
+	{
+		.name	= "reap_thread",
+		.lname	= "Reap thread",
+		.type	= FIO_OPT_BOOL,
+		.off1	= td_var_offset(reap_thread),
+		.help	= "Reap completions on a separate thread",
+		.def	= "0",
+		.parent	= "iodepth",
+		.hide	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BASIC,
+	},
 	{
 		.name	= "size",
 		.lname	= "Size",
@@ -1932,6 +1962,18 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_RANDOM,
 	},
+	{
+		.name	= "offset_prefetch",
+		.lname	= "Offset prefetch",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(offset_prefetch),
+		.help	= "Generate this many random offsets and sizes at a time",
+		.def	= "0",
+		.maxval	= 65536,
+		.interval = 16,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_RANDOM,
+	},
 	{
 		.name	= "allrandrepeat",
 		.type	= FIO_OPT_BOOL,
@@ -2358,6 +2400,14 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 			    .oval = VERIFY_XXHASH,
 			    .help = "Use xxhash checksums for verification",
 			  },
+			  { .ival = "xxh3",
+			    .oval = VERIFY_XXH3,
+			    .help = "Use 64-bit xxh3 checksums for verification",
+			  },
+			  { .ival = "xxh128",
+			    .oval = VERIFY_XXH128,
+			    .help = "Use 128-bit xxh3 checksums for verification",
+			  },
 			  { .ival = "meta",
 			    .oval = VERIFY_META,
 			    .help = "Use io information",
@@ -2499,6 +2549,32 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_VERIFY,
 	},
+	{
+		.name	= "verify_history",
+		.lname	= "Verify history",
+		.type	= FIO_OPT_STR,
+		.off1	= td_var_offset(verify_history),
+		.help	= "What to remember about writes for the verify pass",
+		.def	= "log",
+		.parent	= "verify",
+		.hide	= 1,
+		.posval = {
+			  { .ival = "log",
+			    .oval = VERIFY_HIST_LOG,
+			    .help = "Log every write",
+			  },
+			  { .ival = "loop",
+			    .oval = VERIFY_HIST_LOOP,
+			    .help = "Nothing, every block is written each loop",
+			  },
+			  { .ival = "map",
+			    .oval = VERIFY_HIST_MAP,
+			    .help = "A generation byte per block",
+			  },
+		},
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_VERIFY,
+	},
 #ifdef FIO_HAVE_CPU_AFFINITY
 	{
 		.name	= "verify_async_cpus",
@@ -2676,6 +2752,121 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_ZONE,
 	},
+	{
+		.name	= "zonemode",
+		.lname	= "Zone mode",
+		.type	= FIO_OPT_STR,
+		.off1	= td_var_offset(zone_mode),
+		.help	= "How zones are handled",
+		.def	= "none",
+		.posval = {
+			  { .ival = "none",
+			    .oval = ZONE_MODE_NONE,
+			    .help = "zonesize/zonerange/zoneskip strided IO",
+			  },
+			  { .ival = "zbd",
+			    .oval = ZONE_MODE_ZBD,
+			    .help = "Zoned block device, writes follow zone write pointers",
+			  },
+		},
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
+	{
+		.name	= "max_open_zones",
+		.lname	= "Maximum open zones",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(max_open_zones),
+		.help	= "Limit on the number of zones written at a time (zonemode=zbd)",
+		.def	= "0",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
+	{
+		.name	= "zone_append",
+		.lname	= "Zone append",
+		.type	= FIO_OPT_BOOL,
+		.off1	= td_var_offset(zone_append),
+		.help	= "Zone writes are placed at the write pointer as they are issued (zonemode=zbd)",
+		.def	= "0",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_ZONE,
+	},
+	{
+		.name	= "nvm_channels",
+		.lname	= "Open-channel channels",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_channels),
+		.help	= "Number of channels, enables geometry striping",
+		.def	= "0",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "nvm_luns",
+		.lname	= "Open-channel LUNs",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_luns),
+		.help	= "Number of LUNs per channel",
+		.def	= "1",
+		.minval	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "nvm_planes",
+		.lname	= "Open-channel planes",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_planes),
+		.help	= "Number of planes per LUN",
+		.def	= "1",
+		.minval	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "nvm_pages_per_block",
+		.lname	= "Open-channel pages per block",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_pages_per_block),
+		.help	= "Number of pages in an erase block",
+		.def	= "256",
+		.minval	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "nvm_sectors_per_page",
+		.lname	= "Open-channel sectors per page",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_sectors_per_page),
+		.help	= "Number of sectors in a flash page",
+		.def	= "1",
+		.minval	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "nvm_sector_size",
+		.lname	= "Open-channel sector size",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_sector_size),
+		.help	= "Sector size in bytes",
+		.def	= "4096",
+		.minval	= 512,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
+	{
+		.name	= "nvm_stripe_units",
+		.lname	= "Open-channel stripe units",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(nvm_stripe_units),
+		.help	= "Parallel units to stripe across at a time (0 = all)",
+		.def	= "0",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_NVM,
+	},
 	{
 		.name	= "lockmem",
 		.lname	= "Lock memory",
@@ -3259,6 +3450,53 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_IO_BUF,
 	},
+	{
+		.name	= "buffer_compress_calibrate",
+		.lname	= "Buffer compression calibration",
+		.type	= FIO_OPT_STR,
+		.off1	= td_var_offset(compress_calibrate),
+		.parent	= "buffer_compress_percentage",
+		.hide	= 1,
+		.help	= "Compressor to hit buffer_compress_percentage for",
+		.def	= "none",
+		.posval = {
+			  { .ival = "none",
+			    .oval = FIO_COMPRESS_CAL_NONE,
+			    .help = "Split segments by the percentage as given",
+			  },
+#ifdef CONFIG_ZLIB
+			  { .ival = "zlib",
+			    .oval = FIO_COMPRESS_CAL_ZLIB,
+			    .help = "Measure with zlib (deflate) at init",
+			  },
+#endif
+		},
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
+	{
+		.name	= "dedupe_percentage",
+		.lname	= "Dedupe percentage",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(dedupe_percentage),
+		.maxval	= 100,
+		.minval	= 0,
+		.help	= "Percentage of buffers that repeat an earlier one",
+		.interval = 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
+	{
+		.name	= "buffer_pool",
+		.lname	= "Buffer pool size",
+		.type	= FIO_OPT_INT,
+		.off1	= td_var_offset(buffer_pool),
+		.help	= "Pre-generate this much write data for refill_buffers",
+		.def	= "0",
+		.interval = 1024 * 1024,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
 	{
 		.name	= "clat_percentiles",
 		.lname	= "Completion latency percentiles",
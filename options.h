@@ -99,6 +99,8 @@ enum opt_category_group {
 	__FIO_OPT_G_LATPROF,
         __FIO_OPT_G_RBD,
         __FIO_OPT_G_GFAPI,
+	__FIO_OPT_G_KV,
+	__FIO_OPT_G_NVM,
 	__FIO_OPT_G_NR,
 
 	FIO_OPT_G_RATE		= (1U << __FIO_OPT_G_RATE),
@@ -130,6 +132,8 @@ enum opt_category_group {
 	FIO_OPT_G_LATPROF	= (1U << __FIO_OPT_G_LATPROF),
 	FIO_OPT_G_RBD		= (1U << __FIO_OPT_G_RBD),
 	FIO_OPT_G_GFAPI		= (1U << __FIO_OPT_G_GFAPI),
+	FIO_OPT_G_KV		= (1U << __FIO_OPT_G_KV),
+	FIO_OPT_G_NVM		= (1U << __FIO_OPT_G_NVM),
 	FIO_OPT_G_INVALID	= (1U << __FIO_OPT_G_NR),
 };
 
@@ -138,4 +142,9 @@ extern struct opt_group *opt_group_cat_from_mask(unsigned int *mask);
 extern struct fio_option *fio_option_find(const char *name);
 extern unsigned int fio_get_kb_base(void *);
 
+struct thread_options;
+struct bssplit;
+extern int parse_size_split(struct thread_options *, char *, struct bssplit **,
+			    unsigned int *, unsigned int *, unsigned int *);
+
 #endif
@@ -0,0 +1,248 @@
+/*
+ * Companion reaper thread for reap_thread=1
+ *
+ * The job thread only generates and queues io_us. The reaper waits for
+ * their completions and does the accounting and verification that
+ * io_u_queued_complete() would do. Completed io_us are handed back to the
+ * job thread through a single producer/single consumer ring, so the
+ * freelist, files and verify history stay private to the job thread.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "fio.h"
+#include "lib/getrusage.h"
+
+void reap_wake(struct reap_data *rd)
+{
+	pthread_mutex_lock(&rd->lock);
+	pthread_cond_signal(&rd->reap_cond);
+	pthread_mutex_unlock(&rd->lock);
+}
+
+/*
+ * Wait until something is queued. Returns how many io_us are in flight,
+ * or 0 when we should exit.
+ */
+static unsigned int reap_wait_queued(struct reap_data *rd)
+{
+	unsigned int in_flight;
+
+	pthread_mutex_lock(&rd->lock);
+
+	/*
+	 * Pairs with reap_queued(), either we see the new submission or
+	 * the job thread sees us idle and wakes us up
+	 */
+	rd->reaper_idle = 1;
+	__sync_synchronize();
+
+	while (!rd->exit && rd->submitted == rd->reaped)
+		pthread_cond_wait(&rd->reap_cond, &rd->lock);
+
+	rd->reaper_idle = 0;
+	in_flight = rd->exit ? 0 : rd->submitted - rd->reaped;
+	pthread_mutex_unlock(&rd->lock);
+
+	return in_flight;
+}
+
+static void *reap_thread_main(void *data)
+{
+	struct reap_data *rd = data;
+	struct thread_data *td = rd->td;
+	struct timespec ts = { .tv_sec = 0, .tv_nsec = 0, };
+	struct rusage ru_start, ru_end;
+	unsigned int in_flight;
+
+	fio_getrusage(&ru_start);
+
+	while ((in_flight = reap_wait_queued(rd)) != 0) {
+		unsigned int min_evts, max_evts;
+		int ret;
+
+		/*
+		 * Things queued but not committed yet are counted too, the
+		 * job thread commits before it waits on us
+		 */
+		max_evts = min(in_flight, td->o.iodepth);
+		min_evts = min(td->o.iodepth_batch_complete, max_evts);
+
+		ret = td->io_ops->getevents(td, min_evts, max_evts,
+						min_evts ? NULL : &ts);
+		if (!ret)
+			continue;
+
+		pthread_mutex_lock(&rd->lock);
+		if (ret < 0) {
+			td_verror(td, -ret, "td_io_getevents");
+			rd->error = 1;
+		} else {
+			if (io_u_reap_events(td, ret, &rd->done, rd->bytes_done))
+				rd->error = 1;
+			rd->reaped += ret;
+		}
+		if (rd->submitter_waiting)
+			pthread_cond_signal(&rd->submit_cond);
+		pthread_mutex_unlock(&rd->lock);
+
+		if (rd->error)
+			break;
+	}
+
+	fio_getrusage(&ru_end);
+	rd->usr_time = mtime_since(&ru_start.ru_utime, &ru_end.ru_utime);
+	rd->sys_time = mtime_since(&ru_start.ru_stime, &ru_end.ru_stime);
+	rd->ctx = ru_end.ru_nvcsw + ru_end.ru_nivcsw -
+			(ru_start.ru_nvcsw + ru_start.ru_nivcsw);
+	return NULL;
+}
+
+/*
+ * Put the io_us the reaper is done with. Errored writes still have their
+ * piece of the verify history in flight, the reaper left it for us.
+ */
+static void reap_put_done(struct thread_data *td, struct reap_data *rd)
+{
+	struct io_u *io_u;
+
+	while ((io_u = io_u_spsc_pop(&rd->done)) != NULL) {
+		if (io_u->ipo && (io_u->ipo->flags & IP_F_IN_FLIGHT))
+			unlog_io_piece(td, io_u);
+		put_io_u(td, io_u);
+	}
+}
+
+/*
+ * Take what the reaper completed since last time. Must be called with
+ * rd->lock held, or once the reaper is gone.
+ */
+static void reap_collect(struct thread_data *td, struct reap_data *rd,
+			 uint64_t *bytes)
+{
+	int ddir;
+
+	td->io_u_in_flight -= rd->reaped - rd->seen;
+	rd->seen = rd->reaped;
+
+	for (ddir = DDIR_READ; ddir < DDIR_RWDIR_CNT; ddir++) {
+		if (bytes)
+			bytes[ddir] += rd->bytes_done[ddir] - rd->bytes_seen[ddir];
+		rd->bytes_seen[ddir] = rd->bytes_done[ddir];
+	}
+}
+
+/*
+ * The reap_thread version of io_u_queued_complete(). Wait for the reaper
+ * to complete at least min_evts io_us, or everything that is in flight.
+ */
+int reap_complete(struct thread_data *td, int min_evts, uint64_t *bytes)
+{
+	struct reap_data *rd = td->reap;
+	unsigned int want;
+	int error;
+
+	/*
+	 * Unlike td_io_getevents(), go through td_io_commit() so what we
+	 * commit is added to io_u_in_flight before the reaper takes it off
+	 */
+	if (min_evts > 0) {
+		int ret = td_io_commit(td);
+
+		if (ret < 0)
+			return ret;
+	}
+
+	pthread_mutex_lock(&rd->lock);
+
+	want = rd->seen + min_evts;
+	while ((int) (want - rd->reaped) > 0 &&
+	       rd->reaped != rd->submitted && !rd->error) {
+		rd->submitter_waiting = 1;
+		pthread_cond_wait(&rd->submit_cond, &rd->lock);
+	}
+	rd->submitter_waiting = 0;
+
+	reap_collect(td, rd, bytes);
+	error = rd->error;
+	pthread_mutex_unlock(&rd->lock);
+
+	reap_put_done(td, rd);
+	return error ? -1 : 0;
+}
+
+int reap_init(struct thread_data *td)
+{
+	struct reap_data *rd;
+	int ret;
+
+	rd = malloc(sizeof(*rd));
+	memset(rd, 0, sizeof(*rd));
+	rd->td = td;
+
+	if (io_u_spsc_init(&rd->done, td->o.iodepth)) {
+		log_err("fio: failed allocating reap ring\n");
+		free(rd);
+		return 1;
+	}
+
+	pthread_mutex_init(&rd->lock, NULL);
+	pthread_cond_init(&rd->reap_cond, NULL);
+	pthread_cond_init(&rd->submit_cond, NULL);
+
+	ret = pthread_create(&rd->thread, NULL, reap_thread_main, rd);
+	if (ret) {
+		log_err("fio: reap thread creation failed: %s\n",
+				strerror(ret));
+		io_u_spsc_exit(&rd->done);
+		free(rd);
+		return 1;
+	}
+
+	td->reap = rd;
+	return 0;
+}
+
+/*
+ * Stop the reaper. What is still in flight when it is gone is completed
+ * by the job thread as usual.
+ */
+void reap_exit(struct thread_data *td, uint64_t *bytes)
+{
+	struct reap_data *rd = td->reap;
+	struct thread_stat *ts = &td->ts;
+	int fio_unused ret;
+
+	if (!rd)
+		return;
+
+	/*
+	 * The reaper may be waiting on io_us that were never committed
+	 */
+	ret = td_io_commit(td);
+
+	pthread_mutex_lock(&rd->lock);
+	rd->exit = 1;
+	pthread_cond_signal(&rd->reap_cond);
+	pthread_mutex_unlock(&rd->lock);
+
+	pthread_join(rd->thread, NULL);
+	td->reap = NULL;
+
+	reap_collect(td, rd, bytes);
+	reap_put_done(td, rd);
+
+	ts->usr_time += rd->usr_time;
+	ts->sys_time += rd->sys_time;
+	ts->ctx += rd->ctx;
+	ts->reap_usr_time += rd->usr_time;
+	ts->reap_sys_time += rd->sys_time;
+	ts->reap_ctx += rd->ctx;
+
+	pthread_cond_destroy(&rd->submit_cond);
+	pthread_cond_destroy(&rd->reap_cond);
+	pthread_mutex_destroy(&rd->lock);
+	io_u_spsc_exit(&rd->done);
+	free(rd);
+}
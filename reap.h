@@ -0,0 +1,70 @@
+#ifndef FIO_REAP_H
+#define FIO_REAP_H
+
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "io_ddir.h"
+#include "io_u_queue.h"
+
+struct thread_data;
+
+/*
+ * State shared between a job thread and its companion reaper thread,
+ * see reap.c. The job thread only writes submitted, the reaper only
+ * writes the completed io_us and their accounting.
+ */
+struct reap_data {
+	struct thread_data *td;
+	pthread_t thread;
+
+	/*
+	 * Serializes completion accounting with inline completions on the
+	 * job thread, and protects the wakeups below
+	 */
+	pthread_mutex_t lock;
+	pthread_cond_t reap_cond;
+	pthread_cond_t submit_cond;
+
+	/*
+	 * Completed io_us on their way back to the job thread
+	 */
+	struct io_u_spsc done;
+
+	volatile unsigned int submitted;
+	unsigned int reaped;
+	unsigned int seen;
+
+	volatile int reaper_idle;
+	int submitter_waiting;
+	int exit;
+	int error;
+
+	uint64_t bytes_done[DDIR_RWDIR_CNT];
+	uint64_t bytes_seen[DDIR_RWDIR_CNT];
+
+	/*
+	 * CPU used by the reaper, in msec
+	 */
+	uint64_t usr_time;
+	uint64_t sys_time;
+	uint64_t ctx;
+};
+
+extern int reap_init(struct thread_data *);
+extern void reap_exit(struct thread_data *, uint64_t *);
+extern int reap_complete(struct thread_data *, int, uint64_t *);
+extern void reap_wake(struct reap_data *);
+
+/*
+ * An io_u was queued with the engine, let the reaper know it has
+ * something to wait for
+ */
+static inline void reap_queued(struct reap_data *rd)
+{
+	__sync_fetch_and_add(&rd->submitted, 1);
+	if (rd->reaper_idle)
+		reap_wake(rd);
+}
+
+#endif
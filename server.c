@@ -1061,6 +1061,41 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	p.ts.latency_window	= cpu_to_le64(ts->latency_window);
 	p.ts.latency_percentile.u.i = __cpu_to_le64(fio_double_to_uint64(ts->latency_percentile.u.f));
 
+	p.ts.nr_io_ops		= cpu_to_le32(ts->nr_io_ops);
+	for (i = 0; i < FIO_IO_OP_NR; i++) {
+		strncpy(p.ts.io_op_name[i], ts->io_op_name[i],
+				FIO_IO_OP_NAME_SIZE - 1);
+		convert_io_stat(&p.ts.io_op_clat_stat[i], &ts->io_op_clat_stat[i]);
+		for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+			p.ts.io_op_plat[i][j] = cpu_to_le32(ts->io_op_plat[i][j]);
+	}
+
+	p.ts.ftl_host_writes	= cpu_to_le64(ts->ftl_host_writes);
+	p.ts.ftl_gc_writes	= cpu_to_le64(ts->ftl_gc_writes);
+	p.ts.ftl_erases		= cpu_to_le64(ts->ftl_erases);
+	p.ts.ftl_map_bytes	= cpu_to_le64(ts->ftl_map_bytes);
+	p.ts.ftl_page_size	= cpu_to_le32(ts->ftl_page_size);
+	convert_io_stat(&p.ts.ftl_gc_stat, &ts->ftl_gc_stat);
+	for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+		p.ts.ftl_gc_plat[j] = cpu_to_le32(ts->ftl_gc_plat[j]);
+
+	convert_io_stat(&p.ts.zone_reset_stat, &ts->zone_reset_stat);
+	p.ts.zone_appends	= cpu_to_le64(ts->zone_appends);
+	convert_io_stat(&p.ts.zone_append_bw_stat, &ts->zone_append_bw_stat);
+
+	p.ts.poll_spin_reaps	= cpu_to_le64(ts->poll_spin_reaps);
+	p.ts.poll_sleeps	= cpu_to_le64(ts->poll_sleeps);
+	p.ts.poll_spin_usec	= cpu_to_le64(ts->poll_spin_usec);
+	p.ts.poll_sleep_usec	= cpu_to_le64(ts->poll_sleep_usec);
+
+	p.ts.reap_usr_time	= cpu_to_le64(ts->reap_usr_time);
+	p.ts.reap_sys_time	= cpu_to_le64(ts->reap_sys_time);
+	p.ts.reap_ctx		= cpu_to_le64(ts->reap_ctx);
+
+	p.ts.verify_async_bytes	= cpu_to_le64(ts->verify_async_bytes);
+	p.ts.verify_async_usec	= cpu_to_le64(ts->verify_async_usec);
+	convert_io_stat(&p.ts.verify_async_wait_stat, &ts->verify_async_wait_stat);
+
 	convert_gs(&p.rs, rs);
 
 	fio_net_send_cmd(server_fd, FIO_NET_CMD_TS, &p, sizeof(p), NULL, NULL);
@@ -181,8 +181,9 @@ unsigned int calc_clat_percentiles(unsigned int *io_u_plat, unsigned long nr,
 /*
  * Find and display the p-th percentile of clat
  */
-static void show_clat_percentiles(unsigned int *io_u_plat, unsigned long nr,
-				  fio_fp64_t *plist, unsigned int precision)
+static void show_clat_percentiles(const char *name, unsigned int *io_u_plat,
+				  unsigned long nr, fio_fp64_t *plist,
+				  unsigned int precision)
 {
 	unsigned int len, j = 0, minv, maxv;
 	unsigned int *ovals;
@@ -199,10 +200,10 @@ static void show_clat_percentiles(unsigned int *io_u_plat, unsigned long nr,
 	 */
 	if (minv > 2000 && maxv > 99999) {
 		scale_down = 1;
-		log_info("    clat percentiles (msec):\n     |");
+		log_info("    %s percentiles (msec):\n     |", name);
 	} else {
 		scale_down = 0;
-		log_info("    clat percentiles (usec):\n     |");
+		log_info("    %s percentiles (usec):\n     |", name);
 	}
 
 	snprintf(fmt, sizeof(fmt), "%%1.%uf", precision);
@@ -402,7 +403,7 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 		display_lat(" lat", min, max, mean, dev);
 
 	if (ts->clat_percentiles) {
-		show_clat_percentiles(ts->io_u_plat[ddir],
+		show_clat_percentiles("clat", ts->io_u_plat[ddir],
 					ts->clat_stat[ddir].samples,
 					ts->percentile_list,
 					ts->percentile_precision);
@@ -438,6 +439,126 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 	}
 }
 
+static void show_io_op_status(struct thread_stat *ts)
+{
+	unsigned long min, max;
+	double mean, dev;
+	int i;
+
+	for (i = 0; i < ts->nr_io_ops; i++) {
+		struct io_stat *is = &ts->io_op_clat_stat[i];
+
+		if (!is->samples)
+			continue;
+
+		log_info("  %-6s: ops=%llu\n", ts->io_op_name[i],
+					(unsigned long long) is->samples);
+
+		if (calc_lat(is, &min, &max, &mean, &dev))
+			display_lat("clat", min, max, mean, dev);
+
+		if (ts->clat_percentiles) {
+			show_clat_percentiles("clat", ts->io_op_plat[i],
+						is->samples,
+						ts->percentile_list,
+						ts->percentile_precision);
+		}
+	}
+}
+
+static double ftl_write_amp(struct thread_stat *ts)
+{
+	if (!ts->ftl_host_writes)
+		return 0.0;
+
+	return (double) (ts->ftl_host_writes + ts->ftl_gc_writes) /
+			(double) ts->ftl_host_writes;
+}
+
+static void show_ftl_status(struct thread_stat *ts)
+{
+	struct io_stat *is = &ts->ftl_gc_stat;
+	unsigned long min, max;
+	double mean, dev;
+	char *map;
+
+	map = num2str(ts->ftl_map_bytes, 6, 1, 1, 8);
+	log_info("  ftl    : WA=%1.3f, host=%llu, gc=%llu, erases=%llu,"
+		 " map=%s\n", ftl_write_amp(ts),
+		 (unsigned long long) ts->ftl_host_writes,
+		 (unsigned long long) ts->ftl_gc_writes,
+		 (unsigned long long) ts->ftl_erases, map);
+	free(map);
+
+	if (calc_lat(is, &min, &max, &mean, &dev))
+		display_lat("gc", min, max, mean, dev);
+
+	if (ts->clat_percentiles && is->samples) {
+		show_clat_percentiles("gc", ts->ftl_gc_plat, is->samples,
+					ts->percentile_list,
+					ts->percentile_precision);
+	}
+}
+
+static void show_zone_status(struct thread_stat *ts)
+{
+	unsigned long min, max;
+	double mean, dev;
+
+	log_info("  zone   : resets=%llu",
+			(unsigned long long) ts->zone_reset_stat.samples);
+	if (ts->zone_appends) {
+		log_info(", appends=%llu, filled=%llu",
+			(unsigned long long) ts->zone_appends,
+			(unsigned long long) ts->zone_append_bw_stat.samples);
+	}
+	log_info("\n");
+
+	if (calc_lat(&ts->zone_reset_stat, &min, &max, &mean, &dev))
+		display_lat("reset", min, max, mean, dev);
+
+	if (calc_lat(&ts->zone_append_bw_stat, &min, &max, &mean, &dev)) {
+		log_info("    append bw (KB/s): min=%5lu, max=%5lu,"
+			 " avg=%5.02f, stdev=%5.02f\n", min, max, mean, dev);
+	}
+}
+
+static void show_poll_status(struct thread_stat *ts)
+{
+	uint64_t waits = ts->poll_spin_reaps + ts->poll_sleeps;
+
+	log_info("  poll   : spin=%lluusec, sleep=%lluusec, reaped spinning"
+		 "=%3.2f%% of %llu waits\n",
+			(unsigned long long) ts->poll_spin_usec,
+			(unsigned long long) ts->poll_sleep_usec,
+			100.0 * (double) ts->poll_spin_reaps / (double) waits,
+			(unsigned long long) waits);
+}
+
+/*
+ * Throughput is per verify thread busy time, how fast the verify
+ * threads go when they have work
+ */
+static void show_verify_async_status(struct thread_stat *ts)
+{
+	unsigned long min, max;
+	double mean, dev, rate = 0.0;
+
+	if (ts->verify_async_usec)
+		rate = (double) ts->verify_async_bytes * 1000000.0 /
+				(double) ts->verify_async_usec / 1048576.0;
+
+	log_info("  verify async : ios=%llu, bytes=%llu, busy=%llumsec,"
+		 " rate=%5.02fMB/s\n",
+			(unsigned long long) ts->verify_async_wait_stat.samples,
+			(unsigned long long) ts->verify_async_bytes,
+			(unsigned long long) ts->verify_async_usec / 1000,
+			rate);
+
+	if (calc_lat(&ts->verify_async_wait_stat, &min, &max, &mean, &dev))
+		display_lat("queue wait", min, max, mean, dev);
+}
+
 static int show_lat(double *io_u_lat, int nr, const char **ranges,
 		    const char *msg)
 {
@@ -497,6 +618,40 @@ static void show_latencies(struct thread_stat *ts)
 	show_lat_m(io_u_lat_m);
 }
 
+static void calc_thread_cpu(struct thread_stat *ts, uint64_t usr_time,
+			    uint64_t sys_time, double *usr_cpu,
+			    double *sys_cpu)
+{
+	if (ts->total_run_time) {
+		double runt = (double) ts->total_run_time;
+
+		*usr_cpu = (double) usr_time * 100 / runt;
+		*sys_cpu = (double) sys_time * 100 / runt;
+	} else {
+		*usr_cpu = 0;
+		*sys_cpu = 0;
+	}
+}
+
+/*
+ * Split of the cpu usage between the job thread and its reap_thread
+ */
+static void show_reap_cpu(struct thread_stat *ts)
+{
+	double usr_cpu, sys_cpu;
+
+	calc_thread_cpu(ts, ts->usr_time - ts->reap_usr_time,
+			ts->sys_time - ts->reap_sys_time, &usr_cpu, &sys_cpu);
+	log_info("     job cpu   : usr=%3.2f%%, sys=%3.2f%%, ctx=%llu\n",
+			usr_cpu, sys_cpu,
+			(unsigned long long) (ts->ctx - ts->reap_ctx));
+
+	calc_thread_cpu(ts, ts->reap_usr_time, ts->reap_sys_time, &usr_cpu,
+			&sys_cpu);
+	log_info("     reap cpu  : usr=%3.2f%%, sys=%3.2f%%, ctx=%llu\n",
+			usr_cpu, sys_cpu, (unsigned long long) ts->reap_ctx);
+}
+
 static void show_thread_status_normal(struct thread_stat *ts,
 				      struct group_run_stats *rs)
 {
@@ -534,6 +689,16 @@ static void show_thread_status_normal(struct thread_stat *ts,
 		show_ddir_status(rs, ts, DDIR_WRITE);
 	if (ts->io_bytes[DDIR_TRIM])
 		show_ddir_status(rs, ts, DDIR_TRIM);
+	if (ts->nr_io_ops)
+		show_io_op_status(ts);
+	if (ts->ftl_host_writes)
+		show_ftl_status(ts);
+	if (ts->zone_reset_stat.samples || ts->zone_appends)
+		show_zone_status(ts);
+	if (ts->poll_spin_reaps || ts->poll_sleeps)
+		show_poll_status(ts);
+	if (ts->verify_async_wait_stat.samples)
+		show_verify_async_status(ts);
 
 	show_latencies(ts);
 
@@ -553,6 +718,8 @@ static void show_thread_status_normal(struct thread_stat *ts,
 			(unsigned long long) ts->ctx,
 			(unsigned long long) ts->majf,
 			(unsigned long long) ts->minf);
+	if (ts->reap_usr_time || ts->reap_sys_time || ts->reap_ctx)
+		show_reap_cpu(ts);
 
 	stat_calc_dist(ts->io_u_map, ddir_rw_sum(ts->total_io_u), io_u_dist);
 	log_info("  IO depths    : 1=%3.1f%%, 2=%3.1f%%, 4=%3.1f%%, 8=%3.1f%%,"
@@ -775,6 +942,164 @@ static void add_ddir_status_json(struct thread_stat *ts,
 	json_object_add_value_float(dir_object, "bw_dev", dev);
 }
 
+static void add_ftl_status_json(struct thread_stat *ts,
+				struct json_object *parent)
+{
+	struct io_stat *is = &ts->ftl_gc_stat;
+	struct json_object *ftl_object, *tmp_object;
+	struct json_object *percentile_object;
+	unsigned int *ovals = NULL;
+	unsigned int len, minv, maxv;
+	unsigned long min, max;
+	double mean, dev;
+	char buf[120];
+	int i;
+
+	ftl_object = json_create_object();
+	json_object_add_value_object(parent, "ftl", ftl_object);
+	json_object_add_value_float(ftl_object, "write_amp", ftl_write_amp(ts));
+	json_object_add_value_int(ftl_object, "page_size", ts->ftl_page_size);
+	json_object_add_value_int(ftl_object, "host_writes", ts->ftl_host_writes);
+	json_object_add_value_int(ftl_object, "gc_writes", ts->ftl_gc_writes);
+	json_object_add_value_int(ftl_object, "erases", ts->ftl_erases);
+	json_object_add_value_int(ftl_object, "map_bytes", ts->ftl_map_bytes);
+	json_object_add_value_int(ftl_object, "gc_runs", is->samples);
+
+	if (!calc_lat(is, &min, &max, &mean, &dev)) {
+		min = max = 0;
+		mean = dev = 0.0;
+	}
+	tmp_object = json_create_object();
+	json_object_add_value_object(ftl_object, "gc", tmp_object);
+	json_object_add_value_int(tmp_object, "min", min);
+	json_object_add_value_int(tmp_object, "max", max);
+	json_object_add_value_float(tmp_object, "mean", mean);
+	json_object_add_value_float(tmp_object, "stddev", dev);
+
+	if (ts->clat_percentiles) {
+		len = calc_clat_percentiles(ts->ftl_gc_plat, is->samples,
+					ts->percentile_list, &ovals,
+					&maxv, &minv);
+	} else
+		len = 0;
+
+	percentile_object = json_create_object();
+	json_object_add_value_object(tmp_object, "percentile",
+					percentile_object);
+	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++) {
+		if (i >= len) {
+			json_object_add_value_int(percentile_object, "0.00", 0);
+			continue;
+		}
+		snprintf(buf, sizeof(buf), "%f", ts->percentile_list[i].u.f);
+		json_object_add_value_int(percentile_object, (const char *)buf, ovals[i]);
+	}
+
+	if (ovals)
+		free(ovals);
+}
+
+static void add_zone_status_json(struct thread_stat *ts,
+				 struct json_object *parent)
+{
+	struct json_object *tmp_object;
+	unsigned long min, max;
+	double mean, dev;
+
+	if (!calc_lat(&ts->zone_reset_stat, &min, &max, &mean, &dev)) {
+		min = max = 0;
+		mean = dev = 0.0;
+	}
+
+	tmp_object = json_create_object();
+	json_object_add_value_object(parent, "zone_reset", tmp_object);
+	json_object_add_value_int(tmp_object, "resets",
+					ts->zone_reset_stat.samples);
+	json_object_add_value_int(tmp_object, "min", min);
+	json_object_add_value_int(tmp_object, "max", max);
+	json_object_add_value_float(tmp_object, "mean", mean);
+	json_object_add_value_float(tmp_object, "stddev", dev);
+
+	if (!ts->zone_appends)
+		return;
+
+	if (!calc_lat(&ts->zone_append_bw_stat, &min, &max, &mean, &dev)) {
+		min = max = 0;
+		mean = dev = 0.0;
+	}
+
+	tmp_object = json_create_object();
+	json_object_add_value_object(parent, "zone_append", tmp_object);
+	json_object_add_value_int(tmp_object, "appends", ts->zone_appends);
+	json_object_add_value_int(tmp_object, "zones_filled",
+					ts->zone_append_bw_stat.samples);
+	json_object_add_value_int(tmp_object, "bw_min", min);
+	json_object_add_value_int(tmp_object, "bw_max", max);
+	json_object_add_value_float(tmp_object, "bw_mean", mean);
+	json_object_add_value_float(tmp_object, "bw_dev", dev);
+}
+
+static void add_io_op_status_json(struct thread_stat *ts,
+				  struct json_object *parent)
+{
+	struct json_object *ops_object, *op_object, *tmp_object;
+	struct json_object *percentile_object;
+	unsigned int *ovals = NULL;
+	unsigned int len, minv, maxv;
+	unsigned long min, max;
+	double mean, dev;
+	char buf[120];
+	int i, j;
+
+	ops_object = json_create_object();
+	json_object_add_value_object(parent, "io_ops", ops_object);
+
+	for (i = 0; i < ts->nr_io_ops; i++) {
+		struct io_stat *is = &ts->io_op_clat_stat[i];
+
+		op_object = json_create_object();
+		json_object_add_value_object(ops_object, ts->io_op_name[i],
+						op_object);
+		json_object_add_value_int(op_object, "ops", is->samples);
+
+		if (!calc_lat(is, &min, &max, &mean, &dev)) {
+			min = max = 0;
+			mean = dev = 0.0;
+		}
+		tmp_object = json_create_object();
+		json_object_add_value_object(op_object, "clat", tmp_object);
+		json_object_add_value_int(tmp_object, "min", min);
+		json_object_add_value_int(tmp_object, "max", max);
+		json_object_add_value_float(tmp_object, "mean", mean);
+		json_object_add_value_float(tmp_object, "stddev", dev);
+
+		if (ts->clat_percentiles) {
+			len = calc_clat_percentiles(ts->io_op_plat[i],
+						is->samples,
+						ts->percentile_list, &ovals,
+						&maxv, &minv);
+		} else
+			len = 0;
+
+		percentile_object = json_create_object();
+		json_object_add_value_object(tmp_object, "percentile",
+						percentile_object);
+		for (j = 0; j < FIO_IO_U_LIST_MAX_LEN; j++) {
+			if (j >= len) {
+				json_object_add_value_int(percentile_object, "0.00", 0);
+				continue;
+			}
+			snprintf(buf, sizeof(buf), "%f", ts->percentile_list[j].u.f);
+			json_object_add_value_int(percentile_object, (const char *)buf, ovals[j]);
+		}
+
+		if (ovals) {
+			free(ovals);
+			ovals = NULL;
+		}
+	}
+}
+
 static void show_thread_status_terse_v2(struct thread_stat *ts,
 					struct group_run_stats *rs)
 {
@@ -905,6 +1230,34 @@ static void show_thread_status_terse_v3_v4(struct thread_stat *ts,
 	log_info("\n");
 }
 
+static void add_verify_async_status_json(struct thread_stat *ts,
+					 struct json_object *parent)
+{
+	struct json_object *tmp_object, *wait_object;
+	unsigned long min, max;
+	double mean, dev;
+
+	if (!calc_lat(&ts->verify_async_wait_stat, &min, &max, &mean, &dev)) {
+		min = max = 0;
+		mean = dev = 0.0;
+	}
+
+	tmp_object = json_create_object();
+	json_object_add_value_object(parent, "verify_async", tmp_object);
+	json_object_add_value_int(tmp_object, "ios",
+					ts->verify_async_wait_stat.samples);
+	json_object_add_value_int(tmp_object, "bytes", ts->verify_async_bytes);
+	json_object_add_value_int(tmp_object, "busy_usec",
+					ts->verify_async_usec);
+
+	wait_object = json_create_object();
+	json_object_add_value_object(tmp_object, "queue_wait", wait_object);
+	json_object_add_value_int(wait_object, "min", min);
+	json_object_add_value_int(wait_object, "max", max);
+	json_object_add_value_float(wait_object, "mean", mean);
+	json_object_add_value_float(wait_object, "stddev", dev);
+}
+
 static struct json_object *show_thread_status_json(struct thread_stat *ts,
 				    struct group_run_stats *rs)
 {
@@ -923,6 +1276,28 @@ static struct json_object *show_thread_status_json(struct thread_stat *ts,
 	add_ddir_status_json(ts, rs, DDIR_READ, root);
 	add_ddir_status_json(ts, rs, DDIR_WRITE, root);
 	add_ddir_status_json(ts, rs, DDIR_TRIM, root);
+	if (ts->nr_io_ops)
+		add_io_op_status_json(ts, root);
+	if (ts->ftl_host_writes)
+		add_ftl_status_json(ts, root);
+	if (ts->zone_reset_stat.samples || ts->zone_appends)
+		add_zone_status_json(ts, root);
+	if (ts->poll_spin_reaps || ts->poll_sleeps) {
+		struct json_object *tmp_object;
+
+		tmp_object = json_create_object();
+		json_object_add_value_object(root, "poll", tmp_object);
+		json_object_add_value_int(tmp_object, "spin_reaps",
+						ts->poll_spin_reaps);
+		json_object_add_value_int(tmp_object, "sleeps",
+						ts->poll_sleeps);
+		json_object_add_value_int(tmp_object, "spin_usec",
+						ts->poll_spin_usec);
+		json_object_add_value_int(tmp_object, "sleep_usec",
+						ts->poll_sleep_usec);
+	}
+	if (ts->verify_async_wait_stat.samples)
+		add_verify_async_status_json(ts, root);
 
 	/* CPU Usage */
 	if (ts->total_run_time) {
@@ -940,6 +1315,31 @@ static struct json_object *show_thread_status_json(struct thread_stat *ts,
 	json_object_add_value_int(root, "majf", ts->majf);
 	json_object_add_value_int(root, "minf", ts->minf);
 
+	if (ts->reap_usr_time || ts->reap_sys_time || ts->reap_ctx) {
+		struct json_object *threads, *thread_object;
+
+		threads = json_create_object();
+		json_object_add_value_object(root, "cpu_threads", threads);
+
+		thread_object = json_create_object();
+		json_object_add_value_object(threads, "submit", thread_object);
+		calc_thread_cpu(ts, ts->usr_time - ts->reap_usr_time,
+				ts->sys_time - ts->reap_sys_time, &usr_cpu,
+				&sys_cpu);
+		json_object_add_value_float(thread_object, "usr_cpu", usr_cpu);
+		json_object_add_value_float(thread_object, "sys_cpu", sys_cpu);
+		json_object_add_value_int(thread_object, "ctx",
+						ts->ctx - ts->reap_ctx);
+
+		thread_object = json_create_object();
+		json_object_add_value_object(threads, "reap", thread_object);
+		calc_thread_cpu(ts, ts->reap_usr_time, ts->reap_sys_time,
+				&usr_cpu, &sys_cpu);
+		json_object_add_value_float(thread_object, "usr_cpu", usr_cpu);
+		json_object_add_value_float(thread_object, "sys_cpu", sys_cpu);
+		json_object_add_value_int(thread_object, "ctx", ts->reap_ctx);
+	}
+
 
 	/* Calc % distribution of IO depths, usecond, msecond latency */
 	stat_calc_dist(ts->io_u_map, ddir_rw_sum(ts->total_io_u), io_u_dist);
@@ -1140,6 +1540,48 @@ void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src, int nr)
 		}
 	}
 
+	for (k = 0; k < src->nr_io_ops; k++) {
+		int m;
+
+		if (k >= dst->nr_io_ops) {
+			strncpy(dst->io_op_name[k], src->io_op_name[k],
+					FIO_IO_OP_NAME_SIZE - 1);
+		}
+
+		sum_stat(&dst->io_op_clat_stat[k], &src->io_op_clat_stat[k], nr);
+		for (m = 0; m < FIO_IO_U_PLAT_NR; m++)
+			dst->io_op_plat[k][m] += src->io_op_plat[k][m];
+	}
+	if (src->nr_io_ops > dst->nr_io_ops)
+		dst->nr_io_ops = src->nr_io_ops;
+
+	dst->ftl_host_writes += src->ftl_host_writes;
+	dst->ftl_gc_writes += src->ftl_gc_writes;
+	dst->ftl_erases += src->ftl_erases;
+	dst->ftl_map_bytes += src->ftl_map_bytes;
+	if (!dst->ftl_page_size)
+		dst->ftl_page_size = src->ftl_page_size;
+	sum_stat(&dst->ftl_gc_stat, &src->ftl_gc_stat, nr);
+	for (k = 0; k < FIO_IO_U_PLAT_NR; k++)
+		dst->ftl_gc_plat[k] += src->ftl_gc_plat[k];
+
+	sum_stat(&dst->zone_reset_stat, &src->zone_reset_stat, nr);
+	dst->zone_appends += src->zone_appends;
+	sum_stat(&dst->zone_append_bw_stat, &src->zone_append_bw_stat, nr);
+
+	dst->poll_spin_reaps += src->poll_spin_reaps;
+	dst->poll_sleeps += src->poll_sleeps;
+	dst->poll_spin_usec += src->poll_spin_usec;
+	dst->poll_sleep_usec += src->poll_sleep_usec;
+
+	dst->reap_usr_time += src->reap_usr_time;
+	dst->reap_sys_time += src->reap_sys_time;
+	dst->reap_ctx += src->reap_ctx;
+
+	dst->verify_async_bytes += src->verify_async_bytes;
+	dst->verify_async_usec += src->verify_async_usec;
+	sum_stat(&dst->verify_async_wait_stat, &src->verify_async_wait_stat, nr);
+
 	dst->total_run_time += src->total_run_time;
 	dst->total_submit += src->total_submit;
 	dst->total_complete += src->total_complete;
@@ -1166,6 +1608,12 @@ void init_thread_stat(struct thread_stat *ts)
 		ts->slat_stat[j].min_val = -1UL;
 		ts->bw_stat[j].min_val = -1UL;
 	}
+	for (j = 0; j < FIO_IO_OP_NR; j++)
+		ts->io_op_clat_stat[j].min_val = -1UL;
+	ts->ftl_gc_stat.min_val = -1UL;
+	ts->zone_reset_stat.min_val = -1UL;
+	ts->zone_append_bw_stat.min_val = -1UL;
+	ts->verify_async_wait_stat.min_val = -1UL;
 	ts->groupid = -1;
 }
 
@@ -1659,6 +2107,49 @@ void reset_io_stats(struct thread_data *td)
 		ts->total_io_u[i] = 0;
 		ts->short_io_u[i] = 0;
 	}
+
+	for (i = 0; i < FIO_IO_OP_NR; i++) {
+		reset_io_stat(&ts->io_op_clat_stat[i]);
+
+		for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+			ts->io_op_plat[i][j] = 0;
+	}
+
+	ts->ftl_host_writes = 0;
+	ts->ftl_gc_writes = 0;
+	ts->ftl_erases = 0;
+	reset_io_stat(&ts->ftl_gc_stat);
+	for (j = 0; j < FIO_IO_U_PLAT_NR; j++)
+		ts->ftl_gc_plat[j] = 0;
+
+	reset_io_stat(&ts->zone_reset_stat);
+	ts->zone_appends = 0;
+	reset_io_stat(&ts->zone_append_bw_stat);
+
+	ts->poll_spin_reaps = 0;
+	ts->poll_sleeps = 0;
+	ts->poll_spin_usec = 0;
+	ts->poll_sleep_usec = 0;
+
+	ts->verify_async_bytes = 0;
+	ts->verify_async_usec = 0;
+	reset_io_stat(&ts->verify_async_wait_stat);
+}
+
+/*
+ * Called by engines to enable per command type latency accounting,
+ * 'op' being the value the engine stores in io_u->io_op.
+ */
+void stat_set_io_op_name(struct thread_data *td, unsigned int op,
+			 const char *name)
+{
+	struct thread_stat *ts = &td->ts;
+
+	assert(op < FIO_IO_OP_NR);
+
+	strncpy(ts->io_op_name[op], name, FIO_IO_OP_NAME_SIZE - 1);
+	if (op >= ts->nr_io_ops)
+		ts->nr_io_ops = op + 1;
 }
 
 static void _add_stat_to_log(struct io_log *iolog, unsigned long elapsed)
@@ -1785,6 +2276,66 @@ void add_clat_sample(struct thread_data *td, enum fio_ddir ddir,
 		add_clat_percentile_sample(ts, usec, ddir);
 }
 
+void add_io_op_clat_sample(struct thread_data *td, unsigned int op,
+			   unsigned long usec)
+{
+	struct thread_stat *ts = &td->ts;
+
+	if (op >= ts->nr_io_ops)
+		return;
+
+	add_stat_sample(&ts->io_op_clat_stat[op], usec);
+
+	if (ts->clat_percentiles)
+		ts->io_op_plat[op][plat_val_to_idx(usec)]++;
+}
+
+/*
+ * Called by the ftl engine with the duration of each garbage collection run.
+ */
+void add_ftl_gc_sample(struct thread_data *td, unsigned long usec)
+{
+	struct thread_stat *ts = &td->ts;
+
+	add_stat_sample(&ts->ftl_gc_stat, usec);
+
+	if (ts->clat_percentiles)
+		ts->ftl_gc_plat[plat_val_to_idx(usec)]++;
+}
+
+void add_zone_reset_sample(struct thread_data *td, unsigned long usec)
+{
+	add_stat_sample(&td->ts.zone_reset_stat, usec);
+}
+
+/*
+ * Each verify_async thread keeps its own wait stat, and folds it into the
+ * job's as it exits
+ */
+void add_verify_wait_sample(struct io_stat *is, unsigned long usec)
+{
+	add_stat_sample(is, usec);
+}
+
+void add_verify_async_stats(struct thread_data *td, uint64_t bytes,
+			    uint64_t usec, struct io_stat *wait)
+{
+	struct thread_stat *ts = &td->ts;
+
+	ts->verify_async_bytes += bytes;
+	ts->verify_async_usec += usec;
+	sum_stat(&ts->verify_async_wait_stat, wait,
+			ts->verify_async_wait_stat.samples ? 2 : 1);
+}
+
+void add_zone_append_sample(struct thread_data *td, unsigned long appends,
+			    unsigned long kb_rate)
+{
+	td->ts.zone_appends += appends;
+	if (kb_rate)
+		add_stat_sample(&td->ts.zone_append_bw_stat, kb_rate);
+}
+
 void add_slat_sample(struct thread_data *td, enum fio_ddir ddir,
 		     unsigned long usec, unsigned int bs, uint64_t offset)
 {
@@ -112,6 +112,15 @@ struct group_run_stats {
 #define FIO_IO_U_LIST_MAX_LEN 20 /* The size of the default and user-specified
 					list of percentiles */
 
+/*
+ * Engines that issue more than one command type per data direction (eg
+ * the kv engine's PUT and UPDATE for writes) can have completion latency
+ * accounted per command type as well. The engine names the types and
+ * tags each io_u with its type in io_u->io_op.
+ */
+#define FIO_IO_OP_NR		4
+#define FIO_IO_OP_NAME_SIZE	16
+
 #define MAX_PATTERN_SIZE	512
 #define FIO_JOBNAME_SIZE	128
 #define FIO_JOBDESC_SIZE	256
@@ -181,6 +190,57 @@ struct thread_stat {
 	uint64_t latency_target;
 	fio_fp64_t latency_percentile;
 	uint64_t latency_window;
+
+	/*
+	 * Per engine command type completion latency
+	 */
+	uint32_t nr_io_ops;
+	char io_op_name[FIO_IO_OP_NR][FIO_IO_OP_NAME_SIZE];
+	struct io_stat io_op_clat_stat[FIO_IO_OP_NR];
+	uint32_t io_op_plat[FIO_IO_OP_NR][FIO_IO_U_PLAT_NR];
+
+	/*
+	 * Flash translation layer simulation, in pages
+	 */
+	uint64_t ftl_host_writes;
+	uint64_t ftl_gc_writes;
+	uint64_t ftl_erases;
+	uint64_t ftl_map_bytes;
+	uint32_t ftl_page_size;
+	struct io_stat ftl_gc_stat;
+	uint32_t ftl_gc_plat[FIO_IO_U_PLAT_NR];
+
+	/*
+	 * Zone resets with zonemode=zbd, and the bandwidth each zone was
+	 * filled at with zone_append
+	 */
+	struct io_stat zone_reset_stat;
+	uint64_t zone_appends;
+	struct io_stat zone_append_bw_stat;
+
+	/*
+	 * Completion waits of engines that poll before sleeping, split by
+	 * how the wait ended, and the time spent in each
+	 */
+	uint64_t poll_spin_reaps;
+	uint64_t poll_sleeps;
+	uint64_t poll_spin_usec;
+	uint64_t poll_sleep_usec;
+
+	/*
+	 * Share of the system usage above that was the reap_thread
+	 */
+	uint64_t reap_usr_time;
+	uint64_t reap_sys_time;
+	uint64_t reap_ctx;
+
+	/*
+	 * Work of the verify_async threads: bytes verified, the time spent
+	 * verifying them and how long io_us waited to be picked up
+	 */
+	uint64_t verify_async_bytes;
+	uint64_t verify_async_usec;
+	struct io_stat verify_async_wait_stat;
 } __attribute__((packed));
 
 struct jobs_eta {
@@ -232,6 +292,7 @@ extern void stat_calc_lat_m(struct thread_stat *ts, double *io_u_lat);
 extern void stat_calc_lat_u(struct thread_stat *ts, double *io_u_lat);
 extern void stat_calc_dist(unsigned int *map, unsigned long total, double *io_u_dist);
 extern void reset_io_stats(struct thread_data *);
+extern void stat_set_io_op_name(struct thread_data *, unsigned int, const char *);
 
 static inline int usec_to_msec(unsigned long *min, unsigned long *max,
 			       double *mean, double *dev)
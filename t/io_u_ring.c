@@ -0,0 +1,262 @@
+/*
+ * Benchmark for the io_u rings in io_u_queue.h
+ *
+ * A fixed pool of io_us circulates the way it does in fio: the submitter
+ * takes them off a freelist and hands them to workers, the workers hand
+ * them straight back. With -m lockfree the handoff uses a spsc ring per
+ * worker and the freelist a mpsc ring (spsc with one worker). With -m mutex
+ * both are plain rings under a mutex, like the old verify list.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../io_u_queue.h"
+
+#define MAX_BATCH	64
+
+enum {
+	MODE_LOCKFREE,
+	MODE_MUTEX,
+};
+
+struct locked_ring {
+	pthread_mutex_t lock;
+	struct io_u_ring ring;
+};
+
+struct worker {
+	pthread_t thread;
+	struct io_u_spsc spsc;
+	struct locked_ring locked;
+};
+
+static int mode = MODE_LOCKFREE;
+static unsigned int depth = 64;
+static unsigned int batch = 8;
+static unsigned int nr_workers = 1;
+static unsigned long long nr_ops = 10000000ULL;
+
+static struct worker *workers;
+static struct io_u_spsc free_spsc;
+static struct io_u_mpsc free_mpsc;
+static struct locked_ring free_locked;
+static int stop;
+
+static void locked_push(struct locked_ring *r, struct io_u **io_us,
+			unsigned int nr)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&r->lock);
+	for (i = 0; i < nr; i++)
+		io_u_rpush(&r->ring, io_us[i]);
+	pthread_mutex_unlock(&r->lock);
+}
+
+static unsigned int locked_pop(struct locked_ring *r, struct io_u **io_us,
+			       unsigned int max)
+{
+	unsigned int nr = 0;
+
+	pthread_mutex_lock(&r->lock);
+	while (nr < max && (io_us[nr] = io_u_rpop(&r->ring)) != NULL)
+		nr++;
+	pthread_mutex_unlock(&r->lock);
+
+	return nr;
+}
+
+static void free_push(struct io_u **io_us, unsigned int nr)
+{
+	if (mode == MODE_MUTEX)
+		locked_push(&free_locked, io_us, nr);
+	else if (nr_workers == 1)
+		io_u_spsc_push_batch(&free_spsc, io_us, nr);
+	else
+		io_u_mpsc_push_batch(&free_mpsc, io_us, nr);
+}
+
+static unsigned int free_pop(struct io_u **io_us, unsigned int max)
+{
+	if (mode == MODE_MUTEX)
+		return locked_pop(&free_locked, io_us, max);
+	else if (nr_workers == 1)
+		return io_u_spsc_pop_batch(&free_spsc, io_us, max);
+
+	return io_u_mpsc_pop_batch(&free_mpsc, io_us, max);
+}
+
+static void *worker_fn(void *data)
+{
+	struct worker *w = data;
+	struct io_u *io_us[MAX_BATCH];
+	unsigned int nr;
+	int done;
+
+	/*
+	 * Look at stop before popping, so whatever was submitted before it
+	 * was set is seen
+	 */
+	do {
+		done = atomic_load_acquire(&stop);
+
+		if (mode == MODE_MUTEX)
+			nr = locked_pop(&w->locked, io_us, batch);
+		else
+			nr = io_u_spsc_pop_batch(&w->spsc, io_us, batch);
+
+		if (nr)
+			free_push(io_us, nr);
+		else
+			sched_yield();
+	} while (nr || !done);
+
+	return NULL;
+}
+
+static void submit(struct worker *w, struct io_u **io_us, unsigned int nr)
+{
+	if (mode == MODE_MUTEX)
+		locked_push(&w->locked, io_us, nr);
+	else
+		io_u_spsc_push_batch(&w->spsc, io_us, nr);
+}
+
+static int init_rings(void)
+{
+	unsigned int i;
+	int err = 0;
+
+	workers = calloc(nr_workers, sizeof(struct worker));
+
+	for (i = 0; i < nr_workers; i++) {
+		struct worker *w = &workers[i];
+
+		err += io_u_spsc_init(&w->spsc, depth);
+		err += io_u_rinit(&w->locked.ring, depth);
+		pthread_mutex_init(&w->locked.lock, NULL);
+	}
+
+	err += io_u_spsc_init(&free_spsc, depth);
+	err += io_u_mpsc_init(&free_mpsc, depth);
+	err += io_u_rinit(&free_locked.ring, depth);
+	pthread_mutex_init(&free_locked.lock, NULL);
+
+	return err;
+}
+
+static double elapsed(struct timespec *s, struct timespec *e)
+{
+	return (e->tv_sec - s->tv_sec) + (e->tv_nsec - s->tv_nsec) / 1e9;
+}
+
+static void usage(void)
+{
+	printf("Usage: io_u_ring [-m lockfree|mutex] [-w workers] [-d depth] "
+		"[-b batch] [-n ops]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long long submitted = 0;
+	struct io_u *io_us[MAX_BATCH];
+	void **pool;
+	struct timespec start, end;
+	unsigned int i, next = 0;
+	double secs;
+	int c;
+
+	while ((c = getopt(argc, argv, "m:w:d:b:n:h")) != -1) {
+		switch (c) {
+		case 'm':
+			if (!strcmp(optarg, "mutex"))
+				mode = MODE_MUTEX;
+			else if (!strcmp(optarg, "lockfree"))
+				mode = MODE_LOCKFREE;
+			else {
+				usage();
+				return 1;
+			}
+			break;
+		case 'w':
+			nr_workers = atoi(optarg);
+			break;
+		case 'd':
+			depth = atoi(optarg);
+			break;
+		case 'b':
+			batch = atoi(optarg);
+			break;
+		case 'n':
+			nr_ops = strtoull(optarg, NULL, 10);
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	if (!nr_workers || !depth || !batch || batch > MAX_BATCH) {
+		printf("workers and depth must be > 0, batch 1..%d\n", MAX_BATCH);
+		return 1;
+	}
+
+	if (init_rings()) {
+		printf("failed allocating rings\n");
+		return 1;
+	}
+
+	/*
+	 * Never dereferenced, the rings only move the pointers around
+	 */
+	pool = calloc(depth, sizeof(void *));
+	for (i = 0; i < depth; i++) {
+		io_us[0] = (struct io_u *) &pool[i];
+		free_push(io_us, 1);
+	}
+
+	for (i = 0; i < nr_workers; i++)
+		pthread_create(&workers[i].thread, NULL, worker_fn, &workers[i]);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (submitted < nr_ops) {
+		unsigned int nr, want = batch;
+
+		if (want > nr_ops - submitted)
+			want = nr_ops - submitted;
+
+		nr = free_pop(io_us, want);
+		if (!nr) {
+			sched_yield();
+			continue;
+		}
+
+		submit(&workers[next], io_us, nr);
+		if (++next == nr_workers)
+			next = 0;
+
+		submitted += nr;
+	}
+
+	/*
+	 * The workers drain their rings before they exit
+	 */
+	atomic_store_release(&stop, 1);
+	for (i = 0; i < nr_workers; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	secs = elapsed(&start, &end);
+	printf("%s: %u workers, depth %u, batch %u: %llu ops in %.3fs, "
+		"%.2f Mops/s, %.1f ns/op\n",
+		mode == MODE_MUTEX ? "mutex" : "lockfree", nr_workers, depth,
+		batch, nr_ops, secs, nr_ops / secs / 1e6, secs * 1e9 / nr_ops);
+	return 0;
+}
@@ -0,0 +1,220 @@
+#!/bin/sh
+#
+# Measure how much CPU fio itself spends per IO. Every case runs a single
+# job against the null engine, so all the time spent is fio's own: offset
+# generation, the random map, verify headers, latency accounting, logging
+# and so on. Each case is run a number of times, and the mean and standard
+# deviation of the following are reported:
+#
+#	ns/io		CPU time used by the job per IO, in nanoseconds
+#	iops/core	IOs per second the job would do on a full core
+#	iops		IOs per second actually done
+#
+# ns/io and iops/core are normalized by the CPU time the job got, so they
+# stay comparable on a loaded or throttled box where plain iops does not.
+#
+# The results are also written out as JSON, one case per line. Pass a
+# previous file with -c to see how a build compares to it.
+#
+
+FIO=./fio
+RUNTIME=3
+RUNS=5
+OUTPUT=null-bench.json
+BASELINE=
+FILTER=.
+
+usage() {
+	echo "Usage: null-bench.sh [-f fio] [-r runtime] [-n runs] [-o out.json]"
+	echo "                     [-c baseline.json] [-m case-regex] [-l]"
+	echo ""
+	echo "  -f  fio binary to run (default ./fio)"
+	echo "  -r  seconds per run (default $RUNTIME)"
+	echo "  -n  runs per case (default $RUNS)"
+	echo "  -o  JSON results file (default $OUTPUT)"
+	echo "  -c  compare against a previous JSON results file"
+	echo "  -m  only run the cases whose name matches this regex"
+	echo "  -l  list the cases and exit"
+}
+
+#
+# name and the options that make up the case, on top of the common ones
+#
+cases() {
+	cat <<EOF
+gtod_reduce	--rw=randread --norandommap --gtod_reduce=1
+seq		--rw=read
+rand		--rw=randread --norandommap
+randommap	--rw=randread
+randommap_lfsr	--rw=randread --random_generator=lfsr
+offset_prefetch	--rw=randread --offset_prefetch=64
+zipf		--rw=randread --norandommap --random_distribution=zipf:1.2
+pareto		--rw=randread --norandommap --random_distribution=pareto:0.9
+randrw		--rw=randrw --norandommap --rwmixread=70
+bssplit		--rw=randread --norandommap --bssplit=4k/50:16k/30:64k/20
+refill		--rw=randwrite --norandommap --refill_buffers
+buffer_pool	--rw=randwrite --norandommap --refill_buffers --buffer_pool=64m
+compress	--rw=randwrite --norandommap --refill_buffers --buffer_compress_percentage=50
+dedupe		--rw=randwrite --norandommap --dedupe_percentage=50
+verify_crc32c	--rw=randwrite --norandommap --verify=crc32c --do_verify=0
+verify_md5	--rw=randwrite --norandommap --verify=md5 --do_verify=0
+verify_sha256	--rw=randwrite --norandommap --verify=sha256 --do_verify=0
+verify_xxh3	--rw=randwrite --norandommap --verify=xxh3 --do_verify=0
+percentiles	--rw=randread --norandommap --clat_percentiles=1
+lat_log		--rw=randread --norandommap --write_lat_log=LOGDIR/lat --log_avg_msec=1000
+iops_log	--rw=randread --norandommap --write_iops_log=LOGDIR/iops --log_avg_msec=1000
+rate		--rw=randread --norandommap --rate_iops=100000000
+iodepth32	--rw=randread --norandommap --iodepth=32 --iodepth_batch=16 --iodepth_batch_complete=16
+EOF
+}
+
+while getopts "f:r:n:o:c:m:lh" opt; do
+	case $opt in
+	f)	FIO=$OPTARG ;;
+	r)	RUNTIME=$OPTARG ;;
+	n)	RUNS=$OPTARG ;;
+	o)	OUTPUT=$OPTARG ;;
+	c)	BASELINE=$OPTARG ;;
+	m)	FILTER=$OPTARG ;;
+	l)	cases | awk -F'\t+' '{ printf "%-16s %s\n", $1, $2 }'
+		exit 0 ;;
+	*)	usage
+		exit 1 ;;
+	esac
+done
+
+if ! "$FIO" --version > /dev/null 2>&1; then
+	echo "null-bench: can't run $FIO, use -f to point at a fio binary"
+	exit 1
+fi
+
+if [ -n "$BASELINE" ] && [ ! -r "$BASELINE" ]; then
+	echo "null-bench: can't read baseline $BASELINE"
+	exit 1
+fi
+
+LOGDIR=$(mktemp -d "${TMPDIR:-/tmp}/null-bench.XXXXXX") || exit 1
+trap 'rm -rf "$LOGDIR"' EXIT
+mkdir "$LOGDIR/logs"
+
+COMMON="--name=null-bench --ioengine=null --thread --size=1g --bs=4k
+	--time_based --runtime=$RUNTIME --clat_percentiles=0 --minimal"
+
+#
+# Run a case once, print total iops and the job's cpu usage in percent.
+# Terse v3 has the read iops in field 8, write iops in 49 and usr/sys cpu
+# in 88 and 89.
+#
+run_one() {
+	$FIO $COMMON $1 | awk -F';' '
+		$1 == "3" {
+			usr = $88; sub("%", "", usr)
+			sys = $89; sub("%", "", sys)
+			printf "%d %f\n", $8 + $49, usr + sys
+			found = 1
+		}
+		END { if (!found) exit 1 }'
+}
+
+#
+# Read "iops cpu" lines and print the JSON line for the case
+#
+summarize() {
+	awk -v name="$1" -v opts="$2" '
+		BEGIN { n = 0 }
+		function mean(a, n,	i, s) {
+			for (i = 0; i < n; i++)
+				s += a[i]
+			return s / n
+		}
+		function stddev(a, n, m,	i, s) {
+			if (n < 2)
+				return 0
+			for (i = 0; i < n; i++)
+				s += (a[i] - m) ^ 2
+			return sqrt(s / (n - 1))
+		}
+		$1 > 0 {
+			cpu = $2 / 100
+			if (cpu <= 0)
+				cpu = 1
+			iops[n] = $1
+			ns[n] = cpu * 1e9 / $1
+			core[n] = $1 / cpu
+			n++
+		}
+		END {
+			if (!n)
+				exit 1
+			mi = mean(iops, n)
+			mn = mean(ns, n)
+			mc = mean(core, n)
+			printf "{ \"name\": \"%s\", \"options\": \"%s\", ", name, opts
+			printf "\"runs\": %d, ", n
+			printf "\"ns_per_io\": %.1f, \"ns_per_io_stddev\": %.1f, ", mn, stddev(ns, n, mn)
+			printf "\"iops_per_core\": %.0f, \"iops_per_core_stddev\": %.0f, ", mc, stddev(core, n, mc)
+			printf "\"iops\": %.0f, \"iops_stddev\": %.0f }\n", mi, stddev(iops, n, mi)
+		}'
+}
+
+#
+# Pull a field out of one of our own JSON lines
+#
+field() {
+	sed -n "s/.*\"$1\": \"\{0,1\}\([^,\"]*\)\"\{0,1\}[,}].*/\1/p"
+}
+
+printf "%-16s %10s %8s %12s %8s %12s" case ns/io +- iops/core +- iops
+if [ -n "$BASELINE" ]; then
+	printf " %10s %8s" base-ns/io delta
+fi
+printf "\n"
+
+RESULTS="$LOGDIR/results"
+: > "$RESULTS"
+
+cases | awk -F'\t+' -v re="$FILTER" '$1 ~ re' | while IFS='	' read -r name opts; do
+	opts=$(echo "$opts" | sed "s|LOGDIR|$LOGDIR/logs|g")
+
+	i=0
+	while [ $i -lt "$RUNS" ]; do
+		if ! run_one "$opts"; then
+			echo "null-bench: $name failed: $FIO $COMMON $opts" >&2
+		fi
+		i=$((i + 1))
+	done > "$LOGDIR/$name.runs"
+	rm -f "$LOGDIR"/logs/*
+
+	line=$(summarize "$name" "$(echo "$opts" | sed "s|$LOGDIR/logs|LOGDIR|g")" \
+		< "$LOGDIR/$name.runs") || continue
+	echo "$line" >> "$RESULTS"
+
+	ns=$(echo "$line" | field ns_per_io)
+	printf "%-16s %10s %8s %12s %8s %12s" "$name" "$ns" \
+		"$(echo "$line" | field ns_per_io_stddev)" \
+		"$(echo "$line" | field iops_per_core)" \
+		"$(echo "$line" | field iops_per_core_stddev)" \
+		"$(echo "$line" | field iops)"
+	if [ -n "$BASELINE" ]; then
+		base=$(grep "\"name\": \"$name\"" "$BASELINE" | field ns_per_io)
+		if [ -n "$base" ]; then
+			printf " %10s %7.1f%%" "$base" \
+				"$(echo "$ns $base" | awk '{ print ($1 - $2) * 100 / $2 }')"
+		else
+			printf " %10s %8s" - -
+		fi
+	fi
+	printf "\n"
+done
+
+{
+	echo "{"
+	echo "  \"fio_version\": \"$($FIO --version)\","
+	echo "  \"runtime\": $RUNTIME,"
+	echo "  \"cases\": ["
+	sed '$!s/$/,/; s/^/    /' "$RESULTS"
+	echo "  ]"
+	echo "}"
+} > "$OUTPUT"
+
+echo "Results written to $OUTPUT"
@@ -50,6 +50,7 @@ struct thread_options {
 	unsigned int iodepth_low;
 	unsigned int iodepth_batch;
 	unsigned int iodepth_batch_complete;
+	unsigned int reap_thread;
 
 	unsigned long long size;
 	unsigned long long io_limit;
@@ -99,6 +100,7 @@ struct thread_options {
 	unsigned long long verify_backlog;
 	unsigned int verify_batch;
 	unsigned int experimental_verify;
+	unsigned int verify_history;
 	unsigned int use_thread;
 	unsigned int unlink;
 	unsigned int do_disk_util;
@@ -125,6 +127,7 @@ struct thread_options {
 	fio_fp64_t pareto_h;
 
 	unsigned int random_generator;
+	unsigned int offset_prefetch;
 
 	unsigned int perc_rand[DDIR_RWDIR_CNT];
 
@@ -147,6 +150,9 @@ struct thread_options {
 	unsigned long long zone_range;
 	unsigned long long zone_size;
 	unsigned long long zone_skip;
+	unsigned int zone_mode;
+	unsigned int max_open_zones;
+	unsigned int zone_append;
 	unsigned long long lockmem;
 	enum fio_memtype mem_type;
 	unsigned int mem_align;
@@ -184,6 +190,9 @@ struct thread_options {
 	unsigned int buffer_pattern_bytes;
 	unsigned int compress_percentage;
 	unsigned int compress_chunk;
+	unsigned int compress_calibrate;
+	unsigned int dedupe_percentage;
+	unsigned int buffer_pool;
 	unsigned int time_based;
 	unsigned int disable_lat;
 	unsigned int disable_clat;
@@ -257,6 +266,17 @@ struct thread_options {
 	unsigned long long latency_target;
 	unsigned long long latency_window;
 	fio_fp64_t latency_percentile;
+
+	/*
+	 * Open-channel SSD geometry
+	 */
+	unsigned int nvm_channels;
+	unsigned int nvm_luns;
+	unsigned int nvm_planes;
+	unsigned int nvm_pages_per_block;
+	unsigned int nvm_sectors_per_page;
+	unsigned int nvm_sector_size;
+	unsigned int nvm_stripe_units;
 };
 
 #define FIO_TOP_STR_MAX		256
@@ -280,6 +300,7 @@ struct thread_options_pack {
 	uint32_t iodepth_low;
 	uint32_t iodepth_batch;
 	uint32_t iodepth_batch_complete;
+	uint32_t reap_thread;
 
 	uint64_t size;
 	uint64_t io_limit;
@@ -329,6 +350,7 @@ struct thread_options_pack {
 	uint64_t verify_backlog;
 	uint32_t verify_batch;
 	uint32_t experimental_verify;
+	uint32_t verify_history;
 	uint32_t use_thread;
 	uint32_t unlink;
 	uint32_t do_disk_util;
@@ -352,6 +374,7 @@ struct thread_options_pack {
 	fio_fp64_t pareto_h;
 
 	uint32_t random_generator;
+	uint32_t offset_prefetch;
 
 	uint32_t perc_rand[DDIR_RWDIR_CNT];
 
@@ -374,6 +397,9 @@ struct thread_options_pack {
 	uint64_t zone_range;
 	uint64_t zone_size;
 	uint64_t zone_skip;
+	uint32_t zone_mode;
+	uint32_t max_open_zones;
+	uint32_t zone_append;
 	uint64_t lockmem;
 	uint32_t mem_type;
 	uint32_t mem_align;
@@ -405,6 +431,9 @@ struct thread_options_pack {
 	uint32_t buffer_pattern_bytes;
 	unsigned int compress_percentage;
 	unsigned int compress_chunk;
+	uint32_t compress_calibrate;
+	uint32_t dedupe_percentage;
+	uint32_t buffer_pool;
 	uint32_t time_based;
 	uint32_t disable_lat;
 	uint32_t disable_clat;
@@ -478,6 +507,14 @@ struct thread_options_pack {
 	uint64_t latency_target;
 	uint64_t latency_window;
 	fio_fp64_t latency_percentile;
+
+	uint32_t nvm_channels;
+	uint32_t nvm_luns;
+	uint32_t nvm_planes;
+	uint32_t nvm_pages_per_block;
+	uint32_t nvm_sectors_per_page;
+	uint32_t nvm_sector_size;
+	uint32_t nvm_stripe_units;
 } __attribute__((packed));
 
 extern void convert_thread_options_to_cpu(struct thread_options *o, struct thread_options_pack *top);
@@ -24,6 +24,7 @@
 #include "crc/sha512.h"
 #include "crc/sha1.h"
 #include "crc/xxhash.h"
+#include "crc/xxh3.h"
 
 static void populate_hdr(struct thread_data *td, struct io_u *io_u,
 			 struct verify_header *hdr, unsigned int header_num,
@@ -99,6 +100,83 @@ static unsigned int get_hdr_inc(struct thread_data *td, struct io_u *io_u)
 	return hdr_inc;
 }
 
+/*
+ * Without the write history, what a verify block holds is a function of
+ * the job's verify seed, the file, the offset and the generation it was
+ * written in. The generation is the loop count, wrapped to a byte so it
+ * fits in the generation map, where zero means never written.
+ */
+static unsigned int verify_cur_gen(struct thread_data *td)
+{
+	return (td->verify_gen - 1) % 255 + 1;
+}
+
+static unsigned int verify_block_gen(struct thread_data *td,
+				     struct fio_file *f, uint64_t offset)
+{
+	uint64_t block;
+
+	/*
+	 * A job that doesn't write has no map to go by, it checks what a
+	 * writer with the same seed left after as many loops
+	 */
+	if (td->o.verify_history != VERIFY_HIST_MAP || !td_write(td))
+		return verify_cur_gen(td);
+
+	block = (offset - f->file_offset) / td->o.verify_interval;
+	if (!f->verify_gen_map || block >= f->verify_gen_blocks)
+		return 0;
+
+	return f->verify_gen_map[block];
+}
+
+static unsigned long verify_block_seed(struct thread_data *td,
+				       struct fio_file *f, uint64_t offset,
+				       unsigned int gen)
+{
+	uint64_t key[3];
+
+	key[0] = td->rand_seeds[FIO_RAND_VER_OFF];
+	key[1] = ((uint64_t) f->fileno << 8) | gen;
+	key[2] = offset;
+
+	return fio_xxh3_64(key, sizeof(key));
+}
+
+/*
+ * Fill each verify block from its own seed. Blocks being written get the
+ * current generation, ones being regenerated for a dump the one they
+ * were written in.
+ */
+static void fill_stateless_headers(struct thread_data *td, struct io_u *io_u,
+				   int written)
+{
+	unsigned int hdr_inc, header_num, gen;
+	struct fio_file *f = io_u->file;
+	uint64_t offset;
+	void *p = io_u->buf;
+
+	if (td->o.verify_pattern_bytes)
+		fill_verify_pattern(td, p, io_u->buflen, io_u, 0, 1);
+
+	hdr_inc = get_hdr_inc(td, io_u);
+	header_num = 0;
+	for (; p < io_u->buf + io_u->buflen; p += hdr_inc) {
+		offset = io_u->offset + (p - io_u->buf);
+		if (written)
+			gen = verify_block_gen(td, f, offset);
+		else
+			gen = verify_cur_gen(td);
+
+		io_u->rand_seed = verify_block_seed(td, f, offset, gen);
+		if (!td->o.verify_pattern_bytes)
+			fill_verify_pattern(td, p, hdr_inc, io_u,
+						io_u->rand_seed, 1);
+		populate_hdr(td, io_u, p, header_num, hdr_inc);
+		header_num++;
+	}
+}
+
 static void fill_pattern_headers(struct thread_data *td, struct io_u *io_u,
 				 unsigned long seed, int use_seed)
 {
@@ -106,6 +184,11 @@ static void fill_pattern_headers(struct thread_data *td, struct io_u *io_u,
 	struct verify_header *hdr;
 	void *p = io_u->buf;
 
+	if (td->o.verify_history != VERIFY_HIST_LOG) {
+		fill_stateless_headers(td, io_u, use_seed);
+		return;
+	}
+
 	fill_verify_pattern(td, p, io_u->buflen, io_u, seed, use_seed);
 
 	hdr_inc = get_hdr_inc(td, io_u);
@@ -176,6 +259,12 @@ static inline unsigned int __hdr_size(int verify_type)
 	case VERIFY_XXHASH:
 		len = sizeof(struct vhdr_xxhash);
 		break;
+	case VERIFY_XXH3:
+		len = sizeof(struct vhdr_xxh3);
+		break;
+	case VERIFY_XXH128:
+		len = sizeof(struct vhdr_xxh128);
+		break;
 	case VERIFY_META:
 		len = sizeof(struct vhdr_meta);
 		break;
@@ -449,6 +538,48 @@ static int verify_io_u_xxhash(struct verify_header *hdr, struct vcont *vc)
 	return EILSEQ;
 }
 
+static int verify_io_u_xxh3(struct verify_header *hdr, struct vcont *vc)
+{
+	void *p = io_u_verify_off(hdr, vc);
+	struct vhdr_xxh3 *vh = hdr_priv(hdr);
+	uint64_t hash;
+
+	dprint(FD_VERIFY, "xxh3 verify io_u %p, len %u\n", vc->io_u, hdr->len);
+
+	hash = fio_xxh3_64(p, hdr->len - hdr_size(hdr));
+
+	if (vh->hash == hash)
+		return 0;
+
+	vc->name = "xxh3";
+	vc->good_crc = &vh->hash;
+	vc->bad_crc = &hash;
+	vc->crc_len = sizeof(hash);
+	log_verify_failure(hdr, vc);
+	return EILSEQ;
+}
+
+static int verify_io_u_xxh128(struct verify_header *hdr, struct vcont *vc)
+{
+	void *p = io_u_verify_off(hdr, vc);
+	struct vhdr_xxh128 *vh = hdr_priv(hdr);
+	uint64_t hash[2];
+
+	dprint(FD_VERIFY, "xxh128 verify io_u %p, len %u\n", vc->io_u, hdr->len);
+
+	fio_xxh128(p, hdr->len - hdr_size(hdr), hash);
+
+	if (!memcmp(vh->hash, hash, sizeof(hash)))
+		return 0;
+
+	vc->name = "xxh128";
+	vc->good_crc = vh->hash;
+	vc->bad_crc = hash;
+	vc->crc_len = sizeof(hash);
+	log_verify_failure(hdr, vc);
+	return EILSEQ;
+}
+
 static int verify_io_u_sha512(struct verify_header *hdr, struct vcont *vc)
 {
 	void *p = io_u_verify_off(hdr, vc);
@@ -478,6 +609,7 @@ static int verify_io_u_sha256(struct verify_header *hdr, struct vcont *vc)
 {
 	void *p = io_u_verify_off(hdr, vc);
 	struct vhdr_sha256 *vh = hdr_priv(hdr);
+	struct io_u *io_u = vc->io_u;
 	uint8_t sha256[64];
 	struct fio_sha256_ctx sha256_ctx = {
 		.buf = sha256,
@@ -485,16 +617,23 @@ static int verify_io_u_sha256(struct verify_header *hdr, struct vcont *vc)
 
 	dprint(FD_VERIFY, "sha256 verify io_u %p, len %u\n", vc->io_u, hdr->len);
 
-	fio_sha256_init(&sha256_ctx);
-	fio_sha256_update(&sha256_ctx, p, hdr->len - hdr_size(hdr));
+	if (io_u->verify_digest && hdr->verify_type == VERIFY_SHA256) {
+		memcpy(sha256, io_u->verify_digest +
+				vc->hdr_num * SHA256_DIGEST_SIZE,
+				SHA256_DIGEST_SIZE);
+	} else {
+		fio_sha256_init(&sha256_ctx);
+		fio_sha256_update(&sha256_ctx, p, hdr->len - hdr_size(hdr));
+		fio_sha256_final(&sha256_ctx);
+	}
 
-	if (!memcmp(vh->sha256, sha256_ctx.buf, sizeof(sha256)))
+	if (!memcmp(vh->sha256, sha256, SHA256_DIGEST_SIZE))
 		return 0;
 
 	vc->name = "sha256";
 	vc->good_crc = vh->sha256;
-	vc->bad_crc = sha256_ctx.buf;
-	vc->crc_len = sizeof(vh->sha256);
+	vc->bad_crc = sha256;
+	vc->crc_len = SHA256_DIGEST_SIZE;
 	log_verify_failure(hdr, vc);
 	return EILSEQ;
 }
@@ -654,12 +793,71 @@ static int verify_io_u_md5(struct verify_header *hdr, struct vcont *vc)
 	return EILSEQ;
 }
 
+/*
+ * One per verify_async thread. The thread completing io_us is the only
+ * producer on each ring. The owner pops its own ring and idle workers
+ * steal from the others, so the consumers share the ring under lock.
+ */
+struct verify_worker {
+	struct io_u_spsc ring;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	volatile int idle;
+
+	struct thread_data *td;
+	pthread_t thread;
+	unsigned int index;
+
+	/*
+	 * Only touched by the worker, folded into td->ts as it exits
+	 */
+	uint64_t bytes;
+	uint64_t usec;
+	struct io_stat wait_stat;
+
+	/*
+	 * sha256 digests of the current batch, see verify_sha256_batch()
+	 */
+	uint8_t *digests;
+	unsigned int digests_nr;
+};
+
+/*
+ * The least loaded worker, starting the scan at the next one round robin
+ * so equally loaded workers take turns
+ */
+static struct verify_worker *verify_pick_worker(struct thread_data *td)
+{
+	unsigned int i, nr = td->o.verify_async, best_nr = -1U;
+	struct verify_worker *best = NULL;
+
+	for (i = 0; i < nr; i++) {
+		struct verify_worker *w;
+		unsigned int queued;
+
+		w = &td->verify_workers[(td->verify_next + i) % nr];
+		queued = io_u_spsc_count(&w->ring);
+		if (queued < best_nr) {
+			best = w;
+			best_nr = queued;
+			if (!queued)
+				break;
+		}
+	}
+
+	if (++td->verify_next == nr)
+		td->verify_next = 0;
+
+	return best;
+}
+
 /*
  * Push IO verification to a separate thread
  */
 int verify_io_u_async(struct thread_data *td, struct io_u **io_u_ptr)
 {
 	struct io_u *io_u = *io_u_ptr;
+	struct verify_worker *w;
 
 	pthread_mutex_lock(&td->io_u_lock);
 
@@ -670,11 +868,25 @@ int verify_io_u_async(struct thread_data *td, struct io_u **io_u_ptr)
 		td->cur_depth--;
 		io_u->flags &= ~IO_U_F_IN_CUR_DEPTH;
 	}
-	flist_add_tail(&io_u->verify_list, &td->verify_list);
-	*io_u_ptr = NULL;
 	pthread_mutex_unlock(&td->io_u_lock);
 
-	pthread_cond_signal(&td->verify_cond);
+	fio_gettime(&io_u->verify_time, NULL);
+
+	w = verify_pick_worker(td);
+	io_u_spsc_push(&w->ring, io_u);
+	*io_u_ptr = NULL;
+
+	/*
+	 * Pairs with verify_worker_wait(), either the idle worker sees the
+	 * io_u or we see it idle and wake it up
+	 */
+	__sync_synchronize();
+	if (w->idle) {
+		pthread_mutex_lock(&w->lock);
+		pthread_cond_signal(&w->cond);
+		pthread_mutex_unlock(&w->lock);
+	}
+
 	return 0;
 }
 
@@ -793,11 +1005,27 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 		hdr = p;
 
 		/*
-		 * Make rand_seed check pass when have verifysort or
-		 * verify_backlog.
+		 * Without a write history the seed follows from where the
+		 * block is. Blocks the generation map says were never
+		 * written have nothing to check.
 		 */
-		if (td->o.verifysort || (td->flags & TD_F_VER_BACKLOG))
+		if (td->o.verify_history != VERIFY_HIST_LOG) {
+			uint64_t offset = io_u->offset + (p - io_u->buf);
+			unsigned int gen;
+
+			gen = verify_block_gen(td, io_u->file, offset);
+			if (!gen)
+				continue;
+
+			io_u->rand_seed = verify_block_seed(td, io_u->file,
+								offset, gen);
+		} else if (td->o.verifysort || (td->flags & TD_F_VER_BACKLOG)) {
+			/*
+			 * Make rand_seed check pass when have verifysort or
+			 * verify_backlog.
+			 */
 			io_u->rand_seed = hdr->rand_seed;
+		}
 
 		ret = verify_header(io_u, hdr, hdr_num, hdr_inc);
 		if (ret)
@@ -837,6 +1065,12 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 		case VERIFY_XXHASH:
 			ret = verify_io_u_xxhash(hdr, &vc);
 			break;
+		case VERIFY_XXH3:
+			ret = verify_io_u_xxh3(hdr, &vc);
+			break;
+		case VERIFY_XXH128:
+			ret = verify_io_u_xxh128(hdr, &vc);
+			break;
 		case VERIFY_META:
 			ret = verify_io_u_meta(hdr, &vc);
 			break;
@@ -888,6 +1122,20 @@ static void fill_xxhash(struct verify_header *hdr, void *p, unsigned int len)
 	vh->hash = XXH32_digest(state);
 }
 
+static void fill_xxh3(struct verify_header *hdr, void *p, unsigned int len)
+{
+	struct vhdr_xxh3 *vh = hdr_priv(hdr);
+
+	vh->hash = fio_xxh3_64(p, len);
+}
+
+static void fill_xxh128(struct verify_header *hdr, void *p, unsigned int len)
+{
+	struct vhdr_xxh128 *vh = hdr_priv(hdr);
+
+	fio_xxh128(p, len, vh->hash);
+}
+
 static void fill_sha512(struct verify_header *hdr, void *p, unsigned int len)
 {
 	struct vhdr_sha512 *vh = hdr_priv(hdr);
@@ -908,6 +1156,7 @@ static void fill_sha256(struct verify_header *hdr, void *p, unsigned int len)
 
 	fio_sha256_init(&sha256_ctx);
 	fio_sha256_update(&sha256_ctx, p, len);
+	fio_sha256_final(&sha256_ctx);
 }
 
 static void fill_sha1(struct verify_header *hdr, void *p, unsigned int len)
@@ -1032,6 +1281,16 @@ static void populate_hdr(struct thread_data *td, struct io_u *io_u,
 						io_u, hdr->len);
 		fill_xxhash(hdr, data, data_len);
 		break;
+	case VERIFY_XXH3:
+		dprint(FD_VERIFY, "fill xxh3 io_u %p, len %u\n",
+						io_u, hdr->len);
+		fill_xxh3(hdr, data, data_len);
+		break;
+	case VERIFY_XXH128:
+		dprint(FD_VERIFY, "fill xxh128 io_u %p, len %u\n",
+						io_u, hdr->len);
+		fill_xxh128(hdr, data, data_len);
+		break;
 	case VERIFY_META:
 		dprint(FD_VERIFY, "fill meta io_u %p, len %u\n",
 						io_u, hdr->len);
@@ -1067,6 +1326,92 @@ void populate_verify_io_u(struct thread_data *td, struct io_u *io_u)
 	fill_pattern_headers(td, io_u, 0, 0);
 }
 
+/*
+ * Record the generation of the blocks a write covers
+ */
+void verify_log_write(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	uint64_t block, nr;
+
+	if (td->o.verify_history != VERIFY_HIST_MAP || !f->verify_gen_map)
+		return;
+
+	block = (io_u->offset - f->file_offset) / td->o.verify_interval;
+	nr = io_u->buflen / td->o.verify_interval;
+	if (block >= f->verify_gen_blocks)
+		return;
+	if (block + nr > f->verify_gen_blocks)
+		nr = f->verify_gen_blocks - block;
+
+	memset(&f->verify_gen_map[block], verify_cur_gen(td), nr);
+}
+
+/*
+ * Without a write history, read the files back in order, up to a
+ * maximum sized write at a time. With the generation map, blocks that
+ * were never written are skipped.
+ */
+static int get_next_verify_sweep(struct thread_data *td, struct io_u *io_u)
+{
+	unsigned int unit = td->o.verify_interval;
+	unsigned int max_blocks = td->o.max_bs[DDIR_WRITE] / unit;
+	struct fio_file *f;
+	uint8_t *map;
+	uint64_t block, end, nr;
+
+	while (td->verify_sweep_file < td->o.nr_files) {
+		f = td->files[td->verify_sweep_file];
+		map = f->verify_gen_map;
+		nr = f->io_size / unit;
+		if (map && nr > f->verify_gen_blocks)
+			nr = f->verify_gen_blocks;
+
+		block = td->verify_sweep_block;
+		while (map && block < nr && !map[block])
+			block++;
+
+		if (block >= nr) {
+			td->verify_sweep_file++;
+			td->verify_sweep_block = 0;
+			continue;
+		}
+
+		end = block + 1;
+		while (end < nr && end - block < max_blocks &&
+		       (!map || map[end]))
+			end++;
+		td->verify_sweep_block = end;
+
+		io_u->offset = f->file_offset + block * unit;
+		io_u->buflen = (end - block) * unit;
+		io_u->file = f;
+		io_u->flags |= IO_U_F_VER_LIST;
+
+		if (!fio_file_open(f)) {
+			int r = td_io_open_file(td, f);
+
+			if (r) {
+				dprint(FD_VERIFY, "failed file %s open\n",
+						f->file_name);
+				io_u->file = NULL;
+				return 1;
+			}
+		}
+
+		get_file(f);
+		assert(fio_file_open(io_u->file));
+		io_u->ddir = DDIR_READ;
+		io_u->xfer_buf = io_u->buf;
+		io_u->xfer_buflen = io_u->buflen;
+		dprint(FD_VERIFY, "get_next_verify: sweep io_u %p\n", io_u);
+		return 0;
+	}
+
+	dprint(FD_VERIFY, "get_next_verify: sweep done\n");
+	return 1;
+}
+
 int get_next_verify(struct thread_data *td, struct io_u *io_u)
 {
 	struct io_piece *ipo = NULL;
@@ -1077,6 +1422,9 @@ int get_next_verify(struct thread_data *td, struct io_u *io_u)
 	if (io_u->file)
 		return 0;
 
+	if (td->o.verify_history != VERIFY_HIST_LOG)
+		return get_next_verify_sweep(td, io_u);
+
 	if (!RB_EMPTY_ROOT(&td->io_hist_tree)) {
 		struct rb_node *n = rb_first(&td->io_hist_tree);
 
@@ -1152,67 +1500,252 @@ nothing:
 	return 1;
 }
 
-void fio_verify_init(struct thread_data *td)
+int fio_verify_init(struct thread_data *td)
 {
+	struct fio_file *f;
+	unsigned int i;
+
 	if (td->o.verify == VERIFY_CRC32C_INTEL ||
 	    td->o.verify == VERIFY_CRC32C) {
 		crc32c_intel_probe();
 	}
+
+	if (td->o.verify == VERIFY_NONE ||
+	    td->o.verify_history != VERIFY_HIST_MAP || !td_write(td))
+		return 0;
+
+	for_each_file(td, f, i) {
+		f->verify_gen_blocks = f->io_size / td->o.verify_interval;
+		f->verify_gen_map = calloc(f->verify_gen_blocks, 1);
+		if (!f->verify_gen_map && f->verify_gen_blocks) {
+			log_err("fio: failed allocating verify generation map"
+				" for %s\n", f->file_name);
+			return 1;
+		}
+	}
+
+	return 0;
 }
 
-static void *verify_async_thread(void *data)
+/*
+ * How many io_us a verify thread takes off a ring at once
+ */
+#define VERIFY_ASYNC_BATCH	16
+
+static unsigned int verify_pop(struct verify_worker *w, struct io_u **io_us,
+			       unsigned int max)
 {
-	struct thread_data *td = data;
-	struct io_u *io_u;
-	int ret = 0;
+	unsigned int nr;
 
-	if (td->o.verify_cpumask_set &&
-	    fio_setaffinity(td->pid, td->o.verify_cpumask)) {
-		log_err("fio: failed setting verify thread affinity\n");
-		goto done;
+	pthread_mutex_lock(&w->lock);
+	nr = io_u_spsc_pop_batch(&w->ring, io_us, max);
+	pthread_mutex_unlock(&w->lock);
+
+	return nr;
+}
+
+/*
+ * Our ring is empty, take half of what another worker has queued. Skip
+ * the ones whose owner or another thief is popping right now.
+ */
+static unsigned int verify_steal(struct verify_worker *w, struct io_u **io_us)
+{
+	struct thread_data *td = w->td;
+	unsigned int i, nr = td->o.verify_async;
+
+	for (i = 1; i < nr; i++) {
+		struct verify_worker *v = &td->verify_workers[(w->index + i) % nr];
+		unsigned int queued, got;
+
+		queued = io_u_spsc_count(&v->ring);
+		if (!queued || pthread_mutex_trylock(&v->lock))
+			continue;
+
+		got = io_u_spsc_pop_batch(&v->ring, io_us,
+				min((queued + 1) / 2,
+				    (unsigned int) VERIFY_ASYNC_BATCH));
+		pthread_mutex_unlock(&v->lock);
+
+		if (got)
+			return got;
 	}
 
-	do {
-		FLIST_HEAD(list);
+	return 0;
+}
 
-		read_barrier();
-		if (td->verify_thread_exit)
+/*
+ * Sleep until something is queued for us. Returns 0 when we should exit.
+ */
+static int verify_worker_wait(struct verify_worker *w)
+{
+	struct thread_data *td = w->td;
+	int ret = 0;
+
+	pthread_mutex_lock(&w->lock);
+
+	w->idle = 1;
+	__sync_synchronize();
+	while (io_u_spsc_empty(&w->ring) && !td->verify_thread_exit) {
+		ret = pthread_cond_wait(&w->cond, &w->lock);
+		if (ret)
 			break;
+	}
+	w->idle = 0;
 
-		pthread_mutex_lock(&td->io_u_lock);
+	pthread_mutex_unlock(&w->lock);
 
-		while (flist_empty(&td->verify_list) &&
-		       !td->verify_thread_exit) {
-			ret = pthread_cond_wait(&td->verify_cond,
-							&td->io_u_lock);
-			if (ret) {
-				pthread_mutex_unlock(&td->io_u_lock);
-				break;
+	return !ret && !(td->verify_thread_exit && io_u_spsc_empty(&w->ring));
+}
+
+#define VERIFY_HASH_BATCH	16
+
+/*
+ * Whether all the blocks of an io_u can be hashed before verify_io_u()
+ * has looked at their headers. It checks the length of each against the
+ * increment, so a bad header can't make us use the wrong digest.
+ */
+static unsigned int verify_sha256_blocks(struct thread_data *td,
+					 struct io_u *io_u)
+{
+	unsigned int hdr_inc = get_hdr_inc(td, io_u);
+
+	if (io_u->ddir != DDIR_READ || (io_u->flags & IO_U_F_TRIMMED))
+		return 0;
+	if (hdr_inc <= __hdr_size(VERIFY_SHA256) || io_u->buflen % hdr_inc)
+		return 0;
+
+	return io_u->buflen / hdr_inc;
+}
+
+/*
+ * With a multi-buffer sha256, hash every block of the batch up front, a
+ * number of them at a time. verify_io_u_sha256() then only compares.
+ */
+static void verify_sha256_batch(struct verify_worker *w, struct io_u **io_us,
+				unsigned int nr)
+{
+	struct thread_data *td = w->td;
+	unsigned int header_size = __hdr_size(VERIFY_SHA256);
+	const uint8_t *data[VERIFY_HASH_BATCH];
+	unsigned int len[VERIFY_HASH_BATCH];
+	uint8_t *digest[VERIFY_HASH_BATCH];
+	unsigned int i, j, total = 0, n = 0;
+	uint8_t *next;
+
+	if (td->o.verify_offset || (td->io_ops->flags & FIO_FAKEIO))
+		return;
+
+	for (i = 0; i < nr; i++)
+		total += verify_sha256_blocks(td, io_us[i]);
+	if (total < 2)
+		return;
+
+	if (total > w->digests_nr) {
+		free(w->digests);
+		w->digests = malloc(total * SHA256_DIGEST_SIZE);
+		if (!w->digests) {
+			w->digests_nr = 0;
+			return;
+		}
+		w->digests_nr = total;
+	}
+
+	next = w->digests;
+	for (i = 0; i < nr; i++) {
+		struct io_u *io_u = io_us[i];
+		unsigned int blocks = verify_sha256_blocks(td, io_u);
+		unsigned int hdr_inc = get_hdr_inc(td, io_u);
+
+		if (!blocks)
+			continue;
+
+		io_u->verify_digest = next;
+		for (j = 0; j < blocks; j++) {
+			data[n] = io_u->buf + j * hdr_inc + header_size;
+			len[n] = hdr_inc - header_size;
+			digest[n] = next;
+			next += SHA256_DIGEST_SIZE;
+
+			if (++n == VERIFY_HASH_BATCH) {
+				fio_sha256_multi(data, len, digest, n);
+				n = 0;
 			}
 		}
+	}
+
+	if (n)
+		fio_sha256_multi(data, len, digest, n);
+}
+
+/*
+ * Verify a batch and hand the io_us back in one go
+ */
+static int verify_batch(struct verify_worker *w, struct io_u **io_us,
+			unsigned int nr)
+{
+	struct thread_data *td = w->td;
+	struct timeval start, end;
+	unsigned int i;
+	int ret = 0;
+
+	fio_gettime(&start, NULL);
+
+	if (td->o.verify == VERIFY_SHA256 && fio_sha256_lanes() > 1)
+		verify_sha256_batch(w, io_us, nr);
+
+	for (i = 0; i < nr; i++) {
+		struct io_u *io_u = io_us[i];
+		int err;
 
-		flist_splice_init(&td->verify_list, &list);
-		pthread_mutex_unlock(&td->io_u_lock);
+		add_verify_wait_sample(&w->wait_stat,
+					utime_since(&io_u->verify_time, &start));
+		w->bytes += io_u->buflen;
 
-		if (flist_empty(&list))
+		io_u->flags |= IO_U_F_NO_FILE_PUT;
+		err = verify_io_u(td, &io_u);
+		io_u->verify_digest = NULL;
+		if (!err || ret)
 			continue;
+		if (td_non_fatal_error(td, ERROR_TYPE_VERIFY_BIT, err)) {
+			update_error_count(td, err);
+			td_clear_error(td);
+		} else
+			ret = err;
+	}
 
-		while (!flist_empty(&list)) {
-			io_u = flist_first_entry(&list, struct io_u, verify_list);
-			flist_del_init(&io_u->verify_list);
+	put_io_u_batch(td, io_us, nr);
 
-			io_u->flags |= IO_U_F_NO_FILE_PUT;
-			ret = verify_io_u(td, &io_u);
+	fio_gettime(&end, NULL);
+	w->usec += utime_since(&start, &end);
+	return ret;
+}
 
-			put_io_u(td, io_u);
-			if (!ret)
-				continue;
-			if (td_non_fatal_error(td, ERROR_TYPE_VERIFY_BIT, ret)) {
-				update_error_count(td, ret);
-				td_clear_error(td);
-				ret = 0;
-			}
+static void *verify_async_thread(void *data)
+{
+	struct verify_worker *w = data;
+	struct thread_data *td = w->td;
+	int ret = 0;
+
+	if (td->o.verify_cpumask_set &&
+	    fio_setaffinity(td->pid, td->o.verify_cpumask)) {
+		log_err("fio: failed setting verify thread affinity\n");
+		goto done;
+	}
+
+	do {
+		struct io_u *io_us[VERIFY_ASYNC_BATCH];
+		unsigned int nr;
+
+		nr = verify_pop(w, io_us, VERIFY_ASYNC_BATCH);
+		if (!nr)
+			nr = verify_steal(w, io_us);
+		if (!nr) {
+			if (!verify_worker_wait(w))
+				break;
+			continue;
 		}
+
+		ret = verify_batch(w, io_us, nr);
 	} while (!ret);
 
 	if (ret) {
@@ -1223,6 +1756,7 @@ static void *verify_async_thread(void *data)
 
 done:
 	pthread_mutex_lock(&td->io_u_lock);
+	add_verify_async_stats(td, w->bytes, w->usec, &w->wait_stat);
 	td->nr_verify_threads--;
 	pthread_mutex_unlock(&td->io_u_lock);
 
@@ -1230,26 +1764,85 @@ done:
 	return NULL;
 }
 
+static void verify_workers_stop(struct thread_data *td, unsigned int nr)
+{
+	unsigned int i;
+
+	td->verify_thread_exit = 1;
+	write_barrier();
+
+	for (i = 0; i < nr; i++) {
+		struct verify_worker *w = &td->verify_workers[i];
+
+		pthread_mutex_lock(&w->lock);
+		pthread_cond_signal(&w->cond);
+		pthread_mutex_unlock(&w->lock);
+	}
+}
+
+static void verify_workers_free(struct thread_data *td, unsigned int nr)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		struct verify_worker *w = &td->verify_workers[i];
+
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->lock);
+		io_u_spsc_exit(&w->ring);
+		free(w->digests);
+	}
+
+	free(td->verify_workers);
+	td->verify_workers = NULL;
+}
+
 int verify_async_init(struct thread_data *td)
 {
-	int i, ret;
+	unsigned int i, nr = td->o.verify_async;
 	pthread_attr_t attr;
+	int ret;
+
+	td->verify_workers = calloc(nr, sizeof(struct verify_worker));
+	if (!td->verify_workers) {
+		log_err("fio: failed allocating async verify workers\n");
+		return 1;
+	}
+
+	/*
+	 * Any one ring may end up holding everything in flight
+	 */
+	for (i = 0; i < nr; i++) {
+		struct verify_worker *w = &td->verify_workers[i];
+
+		if (io_u_spsc_init(&w->ring, td->o.iodepth)) {
+			log_err("fio: failed allocating async verify ring\n");
+			verify_workers_free(td, i);
+			return 1;
+		}
+		pthread_mutex_init(&w->lock, NULL);
+		pthread_cond_init(&w->cond, NULL);
+		w->td = td;
+		w->index = i;
+		w->wait_stat.min_val = ULONG_MAX;
+	}
 
 	pthread_attr_init(&attr);
 	pthread_attr_setstacksize(&attr, PTHREAD_STACK_MIN);
 
 	td->verify_thread_exit = 0;
+	td->verify_next = 0;
 
-	td->verify_threads = malloc(sizeof(pthread_t) * td->o.verify_async);
-	for (i = 0; i < td->o.verify_async; i++) {
-		ret = pthread_create(&td->verify_threads[i], &attr,
-					verify_async_thread, td);
+	for (i = 0; i < nr; i++) {
+		struct verify_worker *w = &td->verify_workers[i];
+
+		ret = pthread_create(&w->thread, &attr, verify_async_thread, w);
 		if (ret) {
 			log_err("fio: async verify creation failed: %s\n",
 					strerror(ret));
 			break;
 		}
-		ret = pthread_detach(td->verify_threads[i]);
+		ret = pthread_detach(w->thread);
 		if (ret) {
 			log_err("fio: async verify thread detach failed: %s\n",
 					strerror(ret));
@@ -1260,22 +1853,24 @@ int verify_async_init(struct thread_data *td)
 
 	pthread_attr_destroy(&attr);
 
-	if (i != td->o.verify_async) {
+	if (i != nr) {
 		log_err("fio: only %d verify threads started, exiting\n", i);
-		td->verify_thread_exit = 1;
-		write_barrier();
-		pthread_cond_broadcast(&td->verify_cond);
+		verify_async_exit(td);
 		return 1;
 	}
 
 	return 0;
 }
 
+/*
+ * The workers drain their rings before they exit
+ */
 void verify_async_exit(struct thread_data *td)
 {
-	td->verify_thread_exit = 1;
-	write_barrier();
-	pthread_cond_broadcast(&td->verify_cond);
+	if (!td->verify_workers)
+		return;
+
+	verify_workers_stop(td, td->o.verify_async);
 
 	pthread_mutex_lock(&td->io_u_lock);
 
@@ -1283,6 +1878,6 @@ void verify_async_exit(struct thread_data *td)
 		pthread_cond_wait(&td->free_cond, &td->io_u_lock);
 
 	pthread_mutex_unlock(&td->io_u_lock);
-	free(td->verify_threads);
-	td->verify_threads = NULL;
+
+	verify_workers_free(td, td->o.verify_async);
 }
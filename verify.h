@@ -21,6 +21,17 @@ enum {
 	VERIFY_SHA1,			/* sha1 sum data blocks */
 	VERIFY_PATTERN,			/* verify specific patterns */
 	VERIFY_NULL,			/* pretend to verify */
+	VERIFY_XXH3,			/* xxh3 64-bit sum data blocks */
+	VERIFY_XXH128,			/* xxh3 128-bit sum data blocks */
+};
+
+/*
+ * What is kept about the writes, for the verify pass to know what to read
+ */
+enum {
+	VERIFY_HIST_LOG = 0,		/* an io piece per write */
+	VERIFY_HIST_LOOP,		/* nothing, all blocks written each loop */
+	VERIFY_HIST_MAP,		/* a generation byte per block */
 };
 
 /*
@@ -70,6 +81,12 @@ struct vhdr_meta {
 struct vhdr_xxhash {
 	uint32_t hash;
 };
+struct vhdr_xxh3 {
+	uint64_t hash;
+};
+struct vhdr_xxh128 {
+	uint64_t hash[2];
+};
 
 /*
  * Verify helpers
@@ -80,7 +97,8 @@ extern int __must_check verify_io_u(struct thread_data *, struct io_u **);
 extern int verify_io_u_async(struct thread_data *, struct io_u **);
 extern void fill_verify_pattern(struct thread_data *td, void *p, unsigned int len, struct io_u *io_u, unsigned long seed, int use_seed);
 extern void fill_buffer_pattern(struct thread_data *td, void *p, unsigned int len);
-extern void fio_verify_init(struct thread_data *td);
+extern int fio_verify_init(struct thread_data *td);
+extern void verify_log_write(struct thread_data *, struct io_u *);
 
 /*
  * Async verify offload
@@ -0,0 +1,642 @@
+/*
+ * Zoned block device support
+ *
+ * With zonemode=zbd every file is handled as a set of zones. Zones of a
+ * host managed or host aware block device are reported by the kernel,
+ * anything else is divided into zones of zonesize bytes that fio
+ * emulates. Writes to a sequential write required zone are moved to the
+ * zone write pointer, a full zone is reset when a write lands in it
+ * again, and no more than max_open_zones zones are written at a time.
+ * Reads beyond the write pointer are moved to data that was written.
+ *
+ * With zone_append, writes only pick a zone when they are generated and
+ * are placed at its write pointer in the order they are issued, so any
+ * number of them can be in flight to the same zone. Their offsets are
+ * logged for verification once they complete.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <assert.h>
+#include <libgen.h>
+#include <sys/ioctl.h>
+
+#include "fio.h"
+#include "verify.h"
+#include "zbd.h"
+
+#ifdef CONFIG_LINUX_BLKZONED
+#include <linux/blkzoned.h>
+#endif
+
+#define ZBD_REPORT_ZONES	128
+
+static int zbd_read_sysfs(struct fio_file *f, const char *attr, char *buf,
+			  size_t len)
+{
+	char path[PATH_MAX], *name, *dev;
+	FILE *fp;
+	int ret = 1;
+
+	dev = strdup(f->file_name);
+	name = basename(dev);
+	snprintf(path, sizeof(path), "/sys/block/%s/queue/%s", name, attr);
+	free(dev);
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return 1;
+
+	if (fgets(buf, len, fp))
+		ret = 0;
+
+	fclose(fp);
+	return ret;
+}
+
+static enum fio_zbd_model zbd_get_model(struct fio_file *f)
+{
+	char buf[64];
+
+	if (f->filetype != FIO_TYPE_BD)
+		return ZBD_MODEL_NONE;
+	if (zbd_read_sysfs(f, "zoned", buf, sizeof(buf)))
+		return ZBD_MODEL_NONE;
+
+	if (!strncmp(buf, "host-managed", 12))
+		return ZBD_MODEL_HOST_MANAGED;
+	if (!strncmp(buf, "host-aware", 10))
+		return ZBD_MODEL_HOST_AWARE;
+
+	return ZBD_MODEL_NONE;
+}
+
+static struct zoned_block_device_info *zbd_alloc(uint32_t nr_zones)
+{
+	struct zoned_block_device_info *zbd;
+
+	zbd = calloc(1, sizeof(*zbd) + nr_zones * sizeof(struct fio_zone_info));
+	if (!zbd)
+		return NULL;
+
+	zbd->open_zones = calloc(nr_zones, sizeof(uint32_t));
+	if (!zbd->open_zones) {
+		free(zbd);
+		return NULL;
+	}
+
+	zbd->nr_zones = nr_zones;
+	return zbd;
+}
+
+void zbd_free_zone_info(struct fio_file *f)
+{
+	if (!f->zbd_info)
+		return;
+
+	free(f->zbd_info->open_zones);
+	free(f->zbd_info);
+	f->zbd_info = NULL;
+}
+
+/*
+ * Emulated zones start out holding whatever the file holds
+ */
+static void zbd_init_emulated(struct fio_file *f,
+			      struct zoned_block_device_info *zbd)
+{
+	uint32_t i;
+
+	for (i = 0; i < zbd->nr_zones; i++) {
+		struct fio_zone_info *z = &zbd->zone_info[i];
+
+		z->start = (uint64_t) (zbd->first_zone + i) * zbd->zone_size;
+		z->capacity = zbd->zone_size;
+		z->type = ZBD_ZONE_TYPE_SWR;
+		if (f->real_file_size >= z->start + z->capacity)
+			z->wp = z->start + z->capacity;
+		else if (f->real_file_size > z->start)
+			z->wp = f->real_file_size;
+		else
+			z->wp = z->start;
+		z->reserved = z->wp;
+	}
+}
+
+#ifdef CONFIG_LINUX_BLKZONED
+static int zbd_get_zone_size(struct thread_data *td, struct fio_file *f,
+			     uint64_t *zone_size)
+{
+	uint32_t sectors;
+	int fd, ret = 0;
+
+	fd = open(f->file_name, O_RDONLY);
+	if (fd < 0) {
+		td_verror(td, errno, "open");
+		return 1;
+	}
+
+	if (ioctl(fd, BLKGETZONESZ, &sectors) < 0 || !sectors) {
+		td_verror(td, errno, "BLKGETZONESZ");
+		ret = 1;
+	} else
+		*zone_size = (uint64_t) sectors << 9;
+
+	close(fd);
+	return ret;
+}
+
+static int zbd_report_zones(struct thread_data *td, struct fio_file *f,
+			    struct zoned_block_device_info *zbd)
+{
+	struct blk_zone_report *rep;
+	uint64_t sector;
+	uint32_t i, nr = 0;
+	int fd, ret = 0;
+
+	fd = open(f->file_name, O_RDONLY);
+	if (fd < 0) {
+		td_verror(td, errno, "open");
+		return 1;
+	}
+
+	rep = malloc(sizeof(*rep) + ZBD_REPORT_ZONES * sizeof(struct blk_zone));
+	sector = ((uint64_t) zbd->first_zone * zbd->zone_size) >> 9;
+
+	while (nr < zbd->nr_zones) {
+		memset(rep, 0, sizeof(*rep));
+		rep->sector = sector;
+		rep->nr_zones = ZBD_REPORT_ZONES;
+
+		if (ioctl(fd, BLKREPORTZONE, rep) < 0) {
+			td_verror(td, errno, "BLKREPORTZONE");
+			ret = 1;
+			break;
+		}
+		if (!rep->nr_zones) {
+			log_err("fio: %s: short zone report\n", f->file_name);
+			ret = 1;
+			break;
+		}
+
+		for (i = 0; i < rep->nr_zones && nr < zbd->nr_zones; i++) {
+			struct blk_zone *bz = &rep->zones[i];
+			struct fio_zone_info *z = &zbd->zone_info[nr++];
+
+			z->start = bz->start << 9;
+			if (rep->flags & BLK_ZONE_REP_CAPACITY)
+				z->capacity = bz->capacity << 9;
+			else
+				z->capacity = bz->len << 9;
+
+			if (bz->type == BLK_ZONE_TYPE_CONVENTIONAL)
+				z->type = ZBD_ZONE_TYPE_CNV;
+			else
+				z->type = ZBD_ZONE_TYPE_SWR;
+
+			switch (bz->cond) {
+			case BLK_ZONE_COND_NOT_WP:
+			case BLK_ZONE_COND_FULL:
+			case BLK_ZONE_COND_READONLY:
+			case BLK_ZONE_COND_OFFLINE:
+				z->wp = z->start + z->capacity;
+				break;
+			default:
+				z->wp = bz->wp << 9;
+				break;
+			}
+			z->reserved = z->wp;
+
+			sector = bz->start + bz->len;
+		}
+	}
+
+	free(rep);
+	close(fd);
+	return ret;
+}
+
+static int zbd_reset_range(struct thread_data *td, struct fio_file *f,
+			   uint64_t start, uint64_t len)
+{
+	struct blk_zone_range range = {
+		.sector		= start >> 9,
+		.nr_sectors	= len >> 9,
+	};
+
+	if (ioctl(f->fd, BLKRESETZONE, &range) < 0) {
+		td_verror(td, errno, "BLKRESETZONE");
+		return 1;
+	}
+
+	return 0;
+}
+#else
+static int zbd_get_zone_size(struct thread_data *td, struct fio_file *f,
+			     uint64_t *zone_size)
+{
+	log_err("fio: %s: zoned block devices not supported\n", f->file_name);
+	return 1;
+}
+
+static int zbd_report_zones(struct thread_data *td, struct fio_file *f,
+			    struct zoned_block_device_info *zbd)
+{
+	return 1;
+}
+
+static int zbd_reset_range(struct thread_data *td, struct fio_file *f,
+			   uint64_t start, uint64_t len)
+{
+	return 1;
+}
+#endif
+
+static uint32_t zbd_max_open_zones(struct thread_data *td, struct fio_file *f,
+				   struct zoned_block_device_info *zbd)
+{
+	unsigned int max_open = td->o.max_open_zones;
+	unsigned long dev_max;
+	char buf[64];
+
+	if (zbd->model != ZBD_MODEL_NONE &&
+	    !zbd_read_sysfs(f, "max_open_zones", buf, sizeof(buf))) {
+		dev_max = strtoul(buf, NULL, 10);
+		if (dev_max && (!max_open || dev_max < max_open))
+			max_open = dev_max;
+	}
+
+	if (!max_open || max_open > zbd->nr_zones)
+		max_open = zbd->nr_zones;
+
+	return max_open;
+}
+
+static int zbd_init_file(struct thread_data *td, struct fio_file *f)
+{
+	struct zoned_block_device_info *zbd;
+	enum fio_zbd_model model;
+	uint64_t zone_size;
+	uint32_t nr_zones;
+
+	model = zbd_get_model(f);
+	if (model != ZBD_MODEL_NONE) {
+		if (zbd_get_zone_size(td, f, &zone_size))
+			return 1;
+		if (td->o.zone_size && td->o.zone_size != zone_size) {
+			log_err("fio: %s: zonesize %llu does not match the"
+				" device zone size %llu\n", f->file_name,
+				(unsigned long long) td->o.zone_size,
+				(unsigned long long) zone_size);
+			return 1;
+		}
+	} else {
+		zone_size = td->o.zone_size;
+		if (!zone_size) {
+			log_err("fio: %s is not a zoned block device, set"
+				" zonesize to emulate zones\n", f->file_name);
+			return 1;
+		}
+	}
+
+	if (f->file_offset % zone_size) {
+		log_err("fio: %s: offset must be a multiple of the zone size"
+			" %llu\n", f->file_name, (unsigned long long) zone_size);
+		return 1;
+	}
+	if (td_max_bs(td) > zone_size) {
+		log_err("fio: %s: block size larger than the zone size\n",
+				f->file_name);
+		return 1;
+	}
+
+	nr_zones = f->io_size / zone_size;
+	if (!nr_zones) {
+		log_err("fio: %s: size is smaller than a zone\n", f->file_name);
+		return 1;
+	}
+	if (f->io_size % zone_size) {
+		log_info("fio: %s: size rounded down to %u zones\n",
+				f->file_name, nr_zones);
+		f->io_size = (uint64_t) nr_zones * zone_size;
+	}
+
+	zbd = zbd_alloc(nr_zones);
+	if (!zbd) {
+		log_err("fio: %s: failed allocating zone info\n", f->file_name);
+		return 1;
+	}
+
+	zbd->model = model;
+	zbd->zone_size = zone_size;
+	zbd->first_zone = f->file_offset / zone_size;
+
+	if (model == ZBD_MODEL_NONE)
+		zbd_init_emulated(f, zbd);
+	else if (zbd_report_zones(td, f, zbd)) {
+		free(zbd->open_zones);
+		free(zbd);
+		return 1;
+	}
+
+	zbd->max_open_zones = zbd_max_open_zones(td, f, zbd);
+	f->zbd_info = zbd;
+
+	dprint(FD_FILE, "zbd: %s, %u zones of %llu bytes from zone %u,"
+			" max %u open\n", f->file_name, zbd->nr_zones,
+			(unsigned long long) zbd->zone_size, zbd->first_zone,
+			zbd->max_open_zones);
+	return 0;
+}
+
+/*
+ * Called at the end of file setup, once the file sizes are known.
+ */
+int zbd_init(struct thread_data *td)
+{
+	struct fio_file *f;
+	unsigned int i;
+
+	for_each_file(td, f, i) {
+		if (f->zbd_info)
+			continue;
+		if (zbd_init_file(td, f))
+			return 1;
+	}
+
+	return 0;
+}
+
+static int zbd_open_zone(struct zoned_block_device_info *zbd, uint32_t idx)
+{
+	struct fio_zone_info *z = &zbd->zone_info[idx];
+
+	if (z->open)
+		return 1;
+	if (zbd->nr_open_zones >= zbd->max_open_zones)
+		return 0;
+
+	z->open = 1;
+	zbd->open_zones[zbd->nr_open_zones++] = idx;
+	return 1;
+}
+
+static void zbd_close_zone(struct zoned_block_device_info *zbd, uint32_t idx)
+{
+	uint32_t i;
+
+	for (i = 0; i < zbd->nr_open_zones; i++) {
+		if (zbd->open_zones[i] != idx)
+			continue;
+
+		zbd->open_zones[i] = zbd->open_zones[--zbd->nr_open_zones];
+		zbd->zone_info[idx].open = 0;
+		break;
+	}
+}
+
+static int zbd_reset_zone(struct thread_data *td, struct fio_file *f,
+			  struct fio_zone_info *z)
+{
+	struct zoned_block_device_info *zbd = f->zbd_info;
+	struct timeval start;
+
+	fio_gettime(&start, NULL);
+
+	if (zbd->model != ZBD_MODEL_NONE &&
+	    zbd_reset_range(td, f, z->start, zbd->zone_size))
+		return 1;
+
+	/*
+	 * What was logged for verification in this zone is gone now
+	 */
+	if (td->o.do_verify && td->o.verify != VERIFY_NONE)
+		unlog_io_pieces(td, f, z->start, zbd->zone_size);
+
+	z->wp = z->reserved = z->start;
+	add_zone_reset_sample(td, utime_since_now(&start));
+	return 0;
+}
+
+static int zbd_zone_full(struct fio_zone_info *z, unsigned int min_bs)
+{
+	return z->reserved + min_bs > z->start + z->capacity;
+}
+
+/*
+ * A full zone can't be reset while writes to it are still in flight
+ */
+static int zbd_zone_busy(struct fio_zone_info *z, unsigned int min_bs)
+{
+	return z->pending && zbd_zone_full(z, min_bs);
+}
+
+/*
+ * Pick the zone a write to zone idx goes to: that zone if it is or can
+ * be opened, else one of the open zones. Returns nr_zones if no zone can
+ * take the write.
+ */
+static uint32_t zbd_pick_zone(struct zoned_block_device_info *zbd,
+			      uint32_t idx, unsigned int min_bs)
+{
+	uint32_t i;
+
+	if (zbd->zone_info[idx].open)
+		return idx;
+	if (!zbd_zone_busy(&zbd->zone_info[idx], min_bs) &&
+	    zbd_open_zone(zbd, idx))
+		return idx;
+
+	/*
+	 * At the open zone limit, write to one of the open zones
+	 */
+	if (zbd->nr_open_zones)
+		return zbd->open_zones[zbd->open_rr++ % zbd->nr_open_zones];
+
+	for (i = 1; i < zbd->nr_zones; i++) {
+		uint32_t next = (idx + i) % zbd->nr_zones;
+
+		if (zbd->zone_info[next].type == ZBD_ZONE_TYPE_SWR &&
+		    !zbd_zone_busy(&zbd->zone_info[next], min_bs) &&
+		    zbd_open_zone(zbd, next))
+			return next;
+	}
+
+	return zbd->nr_zones;
+}
+
+static int zbd_adjust_read(struct thread_data *td, struct io_u *io_u,
+			   uint32_t idx)
+{
+	struct zoned_block_device_info *zbd = io_u->file->zbd_info;
+	struct fio_zone_info *z = &zbd->zone_info[idx];
+	unsigned int min_bs = td->o.min_bs[DDIR_READ];
+	uint64_t written, off;
+	uint32_t i;
+
+	if (io_u->offset + io_u->buflen <= z->wp)
+		return 0;
+
+	/*
+	 * Nothing to read here, move on to the next zone holding data
+	 */
+	for (i = 0; i < zbd->nr_zones; i++) {
+		z = &zbd->zone_info[(idx + i) % zbd->nr_zones];
+		if (z->wp - z->start >= min_bs)
+			break;
+	}
+	if (i == zbd->nr_zones) {
+		dprint(FD_IO, "zbd: no data to read\n");
+		return 1;
+	}
+
+	written = z->wp - z->start;
+	if (io_u->buflen > written)
+		io_u->buflen = written - (written % min_bs);
+
+	off = (io_u->offset - z->start) % (written - io_u->buflen + 1);
+	io_u->offset = z->start + off - (off % min_bs);
+	return 0;
+}
+
+/*
+ * Adjust the offset and length of a read or write to the zone state,
+ * resetting the target zone if a write finds it full. Returns non-zero
+ * if there is no valid IO to issue.
+ */
+int zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	struct zoned_block_device_info *zbd = f->zbd_info;
+	unsigned int min_bs = td->o.min_bs[DDIR_WRITE];
+	struct fio_zone_info *z;
+	uint64_t left;
+	uint32_t idx;
+
+	if (!zbd || !ddir_rw(io_u->ddir))
+		return 0;
+
+	idx = io_u->offset / zbd->zone_size - zbd->first_zone;
+	if (idx >= zbd->nr_zones)
+		return 1;
+
+	z = &zbd->zone_info[idx];
+	if (z->type == ZBD_ZONE_TYPE_CNV)
+		return 0;
+
+	if (io_u->ddir == DDIR_READ)
+		return zbd_adjust_read(td, io_u, idx);
+
+	idx = zbd_pick_zone(zbd, idx, min_bs);
+	if (idx == zbd->nr_zones) {
+		dprint(FD_IO, "zbd: all zones are full with writes pending\n");
+		return 1;
+	}
+
+	z = &zbd->zone_info[idx];
+	if (zbd_zone_full(z, min_bs) && zbd_reset_zone(td, f, z))
+		return 1;
+
+	left = z->start + z->capacity - z->reserved;
+	if (io_u->buflen > left)
+		io_u->buflen = left - (left % min_bs);
+
+	io_u->flags |= IO_U_F_ZBD_WRITE;
+	z->pending++;
+
+	if (td->o.zone_append) {
+		/*
+		 * Aim at the zone start, the write pointer at issue time
+		 * decides where the data ends up
+		 */
+		if (z->reserved == z->start)
+			fio_gettime(&z->append_start, NULL);
+		io_u->offset = z->start;
+		io_u->flags |= IO_U_F_ZONE_APPEND;
+		z->reserved += io_u->buflen;
+	} else {
+		io_u->offset = z->reserved;
+		z->reserved += io_u->buflen;
+		z->wp = z->reserved;
+	}
+
+	if (zbd_zone_full(z, min_bs))
+		zbd_close_zone(zbd, idx);
+
+	return 0;
+}
+
+static struct fio_zone_info *zbd_io_zone(struct io_u *io_u)
+{
+	struct zoned_block_device_info *zbd = io_u->file->zbd_info;
+
+	return &zbd->zone_info[io_u->offset / zbd->zone_size -
+				zbd->first_zone];
+}
+
+/*
+ * Place a zone append at the write pointer of its zone. Called when the
+ * write is handed to the engine, which is the order fio issues writes
+ * in; a write that is requeued keeps its place.
+ */
+void zbd_place_io(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_zone_info *z;
+
+	if (io_u->flags & IO_U_F_ZONE_PLACED)
+		return;
+
+	z = zbd_io_zone(io_u);
+	io_u->offset = z->wp;
+	z->wp += io_u->buflen;
+	io_u->flags |= IO_U_F_ZONE_PLACED;
+	z->appends++;
+
+	dprint(FD_IO, "zbd: append placed at %llu\n",
+			(unsigned long long) io_u->offset);
+}
+
+/*
+ * Called when a zone write is done with. Completed appends are logged
+ * for verification now that their offset is known, and a zone that was
+ * filled by appends reports the bandwidth it was filled at.
+ */
+void zbd_put_io(struct thread_data *td, struct io_u *io_u)
+{
+	unsigned int min_bs = td->o.min_bs[DDIR_WRITE];
+	struct fio_zone_info *z;
+	unsigned long usec;
+
+	if (io_u->flags & IO_U_F_ZONE_APPEND) {
+		/*
+		 * Dry runs and writes that never made it to the engine
+		 */
+		zbd_place_io(td, io_u);
+
+		if (!io_u->error && td->o.do_verify &&
+		    td->o.verify != VERIFY_NONE &&
+		    !td->o.experimental_verify) {
+			log_io_piece(td, io_u);
+			io_u->ipo->flags &= ~IP_F_IN_FLIGHT;
+		}
+	}
+
+	z = zbd_io_zone(io_u);
+	assert(z->pending);
+	z->pending--;
+	io_u->flags &= ~(IO_U_F_ZBD_WRITE | IO_U_F_ZONE_APPEND |
+				IO_U_F_ZONE_PLACED);
+
+	if (!td->o.zone_append || z->pending || !zbd_zone_full(z, min_bs) ||
+	    !z->appends)
+		return;
+
+	usec = utime_since_now(&z->append_start);
+	add_zone_append_sample(td, z->appends,
+		usec ? ((z->wp - z->start) >> 10) * 1000000 / usec : 0);
+	z->appends = 0;
+}
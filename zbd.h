@@ -0,0 +1,62 @@
+#ifndef FIO_ZBD_H
+#define FIO_ZBD_H
+
+#include <inttypes.h>
+#include <sys/time.h>
+
+struct thread_data;
+struct fio_file;
+struct io_u;
+
+enum fio_zone_type {
+	ZBD_ZONE_TYPE_CNV	= 1,	/* conventional, random writes */
+	ZBD_ZONE_TYPE_SWR	= 2,	/* sequential write required */
+};
+
+enum fio_zbd_model {
+	ZBD_MODEL_NONE		= 0,	/* zones emulated by fio */
+	ZBD_MODEL_HOST_AWARE,
+	ZBD_MODEL_HOST_MANAGED,
+};
+
+/*
+ * State of one zone. Offsets and sizes are in bytes. Space for a write
+ * is reserved when it is prepared, but with zone_append the write
+ * pointer only moves once the write is issued and placed.
+ */
+struct fio_zone_info {
+	uint64_t start;
+	uint64_t capacity;
+	uint64_t wp;
+	uint64_t reserved;
+	uint32_t type;
+	uint32_t open;
+	uint32_t pending;
+	uint32_t appends;
+	struct timeval append_start;
+};
+
+/*
+ * Zones of a file, kept per job. Only the zones covering the job's
+ * offset/size range are tracked. Open zones are the ones written to
+ * since they were last reset and that are not full yet.
+ */
+struct zoned_block_device_info {
+	enum fio_zbd_model model;
+	uint64_t zone_size;
+	uint32_t first_zone;
+	uint32_t nr_zones;
+	uint32_t max_open_zones;
+	uint32_t nr_open_zones;
+	uint32_t open_rr;
+	uint32_t *open_zones;
+	struct fio_zone_info zone_info[];
+};
+
+extern int zbd_init(struct thread_data *);
+extern void zbd_free_zone_info(struct fio_file *);
+extern int zbd_adjust_block(struct thread_data *, struct io_u *);
+extern void zbd_place_io(struct thread_data *, struct io_u *);
+extern void zbd_put_io(struct thread_data *, struct io_u *);
+
+#endif